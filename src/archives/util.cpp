@@ -22,10 +22,16 @@
  *  General tool utility functions.
  */
 
+#include <cassert>
 #include <cstdio>
 
 #include <vector>
 
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/error.h"
@@ -34,6 +40,7 @@
 #include "src/common/filepath.h"
 #include "src/common/readstream.h"
 #include "src/common/writefile.h"
+#include "src/common/threadpool.h"
 
 #include "src/aurora/util.h"
 #include "src/aurora/archive.h"
@@ -193,28 +200,197 @@ static void dumpStream(Common::SeekableReadStream &stream, const Common::UString
 	file.close();
 }
 
-void extractFiles(const Aurora::Archive &archive, Aurora::GameID game, bool directories,
-                  const std::set<Common::UString> &files) {
+/** Figure out the name of the file to extract a resource to.
+ *
+ *  Returns false if the resource should not be extracted at all.
+ */
+static bool getExtractName(const Aurora::Archive &archive, const Aurora::Archive::Resource &resource,
+                           Aurora::GameID game, bool directories, const std::set<Common::UString> &files,
+                           Common::UString &name) {
 
-	const Aurora::Archive::ResourceList &resources = archive.getResources();
-	const size_t fileCount = resources.size();
+	const Aurora::FileType type = TypeMan.aliasFileType(resource.type, game);
 
-	std::printf("Number of files: %s\n\n", Common::composeString(fileCount).c_str());
+	const Common::UString path     = findPath(resource.name, type, resource.hash, archive.getNameHashAlgo());
+	const Common::UString fileName = Common::FilePath::getFile(path);
+	const Common::UString dirName  = Common::FilePath::getDirectory(path);
 
-	size_t i = 1;
-	for (Aurora::Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r, ++i) {
-		const Aurora::FileType type = TypeMan.aliasFileType(r->type, game);
+	name = directories ? path : fileName;
 
-		const Common::UString path     = findPath(r->name, type, r->hash, archive.getNameHashAlgo());
-		const Common::UString fileName = Common::FilePath::getFile(path);
-		const Common::UString dirName  = Common::FilePath::getDirectory(path);
-		const Common::UString name     = directories ? path : fileName;
+	if (!files.empty() && (files.find(name) == files.end()))
+		return false;
 
-		if (!files.empty() && (files.find(name) == files.end()))
+	if (directories && !dirName.empty())
+		Common::FilePath::createDirectories(dirName);
+
+	return true;
+}
+
+/** A file to be extracted by one of the extraction threads. */
+struct ExtractFile {
+	const Aurora::Archive *archive; ///< The archive to extract the resource from.
+
+	uint32 index;          ///< The index of the resource within the archive.
+	size_t number;         ///< The number of the resource, for the progress output.
+	Common::UString name;  ///< The name of the file to extract the resource to.
+
+	bool superseded;         ///< Is the file overwritten by a later one of the same name anyway?
+
+	bool done;               ///< Was this file processed?
+	bool failed;             ///< Did the extraction fail?
+	Common::Exception error; ///< The reason why the extraction failed.
+
+	ExtractFile(const Aurora::Archive &a, uint32 i, size_t n, const Common::UString &na) :
+		archive(&a), index(i), number(n), name(na), superseded(false), done(false), failed(false) { }
+};
+
+/** The state shared by all extraction threads. */
+struct ExtractContext {
+	std::vector<ExtractFile> files;
+	size_t nextFile;
+
+	boost::mutex mutex;
+	boost::condition_variable fileDone;
+
+	ExtractContext() : nextFile(0) { }
+};
+
+static void setExtractError(Common::Exception &error) {
+	try {
+		throw;
+	} catch (Common::Exception &e) {
+		error = e;
+	} catch (std::exception &e) {
+		error = Common::Exception(e);
+	} catch (...) {
+		error = Common::Exception("Unknown exception caught");
+	}
+}
+
+static void extractThread(ExtractContext &context) {
+	boost::mutex::scoped_lock lock(context.mutex);
+
+	while (context.nextFile < context.files.size()) {
+		ExtractFile &file = context.files[context.nextFile++];
+		if (file.superseded)
 			continue;
 
-		if (directories && !dirName.empty())
-			Common::FilePath::createDirectories(dirName);
+		lock.unlock();
+
+		bool failed = false;
+		Common::Exception error;
+
+		try {
+			/* Archive::getResource() only uses positional reads and can be called concurrently.
+			 * The stream is written out right away, so we don't need our own copy of the data. */
+			Common::ScopedPtr<Common::SeekableReadStream> stream(file.archive->getResource(file.index, true));
+
+			dumpStream(*stream, file.name);
+		} catch (...) {
+			setExtractError(error);
+			failed = true;
+		}
+
+		lock.lock();
+
+		file.done   = true;
+		file.failed = failed;
+		file.error  = error;
+
+		context.fileDone.notify_all();
+	}
+}
+
+static void printArchiveHeader(const std::vector<Common::UString> &headers, size_t archive, size_t fileCount) {
+	if (archive > 0)
+		std::printf("\n");
+
+	std::printf("%sNumber of files: %s\n\n", headers[archive].c_str(), Common::composeString(fileCount).c_str());
+}
+
+static void extractFilesThreaded(const std::vector<const Aurora::Archive *> &archives,
+                                 const std::vector<Common::UString> &headers, Aurora::GameID game,
+                                 bool directories, const std::set<Common::UString> &files, size_t threads) {
+
+	ExtractContext context;
+
+	// Collect the files of all archives into one big queue
+
+	std::vector<size_t> archiveEnd;
+	archiveEnd.reserve(archives.size());
+
+	for (std::vector<const Aurora::Archive *>::const_iterator a = archives.begin(); a != archives.end(); ++a) {
+		const Aurora::Archive::ResourceList &resources = (*a)->getResources();
+
+		size_t i = 1;
+		for (Aurora::Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r, ++i) {
+			Common::UString name;
+			if (getExtractName(**a, *r, game, directories, files, name))
+				context.files.push_back(ExtractFile(**a, r->index, i, name));
+		}
+
+		archiveEnd.push_back(context.files.size());
+	}
+
+	/* Several resources might be extracted to the same file. When extracting
+	 * them one after the other, the last one wins. We keep it that way, and
+	 * skip all earlier ones, so that no two threads ever write the same file. */
+
+	std::set<Common::UString> names;
+	for (std::vector<ExtractFile>::reverse_iterator f = context.files.rbegin(); f != context.files.rend(); ++f) {
+		if (names.insert(f->name).second)
+			continue;
+
+		f->superseded = true;
+		f->done       = true;
+	}
+
+	Common::ThreadPool pool(MAX<size_t>(MIN(threads, context.files.size()), 1));
+	if (!context.files.empty())
+		for (size_t t = 0; t < pool.getThreadCount(); t++)
+			pool.addJob(boost::bind(&extractThread, boost::ref(context)));
+
+	// Print the results in order, as soon as they're available
+
+	std::vector<ExtractFile>::iterator f = context.files.begin();
+	for (size_t a = 0; a < archives.size(); a++) {
+		const size_t fileCount = archives[a]->getResources().size();
+
+		printArchiveHeader(headers, a, fileCount);
+
+		for (; f != (context.files.begin() + archiveEnd[a]); ++f) {
+			boost::mutex::scoped_lock lock(context.mutex);
+
+			while (!f->done)
+				context.fileDone.wait(lock);
+
+			std::printf("Extracting %s/%s: %s ... ", Common::composeString(f->number).c_str(),
+			                                         Common::composeString(fileCount).c_str(),
+			                                         f->name.c_str());
+			std::fflush(stdout);
+
+			if (f->superseded)
+				std::printf("Superseded by a later file of the same name\n");
+			else if (f->failed)
+				Common::printException(f->error, "");
+			else
+				std::printf("Done\n");
+		}
+	}
+
+	pool.wait();
+}
+
+static void extractFilesSerial(const Aurora::Archive &archive, Aurora::GameID game, bool directories,
+                               const std::set<Common::UString> &files) {
+
+	const Aurora::Archive::ResourceList &resources = archive.getResources();
+	const size_t fileCount = resources.size();
+
+	size_t i = 1;
+	for (Aurora::Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r, ++i) {
+		Common::UString name;
+		if (!getExtractName(archive, *r, game, directories, files, name))
+			continue;
 
 		std::printf("Extracting %s/%s: %s ... ", Common::composeString(i).c_str(),
 		                                         Common::composeString(fileCount).c_str(),
@@ -222,7 +398,7 @@ void extractFiles(const Aurora::Archive &archive, Aurora::GameID game, bool dire
 		std::fflush(stdout);
 
 		try {
-			Common::ScopedPtr<Common::SeekableReadStream> stream(archive.getResource(r->index));
+			Common::ScopedPtr<Common::SeekableReadStream> stream(archive.getResource(r->index, true));
 
 			dumpStream(*stream, name);
 
@@ -233,6 +409,34 @@ void extractFiles(const Aurora::Archive &archive, Aurora::GameID game, bool dire
 	}
 }
 
+void extractFiles(const Aurora::Archive &archive, Aurora::GameID game, bool directories,
+                  const std::set<Common::UString> &files, size_t threads) {
+
+	const std::vector<const Aurora::Archive *> archives(1, &archive);
+	const std::vector<Common::UString> headers(1);
+
+	extractFiles(archives, headers, game, directories, files, threads);
+}
+
+void extractFiles(const std::vector<const Aurora::Archive *> &archives,
+                  const std::vector<Common::UString> &headers, Aurora::GameID game,
+                  bool directories, const std::set<Common::UString> &files, size_t threads) {
+
+	assert(archives.size() == headers.size());
+
+	threads = Common::ThreadPool::getThreadCount(threads);
+	if (threads > 1) {
+		extractFilesThreaded(archives, headers, game, directories, files, threads);
+		return;
+	}
+
+	for (size_t a = 0; a < archives.size(); a++) {
+		printArchiveHeader(headers, a, archives[a]->getResources().size());
+
+		extractFilesSerial(*archives[a], game, directories, files);
+	}
+}
+
 void extractFiles(const Aurora::NSBTXFile &nsbtx, const std::set<Common::UString> &files,
                   void (*dumper)(Common::SeekableReadStream &stream, const Common::UString &fileName)) {
 
@@ -26,7 +26,9 @@
 #define ARCHIVES_UTIL_H
 
 #include <set>
+#include <vector>
 
+#include "src/common/types.h"
 #include "src/common/ustring.h"
 
 #include "src/aurora/types.h"
@@ -54,6 +56,10 @@ void listFiles(const Aurora::KEYFile &key, const Common::UString &keyName, Auror
 void listFiles(const Aurora::NSBTXFile &nsbtx);
 
 /** Extract files from an archive.
+ *
+ *  When extracting with more than one thread, all threads share the archive,
+ *  reading, decrypting and decompressing the resources concurrently. The
+ *  progress output stays in the order of the files within the archive.
  *
  *  @param archive The archive to extract from.
  *  @param game The game to alias types with.
@@ -61,9 +67,34 @@ void listFiles(const Aurora::NSBTXFile &nsbtx);
  *         will be written directly into the current directory.
  *  @param files A list of files to extract. If empty, all files from the archive will be
  *         extracted.
+ *  @param threads The number of threads to extract with. 0 means one thread per CPU core.
  */
 void extractFiles(const Aurora::Archive &archive, Aurora::GameID game, bool directories,
-                  const std::set<Common::UString> &files);
+                  const std::set<Common::UString> &files, size_t threads = 1);
+
+/** Extract files from several archives, one after the other.
+ *
+ *  Each archive's progress output is preceded by its header, and
+ *  separated from the previous archive's by an empty line.
+ *
+ *  When extracting with more than one thread, the threads work through
+ *  the files of all archives, so that several archives are extracted
+ *  concurrently. The progress output still stays in order. If several
+ *  files would be extracted to the same name, only the last one is, just
+ *  like when extracting the archives one after the other.
+ *
+ *  @param archives The archives to extract from.
+ *  @param headers For each archive, a text to print before its progress output.
+ *  @param game The game to alias types with.
+ *  @param directories Create directories? If false, directories will be stripped and the file
+ *         will be written directly into the current directory.
+ *  @param files A list of files to extract. If empty, all files from the archives will be
+ *         extracted.
+ *  @param threads The number of threads to extract with. 0 means one thread per CPU core.
+ */
+void extractFiles(const std::vector<const Aurora::Archive *> &archives,
+                  const std::vector<Common::UString> &headers, Aurora::GameID game,
+                  bool directories, const std::set<Common::UString> &files, size_t threads = 1);
 
 /** Extract files from an NSBTX. */
 void extractFiles(const Aurora::NSBTXFile &nsbtx, const std::set<Common::UString> &files,
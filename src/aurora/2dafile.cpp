@@ -27,6 +27,12 @@
  */
 
 #include <cassert>
+#include <cstring>
+
+#include <map>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
 
 #include "src/common/util.h"
 #include "src/common/error.h"
@@ -50,89 +56,291 @@ static const uint32 kVersion2b = MKTAG('V', '2', '.', 'b');
 
 namespace Aurora {
 
-TwoDARow::TwoDARow(TwoDAFile &parent) : _parent(&parent) {
+/** The index of the empty string in the cell string pool. */
+static const uint32 kStringEmpty   = 0;
+/** The index of the "****" string in the cell string pool, marking an empty cell. */
+static const uint32 kStringNoValue = 1;
+
+/** A view into a string of bytes, owned by someone else. */
+struct StringView {
+	const char *data;
+	size_t size;
+
+	StringView() : data(0), size(0) {
+	}
+
+	StringView(const char *d, size_t s) : data(d), size(s) {
+	}
+};
+
+/** Hash a string of bytes, in a way that's compatible between std::string and StringView. */
+struct hashStringBytes {
+	size_t operator()(const std::string &str) const {
+		return boost::hash_range(str.begin(), str.end());
+	}
+
+	size_t operator()(const StringView &str) const {
+		return boost::hash_range(str.data, str.data + str.size);
+	}
+};
+
+/** Compare a StringView with a std::string. */
+struct equalStringBytes {
+	bool operator()(const StringView &str1, const std::string &str2) const {
+		return (str1.size == str2.size()) && (std::memcmp(str1.data, str2.data(), str1.size) == 0);
+	}
+
+	bool operator()(const std::string &str1, const StringView &str2) const {
+		return (*this)(str2, str1);
+	}
+};
+
+/** Collects the unique cell strings of a 2DA while it's being loaded. */
+class TwoDAFile::StringPool : boost::noncopyable {
+public:
+	StringPool(std::vector<Common::UString> &strings) : _strings(strings) {
+		_strings.clear();
+
+		add("");     // kStringEmpty
+		add("****"); // kStringNoValue
+	}
+
+	/** Add a string to the pool, if it's not already in there, and return its index. */
+	uint32 add(const Common::UString &str) {
+		return add(StringView(str.c_str(), std::strlen(str.c_str())));
+	}
+
+	/** Add a string to the pool, if it's not already in there, and return its index. */
+	uint32 add(const StringView &str) {
+		// Look for the string without creating a copy first
+		StringMap::const_iterator string = _map.find(str, hashStringBytes(), equalStringBytes());
+		if (string != _map.end())
+			return string->second;
+
+		const uint32 index = _strings.size();
+
+		_strings.push_back(Common::UString(str.data, str.size));
+		_map.insert(std::make_pair(std::string(str.data, str.size), index));
+
+		return index;
+	}
+
+private:
+	typedef boost::unordered_map<std::string, uint32, hashStringBytes> StringMap;
+
+	std::vector<Common::UString> &_strings;
+	StringMap _map;
+};
+
+/** Splits the contents of an ASCII 2DA file, held in memory, into tokens.
+ *
+ *  This follows the same rules as a Common::StreamTokenizer with the
+ *  rule kRuleIgnoreAll, ' ' and '\t' as separators, '"' as quote,
+ *  '\n' as chunk end and '\r' as ignored character. However, instead of
+ *  reading the stream codepoint by codepoint, it scans the raw bytes
+ *  with a lookup table. Tokens are returned as views into the data.
+ *
+ *  Like the StreamTokenizer, each byte is taken as one codepoint. So
+ *  bytes >= 0x80 are interpreted as Latin-1 and converted to UTF-8.
+ *
+ *  Only tokens with quotes, ignored characters, NULs or non-ASCII bytes in
+ *  them need to be copied. Those views stay valid until the next call to
+ *  getToken().
+ */
+class TwoDAFile::ASCIITokenizer : boost::noncopyable {
+public:
+	ASCIITokenizer(const byte *data, size_t size) :
+		_pos(reinterpret_cast<const char *>(data)), _end(reinterpret_cast<const char *>(data) + size) {
+
+		std::memset(_classes, kClassNormal, sizeof(_classes));
+
+		_classes[(byte) ' ' ] = kClassSeparator;
+		_classes[(byte) '\t'] = kClassSeparator;
+		_classes[(byte) '"' ] = kClassQuote;
+		_classes[(byte) '\n'] = kClassChunkEnd;
+		_classes[(byte) '\r'] = kClassIgnore;
+		_classes[(byte) '\0'] = kClassNUL;
+
+		std::memset(_classes + 0x80, kClassNonASCII, 0x80);
+	}
+
+	/** Have we reached the end of the data? */
+	bool eos() const {
+		return _pos >= _end;
+	}
+
+	/** Are we at the end of a chunk (or the end of the data)? */
+	bool isChunkEnd() const {
+		return (_pos >= _end) || (*_pos == '\n');
+	}
+
+	/** Skip past separators and ignored characters, to the first character of the next token. */
+	void findFirstToken() {
+		while ((_pos < _end) && ((getClass(*_pos) == kClassSeparator) || (getClass(*_pos) == kClassIgnore)))
+			_pos++;
+	}
+
+	/** Move past the end of the current chunk. */
+	void nextChunk() {
+		const char *chunkEnd = static_cast<const char *>(std::memchr(_pos, '\n', _end - _pos));
+
+		_pos = chunkEnd ? (chunkEnd + 1) : _end;
+	}
+
+	/** Parse the next token. */
+	StringView getToken() {
+		const char *start = _pos;
+
+		// Fast path: a run of normal characters
+		while ((_pos < _end) && (getClass(*_pos) == kClassNormal))
+			_pos++;
+
+		if (_pos >= _end)
+			return StringView(start, _pos - start);
+
+		const StringView token(start, _pos - start);
+
+		switch (getClass(*_pos)) {
+			case kClassChunkEnd:
+				return token;
+
+			case kClassSeparator:
+				skipSeparators();
+				return token;
+
+			default:
+				break;
+		}
+
+		// Slow path: quotes, ignored characters, NULs or non-ASCII. We have to copy the token
+		_token.assign(start, _pos - start);
+
+		bool inQuote   = false;
+		bool separator = false;
+
+		while (_pos < _end) {
+			const char c = *_pos++;
+			const CharClass charClass = getClass(c);
+
+			if (charClass == kClassIgnore)
+				continue;
+
+			if (charClass == kClassQuote) {
+				inQuote = !inQuote;
+				continue;
+			}
+
+			if (!inQuote) {
+				if (charClass == kClassChunkEnd) {
+					_pos--;
+					break;
+				}
+
+				if (charClass == kClassSeparator) {
+					separator = true;
+					break;
+				}
+			}
+
+			if (charClass == kClassNonASCII) {
+				_token += (char) (0xC0 | (((byte) c) >> 6));
+				_token += (char) (0x80 | (((byte) c) & 0x3F));
+				continue;
+			}
+
+			_token += c;
+		}
+
+		// Cut off the token at a NUL
+		const size_t nul = _token.find('\0');
+		if (nul != std::string::npos)
+			_token.resize(nul);
+
+		if (separator)
+			skipSeparators();
+
+		return StringView(_token.data(), _token.size());
+	}
+
+private:
+	enum CharClass {
+		kClassNormal,
+		kClassSeparator,
+		kClassQuote,
+		kClassChunkEnd,
+		kClassIgnore,
+		kClassNUL,
+		kClassNonASCII
+	};
+
+	const char *_pos;
+	const char *_end;
+
+	byte _classes[256];
+
+	std::string _token; ///< Buffer for tokens that can't be a direct view.
+
+	CharClass getClass(char c) const {
+		return (CharClass) _classes[(byte) c];
+	}
+
+	void skipSeparators() {
+		while ((_pos < _end) && (getClass(*_pos) == kClassSeparator))
+			_pos++;
+	}
+};
+
+
+TwoDARow::TwoDARow() : _parent(0), _row(SIZE_MAX) {
+}
+
+TwoDARow::TwoDARow(TwoDAFile &parent) : _parent(&parent), _row(SIZE_MAX) {
 }
 
 TwoDARow::~TwoDARow() {
 }
 
 const Common::UString &TwoDARow::getString(size_t column) const {
-	const Common::UString &cell = getCell(column);
-	if (cell.empty() || (cell == "****"))
-		return _parent->_defaultString;
-
-	return cell;
+	return _parent->getString(_row, column);
 }
 
 const Common::UString &TwoDARow::getString(const Common::UString &column) const {
-	const Common::UString &cell = getCell(_parent->headerToColumn(column));
-	if (cell.empty() || (cell == "****"))
-		return _parent->_defaultString;
-
-	return cell;
+	return _parent->getString(_row, _parent->headerToColumn(column));
 }
 
 int32 TwoDARow::getInt(size_t column) const {
-	const Common::UString &cell = getCell(column);
-	if (cell.empty() || (cell == "****"))
-		return _parent->_defaultInt;
-
-	return _parent->parseInt(cell);
+	return _parent->getInt(_row, column);
 }
 
 int32 TwoDARow::getInt(const Common::UString &column) const {
-	const Common::UString &cell = getCell(_parent->headerToColumn(column));
-	if (cell.empty() || (cell == "****"))
-		return _parent->_defaultInt;
-
-	return _parent->parseInt(cell);
+	return _parent->getInt(_row, _parent->headerToColumn(column));
 }
 
 float TwoDARow::getFloat(size_t column) const {
-	const Common::UString &cell = getCell(column);
-	if (cell.empty() || (cell == "****"))
-		return _parent->_defaultFloat;
-
-	return _parent->parseFloat(cell);
+	return _parent->getFloat(_row, column);
 }
 
 float TwoDARow::getFloat(const Common::UString &column) const {
-	const Common::UString &cell = getCell(_parent->headerToColumn(column));
-	if (cell.empty() || (cell == "****"))
-		return _parent->_defaultFloat;
-
-	return _parent->parseFloat(cell);
+	return _parent->getFloat(_row, _parent->headerToColumn(column));
 }
 
 bool TwoDARow::empty(size_t column) const {
-	const Common::UString &cell = getCell(column);
-	if (cell.empty() || (cell == "****"))
-		return true;
-
-	return false;
+	return _parent->empty(_row, column);
 }
 
 bool TwoDARow::empty(const Common::UString &column) const {
-	return empty(_parent->headerToColumn(column));
-}
-
-static const Common::UString kEmpty;
-const Common::UString &TwoDARow::getCell(size_t n) const {
-	if (n >= _data.size())
-		return kEmpty;
-
-	return _data[n];
+	return _parent->empty(_row, _parent->headerToColumn(column));
 }
 
 
 TwoDAFile::TwoDAFile(Common::SeekableReadStream &twoda) :
-	_defaultInt(0), _defaultFloat(0.0f), _emptyRow(*this) {
+	_defaultInt(0), _defaultFloat(0.0f), _rowCount(0), _emptyRow(*this) {
 
 	load(twoda);
 }
 
 TwoDAFile::TwoDAFile(const GDAFile &gda) :
-	_defaultInt(0), _defaultFloat(0.0f), _emptyRow(*this) {
+	_defaultInt(0), _defaultFloat(0.0f), _rowCount(0), _emptyRow(*this) {
 
 	load(gda);
 }
@@ -153,15 +361,19 @@ void TwoDAFile::load(Common::SeekableReadStream &twoda) {
 	Common::readStringLine(twoda, Common::kEncodingASCII);
 
 	try {
+		StringPool pool(_strings);
 
 		if      (_version == kVersion2a)
-			read2a(twoda); // ASCII
+			read2a(twoda, pool); // ASCII
 		else if (_version == kVersion2b)
-			read2b(twoda); // Binary
+			read2b(twoda, pool); // Binary
 
 		// Create the map to quickly translate headers to column indices
 		createHeaderMap();
 
+		createRows();
+		createColumnCaches();
+
 	} catch (Common::Exception &e) {
 		e.add("Failed reading 2DA file");
 		throw;
@@ -169,40 +381,42 @@ void TwoDAFile::load(Common::SeekableReadStream &twoda) {
 
 }
 
-void TwoDAFile::read2a(Common::SeekableReadStream &twoda) {
-	Common::StreamTokenizer tokenize(Common::StreamTokenizer::kRuleIgnoreAll);
+void TwoDAFile::read2a(Common::SeekableReadStream &twoda, StringPool &pool) {
+	// Read the rest of the file into memory, so we can quickly scan over it
 
-	// Spaces and tabs act to separate cells
-	tokenize.addSeparator(' ');
-	tokenize.addSeparator('\t');
-	// We can quote spaces and tabs with "
-	tokenize.addQuote('\"');
-	// \n ends a whole row
-	tokenize.addChunkEnd('\n');
-	// We're ignoring \r
-	tokenize.addIgnore('\r');
+	const size_t size = twoda.size() - twoda.pos();
+
+	Common::ScopedArray<byte> data(new byte[size]);
+	if (twoda.read(data.get(), size) != size)
+		throw Common::Exception(Common::kReadError);
 
-	readDefault2a(twoda, tokenize);
-	readHeaders2a(twoda, tokenize);
-	readRows2a(twoda, tokenize);
+	ASCIITokenizer tokenize(data.get(), size);
+
+	readDefault2a(tokenize);
+	readHeaders2a(tokenize);
+	readRows2a(tokenize, pool);
 }
 
-void TwoDAFile::read2b(Common::SeekableReadStream &twoda) {
+void TwoDAFile::read2b(Common::SeekableReadStream &twoda, StringPool &pool) {
 	readHeaders2b(twoda);
 	skipRowNames2b(twoda);
-	readRows2b(twoda);
+	readRows2b(twoda, pool);
 }
 
-void TwoDAFile::readDefault2a(Common::SeekableReadStream &twoda,
-                              Common::StreamTokenizer &tokenize) {
-
+void TwoDAFile::readDefault2a(ASCIITokenizer &tokenize) {
 	/* ASCII 2DA files can have default values that are returned for cells
 	 * that don't exist. They are specified in the second line, optionally
 	 * preceded by "Default:".
 	 */
 
 	std::vector<Common::UString> defaultRow;
-	tokenize.getTokens(twoda, defaultRow, 2);
+	while (!tokenize.isChunkEnd()) {
+		const StringView token = tokenize.getToken();
+		if (token.size > 0)
+			defaultRow.push_back(Common::UString(token.data, token.size));
+	}
+
+	defaultRow.resize(MAX<size_t>(defaultRow.size(), 2));
 
 	if (defaultRow[0].equalsIgnoreCase("Default:"))
 		_defaultString = defaultRow[1];
@@ -210,48 +424,58 @@ void TwoDAFile::readDefault2a(Common::SeekableReadStream &twoda,
 	_defaultInt   = parseInt(_defaultString);
 	_defaultFloat = parseFloat(_defaultString);
 
-	tokenize.nextChunk(twoda);
+	tokenize.nextChunk();
 }
 
-void TwoDAFile::readHeaders2a(Common::SeekableReadStream &twoda,
-                              Common::StreamTokenizer &tokenize) {
-
+void TwoDAFile::readHeaders2a(ASCIITokenizer &tokenize) {
 	/* Read the column headers of an ASCII 2DA file. */
 
-	while (!twoda.eos() && (tokenize.getTokens(twoda, _headers) == 0))
-		tokenize.nextChunk(twoda);
+	while (!tokenize.eos() && _headers.empty()) {
+		while (!tokenize.isChunkEnd()) {
+			const StringView token = tokenize.getToken();
+			if (token.size > 0)
+				_headers.push_back(Common::UString(token.data, token.size));
+		}
 
-	tokenize.nextChunk(twoda);
+		tokenize.nextChunk();
+	}
 }
 
-void TwoDAFile::readRows2a(Common::SeekableReadStream &twoda,
-                           Common::StreamTokenizer &tokenize) {
-
+void TwoDAFile::readRows2a(ASCIITokenizer &tokenize, StringPool &pool) {
 	/* And now read the individual cells in the rows. */
 
 	const size_t columnCount = _headers.size();
 
-	while (!twoda.eos()) {
-		Common::ScopedPtr<TwoDARow> row(new TwoDARow(*this));
+	_columns.resize(columnCount);
 
+	while (!tokenize.eos()) {
 		/* Skip the first token, which is the row index, possibly indented.
 		 * The row index is implicit in the data and its use in the 2DA
 		 * file is only meant as a guideline for people editing the file by
 		 * hand. It might even be completely incorrect. */
-		tokenize.findFirstToken(twoda);
-		tokenize.skipToken(twoda);
+		tokenize.findFirstToken();
+		tokenize.getToken();
 
 		// Read all the cells in the row
-		size_t count = tokenize.getTokens(twoda, row->_data, columnCount, columnCount, "****");
+		size_t count = 0;
+		while (!tokenize.isChunkEnd() && (count < columnCount)) {
+			const StringView token = tokenize.getToken();
+			if (token.size > 0)
+				_columns[count++].push_back(pool.add(token));
+		}
 
 		// And move to the next line
-		tokenize.nextChunk(twoda);
+		tokenize.nextChunk();
 
 		// Ignore empty lines
 		if (count == 0)
 			continue;
 
-		_rows.push_back(row.release());
+		// Fill up missing cells
+		for (; count < columnCount; count++)
+			_columns[count].push_back(kStringNoValue);
+
+		_rowCount++;
 	}
 }
 
@@ -280,7 +504,7 @@ void TwoDAFile::skipRowNames2b(Common::SeekableReadStream &twoda) {
 	 */
 
 	const uint32 rowCount = twoda.readUint32LE();
-	_rows.resize(rowCount, 0);
+	_rowCount = rowCount;
 
 	Common::StreamTokenizer tokenize(Common::StreamTokenizer::kRuleHeed);
 
@@ -291,7 +515,7 @@ void TwoDAFile::skipRowNames2b(Common::SeekableReadStream &twoda) {
 	tokenize.skipToken(twoda, rowCount);
 }
 
-void TwoDAFile::readRows2b(Common::SeekableReadStream &twoda) {
+void TwoDAFile::readRows2b(Common::SeekableReadStream &twoda, StringPool &pool) {
 	/* And now read the cells. In binary 2DA files, each cell only
 	 * stores a single 16-bit number, the offset into the data segment
 	 * where the data for this cell can be found. Moreover, a single
@@ -300,35 +524,42 @@ void TwoDAFile::readRows2b(Common::SeekableReadStream &twoda) {
 	 */
 
 	const size_t columnCount = _headers.size();
-	const size_t rowCount    = _rows.size();
+	const size_t rowCount    = _rowCount;
 	const size_t cellCount   = columnCount * rowCount;
 
-	Common::ScopedArray<uint32> offsets(new uint32[cellCount]);
+	Common::ScopedArray<uint16> offsets(new uint16[cellCount]);
 
 	Common::StreamTokenizer tokenize(Common::StreamTokenizer::kRuleHeed);
 
 	tokenize.addSeparator('\0');
 
-	for (size_t i = 0; i < cellCount; i++)
-		offsets[i] = twoda.readUint16LE();
+	twoda.readArrayLE(offsets.get(), cellCount);
 
 	twoda.skip(2); // Size of the data segment in bytes
 
 	const size_t dataOffset = twoda.pos();
 
-	for (size_t i = 0; i < rowCount; i++) {
-		_rows[i] = new TwoDARow(*this);
+	// Cells sharing a data offset share a string, so we only need to read each offset once
+	std::map<uint16, uint32> offsetStrings;
 
-		_rows[i]->_data.resize(columnCount);
+	_columns.resize(columnCount);
+	for (size_t j = 0; j < columnCount; j++)
+		_columns[j].reserve(rowCount);
 
+	for (size_t i = 0; i < rowCount; i++) {
 		for (size_t j = 0; j < columnCount; j++) {
-			const size_t offset = dataOffset + offsets[i * columnCount + j];
+			const uint16 offset = offsets[i * columnCount + j];
+
+			std::map<uint16, uint32>::const_iterator string = offsetStrings.find(offset);
+			if (string == offsetStrings.end()) {
+				twoda.seek(dataOffset + offset);
 
-			twoda.seek(offset);
+				const Common::UString cell = tokenize.getToken(twoda);
 
-			_rows[i]->_data[j] = tokenize.getToken(twoda);
-			if (_rows[i]->_data[j].empty())
-				_rows[i]->_data[j] = "****";
+				string = offsetStrings.insert(std::make_pair(offset, pool.add(cell.empty() ? "****" : cell))).first;
+			}
+
+			_columns[j].push_back(string->second);
 		}
 	}
 }
@@ -338,6 +569,22 @@ void TwoDAFile::createHeaderMap() {
 		_headerMap.insert(std::make_pair(_headers[i], i));
 }
 
+void TwoDAFile::createRows() {
+	_rows.reset(new TwoDARow[_rowCount]);
+
+	for (size_t i = 0; i < _rowCount; i++) {
+		_rows[i]._parent = this;
+		_rows[i]._row    = i;
+	}
+}
+
+void TwoDAFile::createColumnCaches() {
+	_columnIndices.resize(_headers.size());
+
+	_intColumns.resize(_columns.size());
+	_floatColumns.resize(_columns.size());
+}
+
 void TwoDAFile::load(const GDAFile &gda) {
 	try {
 
@@ -351,31 +598,37 @@ void TwoDAFile::load(const GDAFile &gda) {
 			_headers[i] = headerString ? headerString : Common::UString::format("[%u]", headers[i].hash);
 		}
 
-		_rows.resize(gda.getRowCount(), 0);
+		StringPool pool(_strings);
+
+		_rowCount = gda.getRowCount();
+
+		_columns.resize(gda.getColumnCount());
+		for (size_t j = 0; j < gda.getColumnCount(); j++)
+			_columns[j].reserve(_rowCount);
+
 		for (size_t i = 0; i < gda.getRowCount(); i++) {
 			const GFF4Struct *row = gda.getRow(i);
 
-			_rows[i] = new TwoDARow(*this);
-			_rows[i]->_data.resize(gda.getColumnCount());
-
 			for (size_t j = 0; j < gda.getColumnCount(); j++) {
+				Common::UString cell;
+
 				if (row) {
 					switch (headers[j].type) {
 						case GDAFile::kTypeString:
 						case GDAFile::kTypeResource:
-							_rows[i]->_data[j] = row->getString(headers[j].field);
+							cell = row->getString(headers[j].field);
 							break;
 
 						case GDAFile::kTypeInt:
-							_rows[i]->_data[j] = Common::UString::format("%d", (int) row->getSint(headers[j].field));
+							cell = Common::UString::format("%d", (int) row->getSint(headers[j].field));
 							break;
 
 						case GDAFile::kTypeFloat:
-							_rows[i]->_data[j] = Common::UString::format("%f", row->getDouble(headers[j].field));
+							cell = Common::UString::format("%f", row->getDouble(headers[j].field));
 							break;
 
 						case GDAFile::kTypeBool:
-							_rows[i]->_data[j] = Common::UString::format("%u", (uint) row->getUint(headers[j].field));
+							cell = Common::UString::format("%u", (uint) row->getUint(headers[j].field));
 							break;
 
 						default:
@@ -383,9 +636,7 @@ void TwoDAFile::load(const GDAFile &gda) {
 					}
 				}
 
-				if (_rows[i]->_data[j].empty())
-					_rows[i]->_data[j] = "****";
-
+				_columns[j].push_back(cell.empty() ? kStringNoValue : pool.add(cell));
 			}
 		}
 
@@ -395,10 +646,12 @@ void TwoDAFile::load(const GDAFile &gda) {
 	}
 
 	createHeaderMap();
+	createRows();
+	createColumnCaches();
 }
 
 size_t TwoDAFile::getRowCount() const {
-	return _rows.size();
+	return _rowCount;
 }
 
 size_t TwoDAFile::getColumnCount() const {
@@ -419,25 +672,204 @@ size_t TwoDAFile::headerToColumn(const Common::UString &header) const {
 }
 
 const TwoDARow &TwoDAFile::getRow(size_t row) const {
-	if ((row >= _rows.size()) || !_rows[row])
+	if (row >= _rowCount)
 		// No such row
 		return _emptyRow;
 
-	return *_rows[row];
+	return _rows[row];
+}
+
+uint32 TwoDAFile::getCellString(size_t row, size_t column) const {
+	if ((row >= _rowCount) || (column >= _columns.size()))
+		return kStringEmpty;
+
+	return _columns[column][row];
+}
+
+const Common::UString &TwoDAFile::getCell(size_t row, size_t column) const {
+	return _strings[getCellString(row, column)];
+}
+
+const Common::UString &TwoDAFile::getString(size_t row, size_t column) const {
+	const uint32 string = getCellString(row, column);
+	if ((string == kStringEmpty) || (string == kStringNoValue))
+		return _defaultString;
+
+	return _strings[string];
+}
+
+int32 TwoDAFile::getInt(size_t row, size_t column) const {
+	if (empty(row, column))
+		return _defaultInt;
+
+	return getIntColumn(column)[row];
+}
+
+float TwoDAFile::getFloat(size_t row, size_t column) const {
+	if (empty(row, column))
+		return _defaultFloat;
+
+	return getFloatColumn(column)[row];
+}
+
+bool TwoDAFile::empty(size_t row, size_t column) const {
+	const uint32 string = getCellString(row, column);
+
+	return (string == kStringEmpty) || (string == kStringNoValue);
+}
+
+const TwoDAFile::IntColumn &TwoDAFile::getIntColumn(size_t column) const {
+	const IntColumn *cached = _intColumns.get(column);
+	if (cached)
+		return *cached;
+
+	boost::mutex::scoped_lock lock(_columnCacheMutex);
+
+	// Another thread might have parsed the column while we were waiting for the lock
+	if ((cached = _intColumns.get(column)))
+		return *cached;
+
+	Common::ScopedPtr<IntColumn> values(new IntColumn(_rowCount, _defaultInt));
+
+	// Parse each distinct string only once
+	std::map<uint32, int32> parsed;
+	for (size_t i = 0; i < _rowCount; i++) {
+		const uint32 string = _columns[column][i];
+		if ((string == kStringEmpty) || (string == kStringNoValue))
+			continue;
+
+		std::map<uint32, int32>::const_iterator value = parsed.find(string);
+		if (value == parsed.end())
+			value = parsed.insert(std::make_pair(string, parseInt(_strings[string]))).first;
+
+		(*values)[i] = value->second;
+	}
+
+	return _intColumns.set(column, values.release());
+}
+
+const TwoDAFile::FloatColumn &TwoDAFile::getFloatColumn(size_t column) const {
+	const FloatColumn *cached = _floatColumns.get(column);
+	if (cached)
+		return *cached;
+
+	boost::mutex::scoped_lock lock(_columnCacheMutex);
+
+	// Another thread might have parsed the column while we were waiting for the lock
+	if ((cached = _floatColumns.get(column)))
+		return *cached;
+
+	Common::ScopedPtr<FloatColumn> values(new FloatColumn(_rowCount, _defaultFloat));
+
+	// Parse each distinct string only once
+	std::map<uint32, float> parsed;
+	for (size_t i = 0; i < _rowCount; i++) {
+		const uint32 string = _columns[column][i];
+		if ((string == kStringEmpty) || (string == kStringNoValue))
+			continue;
+
+		std::map<uint32, float>::const_iterator value = parsed.find(string);
+		if (value == parsed.end())
+			value = parsed.insert(std::make_pair(string, parseFloat(_strings[string]))).first;
+
+		(*values)[i] = value->second;
+	}
+
+	return _floatColumns.set(column, values.release());
 }
 
 const TwoDARow &TwoDAFile::getRow(const Common::UString &header, const Common::UString &value) const {
-	size_t columnIndex = headerToColumn(header);
-	if (columnIndex == kFieldIDInvalid)
-		return _emptyRow;
+	return getRow(findRow(header, value));
+}
+
+static const uint32 kEmptySlot = 0xFFFFFFFF;
+
+/** Hash a cell value case-insensitively, with the bits spread for use as a slot index. */
+static inline size_t hashCell(const Common::UString &value) {
+	uint64 hash = Common::hashUStringCaseInsensitive()(value);
+
+	hash ^= hash >> 33;
+	hash *= UINT64_C(0xFF51AFD7ED558CCD);
+	hash ^= hash >> 33;
+
+	return (size_t) hash;
+}
+
+size_t TwoDAFile::findRow(const Common::UString &header, const Common::UString &value) const {
+	const size_t column = headerToColumn(header);
+	if (column == kFieldIDInvalid)
+		return kFieldIDInvalid;
+
+	return findRow(getColumnIndex(column), column, value);
+}
+
+void TwoDAFile::findRows(const Common::UString &header, const std::vector<Common::UString> &values,
+                         std::vector<size_t> &rows) const {
 
-	for (std::vector<TwoDARow *>::const_iterator row = _rows.begin(); row != _rows.end(); ++row) {
-		if ((*row)->getString(columnIndex).equalsIgnoreCase(value))
-			return **row;
+	rows.clear();
+
+	const size_t column = headerToColumn(header);
+	if (column == kFieldIDInvalid) {
+		rows.resize(values.size(), kFieldIDInvalid);
+		return;
 	}
 
-	// No such row
-	return _emptyRow;
+	const ColumnIndex &index = getColumnIndex(column);
+
+	rows.reserve(values.size());
+	for (std::vector<Common::UString>::const_iterator v = values.begin(); v != values.end(); ++v)
+		rows.push_back(findRow(index, column, *v));
+}
+
+size_t TwoDAFile::findRow(const ColumnIndex &index, size_t column, const Common::UString &value) const {
+	const size_t mask = index.size() - 1;
+
+	for (size_t slot = hashCell(value) & mask; index[slot] != kEmptySlot; slot = (slot + 1) & mask)
+		if (getString(index[slot], column).equalsIgnoreCase(value))
+			return index[slot];
+
+	return kFieldIDInvalid;
+}
+
+const TwoDAFile::ColumnIndex &TwoDAFile::getColumnIndex(size_t column) const {
+	const ColumnIndex *cached = _columnIndices.get(column);
+	if (cached)
+		return *cached;
+
+	boost::mutex::scoped_lock lock(_columnCacheMutex);
+
+	// Another thread might have created the index while we were waiting for the lock
+	if ((cached = _columnIndices.get(column)))
+		return *cached;
+
+	Common::ScopedPtr<ColumnIndex> index(new ColumnIndex);
+	createColumnIndex(column, *index);
+
+	return _columnIndices.set(column, index.release());
+}
+
+void TwoDAFile::createColumnIndex(size_t column, ColumnIndex &index) const {
+	// Keep the load factor at or below 50%
+	size_t slotCount = 16;
+	while (slotCount < (_rowCount * 2))
+		slotCount *= 2;
+
+	const size_t mask = slotCount - 1;
+
+	index.resize(slotCount, kEmptySlot);
+
+	for (size_t i = 0; i < _rowCount; i++) {
+		const Common::UString &value = getString(i, column);
+
+		// Only the first row with a certain value is inserted, to match a linear search
+
+		size_t slot = hashCell(value) & mask;
+		while ((index[slot] != kEmptySlot) && !getString(index[slot], column).equalsIgnoreCase(value))
+			slot = (slot + 1) & mask;
+
+		if (index[slot] == kEmptySlot)
+			index[slot] = i;
+	}
 }
 
 void TwoDAFile::writeASCII(Common::WriteStream &out) const {
@@ -453,16 +885,18 @@ void TwoDAFile::writeASCII(Common::WriteStream &out) const {
 	std::vector<size_t> colLength;
 	colLength.resize(_headers.size() + 1, 0);
 
-	const Common::UString maxRow = Common::UString::format("%d", (int)_rows.size() - 1);
+	const Common::UString maxRow = Common::UString::format("%d", (int)_rowCount - 1);
 	colLength[0] = maxRow.size();
 
 	for (size_t i = 0; i < _headers.size(); i++)
 		colLength[i + 1] = _headers[i].size();
 
-	for (size_t i = 0; i < _rows.size(); i++) {
-		for (size_t j = 0; j < _rows[i]->_data.size(); j++) {
-			const bool   needQuote = _rows[i]->_data[j].contains(' ');
-			const size_t length    = needQuote ? _rows[i]->_data[j].size() + 2 : _rows[i]->_data[j].size();
+	for (size_t j = 0; j < _columns.size(); j++) {
+		for (size_t i = 0; i < _rowCount; i++) {
+			const Common::UString &cell = getCell(i, j);
+
+			const bool   needQuote = cell.contains(' ');
+			const size_t length    = needQuote ? cell.size() + 2 : cell.size();
 
 			colLength[j + 1] = MAX<size_t>(colLength[j + 1], length);
 		}
@@ -479,17 +913,19 @@ void TwoDAFile::writeASCII(Common::WriteStream &out) const {
 
 	// Write array
 
-	for (size_t i = 0; i < _rows.size(); i++) {
+	for (size_t i = 0; i < _rowCount; i++) {
 		out.writeString(Common::UString::format("%*u", (int)colLength[0], (uint)i));
 
-		for (size_t j = 0; j < _rows[i]->_data.size(); j++) {
-			const bool needQuote = _rows[i]->_data[j].contains(' ');
+		for (size_t j = 0; j < _columns.size(); j++) {
+			const Common::UString &cell = getCell(i, j);
+
+			const bool needQuote = cell.contains(' ');
 
 			Common::UString cellString;
 			if (needQuote)
-				cellString = Common::UString::format("\"%s\"", _rows[i]->_data[j].c_str());
+				cellString = Common::UString::format("\"%s\"", cell.c_str());
 			else
-				cellString = _rows[i]->_data[j];
+				cellString = cell;
 
 			out.writeString(Common::UString::format(" %-*s", (int)colLength[j + 1], cellString.c_str()));
 
@@ -514,7 +950,7 @@ bool TwoDAFile::writeASCII(const Common::UString &fileName) const {
 
 void TwoDAFile::writeBinary(Common::WriteStream &out) const {
 	const size_t columnCount = _headers.size();
-	const size_t rowCount    = _rows.size();
+	const size_t rowCount    = _rowCount;
 	const size_t cellCount   = columnCount * rowCount;
 
 	out.writeString("2DA V2.b\n");
@@ -562,10 +998,8 @@ void TwoDAFile::writeBinary(Common::WriteStream &out) const {
 	cells.reserve(cellCount);
 
 	for (size_t i = 0; i < rowCount; i++) {
-		assert(_rows[i]);
-
 		for (size_t j = 0; j < columnCount; j++) {
-			const Common::UString cell = _rows[i]->getString(j);
+			const Common::UString cell = getString(i, j);
 
 			// Do we already know about this cell data string?
 			size_t foundCell = SIZE_MAX;
@@ -640,20 +1074,22 @@ void TwoDAFile::writeCSV(Common::WriteStream &out) const {
 
 	// Write array
 
-	for (size_t i = 0; i < _rows.size(); i++) {
-		for (size_t j = 0; j < _rows[i]->_data.size(); j++) {
-			const bool needQuote = _rows[i]->_data[j].contains(',');
+	for (size_t i = 0; i < _rowCount; i++) {
+		for (size_t j = 0; j < _columns.size(); j++) {
+			const Common::UString &cell = getCell(i, j);
+
+			const bool needQuote = cell.contains(',');
 
 			if (needQuote)
 				out.writeByte('"');
 
-			if (_rows[i]->_data[j] != "****")
-				out.writeString(_rows[i]->_data[j]);
+			if (cell != "****")
+				out.writeString(cell);
 
 			if (needQuote)
 				out.writeByte('"');
 
-			if (j < (_rows[i]->_data.size() - 1))
+			if (j < (_columns.size() - 1))
 				out.writeByte(',');
 		}
 
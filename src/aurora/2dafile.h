@@ -29,10 +29,13 @@
 #include <map>
 
 #include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "src/common/types.h"
 #include "src/common/deallocator.h"
 #include "src/common/ptrvector.h"
+#include "src/common/scopedptr.h"
 #include "src/common/ustring.h"
 
 #include "src/aurora/aurorafile.h"
@@ -40,7 +43,6 @@
 namespace Common {
 	class SeekableReadStream;
 	class WriteStream;
-	class StreamTokenizer;
 }
 
 namespace Aurora {
@@ -83,18 +85,16 @@ public:
 
 private:
 	TwoDAFile *_parent; ///< The parent 2DA.
+	size_t     _row;    ///< The index of this row within the parent 2DA.
 
-	std::vector<Common::UString> _data;
-
+	TwoDARow();
 	TwoDARow(TwoDAFile &parent);
 	~TwoDARow();
 
-	const Common::UString &getCell(size_t n) const;
-
 	friend class TwoDAFile;
 
 	template<typename T>
-	friend void Common::DeallocatorDefault::destroy(T *);
+	friend void Common::DeallocatorArray::destroy(T *);
 };
 
 /** Class to hold the two-dimensional array of a 2DA file.
@@ -120,6 +120,11 @@ private:
  *  be read and modified with a simple text editor. The binary
  *  version cannot.
  *
+ *  Internally, the cells are stored column by column, as indices into
+ *  a pool of unique cell strings. Since 2DAs tend to repeat the same
+ *  few values ("****", "0", "1", ...) over and over, this saves a lot
+ *  of memory and allocations.
+ *
  *  See also classes TwoDARow and TwoDARegistry.
  */
 class TwoDAFile : boost::noncopyable, public AuroraFile {
@@ -143,9 +148,32 @@ public:
 	/** Get a row. */
 	const TwoDARow &getRow(size_t row) const;
 
-	/** Get a row whose value in the column named header is the given string value. */
+	/** Get a row whose value in the column named header is the given string value.
+	 *
+	 *  The values are compared case-insensitively. If several rows match,
+	 *  the first one is returned.
+	 */
 	const TwoDARow &getRow(const Common::UString &header, const Common::UString &value) const;
 
+	/** Find the index of a row whose value in the column named header is the given string value.
+	 *
+	 *  The values are compared case-insensitively. If several rows match,
+	 *  the index of the first one is returned. If none matches, kFieldIDInvalid
+	 *  is returned.
+	 *
+	 *  The first lookup in a column builds a hash index over that column,
+	 *  making every following lookup in that column O(1).
+	 */
+	size_t findRow(const Common::UString &header, const Common::UString &value) const;
+
+	/** Find the indices of the rows whose values in the column named header are the given values.
+	 *
+	 *  Like findRow(), for a whole list of values at once. rows[i] receives
+	 *  the index of the row matching values[i], or kFieldIDInvalid.
+	 */
+	void findRows(const Common::UString &header, const std::vector<Common::UString> &values,
+	              std::vector<size_t> &rows) const;
+
 	// .--- 2DA file writers
 	/** Write the 2DA data into an V2.0 ASCII 2DA. */
 	void writeASCII(Common::WriteStream &out) const;
@@ -173,28 +201,119 @@ private:
 	std::vector<Common::UString> _headers;
 	HeaderMap _headerMap;
 
+	/** All unique cell strings. The first two are always "" and "****". */
+	std::vector<Common::UString> _strings;
+	/** The cells, column by column, as indices into _strings. */
+	std::vector< std::vector<uint32> > _columns;
+
+	size_t _rowCount;
+
 	TwoDARow _emptyRow;
-	Common::PtrVector<TwoDARow> _rows;
+	Common::ScopedArray<TwoDARow> _rows;
+
+	/** An open-addressing hash index over the cells of one column.
+	 *
+	 *  Each slot holds a row index, or 0xFFFFFFFF for an empty slot.
+	 *  The slot count is a power of two.
+	 */
+	typedef std::vector<uint32> ColumnIndex;
+
+	typedef std::vector<int32> IntColumn;
+	typedef std::vector<float> FloatColumn;
+
+	/** Lazily created data of each column, one (or 0) per column.
+	 *
+	 *  Once created, the data of a column never changes again. It is
+	 *  published atomically, so reading it doesn't need any locking.
+	 */
+	template<typename T>
+	class ColumnCache : boost::noncopyable {
+	public:
+		ColumnCache() : _size(0) {
+		}
+
+		~ColumnCache() {
+			for (size_t i = 0; i < _size; i++)
+				delete _data[i].load(boost::memory_order_relaxed);
+		}
+
+		/** Make room for this many columns. Only to be called while loading. */
+		void resize(size_t size) {
+			_data.reset(new boost::atomic<T *>[size]);
+			_size = size;
+
+			for (size_t i = 0; i < _size; i++)
+				_data[i].store(0, boost::memory_order_relaxed);
+		}
+
+		/** Return the data of a column, or 0 if it hasn't been created yet. */
+		const T *get(size_t column) const {
+			return _data[column].load(boost::memory_order_acquire);
+		}
+
+		/** Take over and publish the data of a column, returning it. */
+		const T &set(size_t column, T *data) {
+			_data[column].store(data, boost::memory_order_release);
+
+			return *data;
+		}
+
+	private:
+		Common::ScopedArray< boost::atomic<T *> > _data;
+		size_t _size;
+	};
+
+	/** The lazily created indices of the columns. */
+	mutable ColumnCache<ColumnIndex> _columnIndices;
+
+	/** The lazily parsed int values of the columns. */
+	mutable ColumnCache<IntColumn>   _intColumns;
+	/** The lazily parsed float values of the columns. */
+	mutable ColumnCache<FloatColumn> _floatColumns;
+
+	/** Guards the creation of the column indices and parsed column values. Reading them needs no lock. */
+	mutable boost::mutex _columnCacheMutex;
+
+	class StringPool;
+	class ASCIITokenizer;
 
 	// Loading helpers
 	void load(Common::SeekableReadStream &twoda);
-	void read2a(Common::SeekableReadStream &twoda);
-	void read2b(Common::SeekableReadStream &twoda);
+	void read2a(Common::SeekableReadStream &twoda, StringPool &pool);
+	void read2b(Common::SeekableReadStream &twoda, StringPool &pool);
 
 	// ASCII loading helpers
-	void readDefault2a(Common::SeekableReadStream &twoda, Common::StreamTokenizer &tokenize);
-	void readHeaders2a(Common::SeekableReadStream &twoda, Common::StreamTokenizer &tokenize);
-	void readRows2a   (Common::SeekableReadStream &twoda, Common::StreamTokenizer &tokenize);
+	void readDefault2a(ASCIITokenizer &tokenize);
+	void readHeaders2a(ASCIITokenizer &tokenize);
+	void readRows2a   (ASCIITokenizer &tokenize, StringPool &pool);
 
 	// Binary loading helpers
 	void readHeaders2b (Common::SeekableReadStream &twoda);
 	void skipRowNames2b(Common::SeekableReadStream &twoda);
-	void readRows2b    (Common::SeekableReadStream &twoda);
+	void readRows2b    (Common::SeekableReadStream &twoda, StringPool &pool);
 
 	// GDA loading/conversion helpers
 	void load(const GDAFile &gda);
 
 	void createHeaderMap();
+	void createRows();
+	void createColumnCaches();
+
+	// Cell access helpers for TwoDARow
+	uint32 getCellString(size_t row, size_t column) const;
+	const Common::UString &getCell(size_t row, size_t column) const;
+
+	const Common::UString &getString(size_t row, size_t column) const;
+	int32 getInt(size_t row, size_t column) const;
+	float getFloat(size_t row, size_t column) const;
+	bool empty(size_t row, size_t column) const;
+
+	const IntColumn   &getIntColumn  (size_t column) const;
+	const FloatColumn &getFloatColumn(size_t column) const;
+
+	const ColumnIndex &getColumnIndex(size_t column) const;
+	void createColumnIndex(size_t column, ColumnIndex &index) const;
+	size_t findRow(const ColumnIndex &index, size_t column, const Common::UString &value) const;
 
 	static int32 parseInt(const Common::UString &str);
 	static float parseFloat(const Common::UString &str);
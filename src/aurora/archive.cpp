@@ -22,6 +22,8 @@
  *  Handling various archive files.
  */
 
+#include <boost/functional/hash.hpp>
+
 #include "src/common/system.h"
 
 #include "src/aurora/archive.h"
@@ -31,10 +33,11 @@ namespace Aurora {
 Archive::Resource::Resource() : hash(0), type(kFileTypeNone), index(0xFFFFFFFF) {
 }
 
-Archive::Archive() {
+Archive::Archive() : _resourceIndex(0) {
 }
 
 Archive::~Archive() {
+	delete _resourceIndex.load(boost::memory_order_relaxed);
 }
 
 uint32 Archive::getResourceSize(uint32 UNUSED(index)) const {
@@ -45,21 +48,118 @@ Common::HashAlgo Archive::getNameHashAlgo() const {
 	return Common::kHashNone;
 }
 
+static const uint32 kEmptySlot = 0xFFFFFFFF;
+
+/** Spread the bits of a hash value, so that the lower bits can be used as a slot index. */
+static inline size_t mixHash(uint64 hash) {
+	hash ^= hash >> 33;
+	hash *= UINT64_C(0xFF51AFD7ED558CCD);
+	hash ^= hash >> 33;
+
+	return (size_t) hash;
+}
+
+static inline size_t hashNameType(const Common::UString &name, FileType type) {
+	size_t seed = Common::hashUStringCaseInsensitive()(name);
+	boost::hash_combine<uint32>(seed, (uint32) type);
+
+	return mixHash(seed);
+}
+
+static inline bool isNameTypeMatch(const Archive::Resource &resource, const Common::UString &name, FileType type) {
+	return (resource.type == type) && (resource.name == name);
+}
+
+void Archive::invalidateResourceIndex() {
+	boost::mutex::scoped_lock lock(_resourceIndexMutex);
+
+	delete _resourceIndex.exchange(0, boost::memory_order_acq_rel);
+}
+
+const Archive::ResourceIndex &Archive::getResourceIndex() const {
+	/* Once the index is built, it's never changed again (only thrown away while
+	 * the resource list changes). So lookups can go ahead without locking. The
+	 * acquire here pairs with the release below, making sure we see a fully
+	 * built index. */
+	const ResourceIndex *index = _resourceIndex.load(boost::memory_order_acquire);
+	if (index)
+		return *index;
+
+	boost::mutex::scoped_lock lock(_resourceIndexMutex);
+
+	// Another thread might have built the index while we were waiting for the lock
+	index = _resourceIndex.load(boost::memory_order_acquire);
+	if (index)
+		return *index;
+
+	Common::ScopedPtr<ResourceIndex> newIndex(new ResourceIndex);
+	createResourceIndex(*newIndex);
+
+	_resourceIndex.store(newIndex.get(), boost::memory_order_release);
+
+	return *newIndex.release();
+}
+
+void Archive::createResourceIndex(ResourceIndex &index) const {
+	const ResourceList &resources = getResources();
+
+	// Keep the load factor at or below 50%
+	size_t slotCount = 16;
+	while (slotCount < (resources.size() * 2))
+		slotCount *= 2;
+
+	index.mask = slotCount - 1;
+
+	index.byName.resize(slotCount, kEmptySlot);
+	if (getNameHashAlgo() != Common::kHashNone)
+		index.byHash.resize(slotCount, kEmptySlot);
+
+	for (size_t i = 0; i < resources.size(); i++) {
+		const Resource &resource = resources[i];
+
+		// Only the first resource with a certain key is inserted, to match a linear search
+
+		size_t slot = hashNameType(resource.name, resource.type) & index.mask;
+		while ((index.byName[slot] != kEmptySlot) &&
+		       !isNameTypeMatch(resources[index.byName[slot]], resource.name, resource.type))
+			slot = (slot + 1) & index.mask;
+
+		if (index.byName[slot] == kEmptySlot)
+			index.byName[slot] = i;
+
+		if (index.byHash.empty())
+			continue;
+
+		slot = mixHash(resource.hash) & index.mask;
+		while ((index.byHash[slot] != kEmptySlot) && (resources[index.byHash[slot]].hash != resource.hash))
+			slot = (slot + 1) & index.mask;
+
+		if (index.byHash[slot] == kEmptySlot)
+			index.byHash[slot] = i;
+	}
+}
+
 uint32 Archive::findResource(uint64 hash) const {
 	if (getNameHashAlgo() == Common::kHashNone)
 		return 0xFFFFFFFF;
 
-	for (ResourceList::const_iterator r = getResources().begin(); r != getResources().end(); ++r)
-		if (r->hash == hash)
-			return r->index;
+	const ResourceList  &resources = getResources();
+	const ResourceIndex &index     = getResourceIndex();
+
+	for (size_t slot = mixHash(hash) & index.mask; index.byHash[slot] != kEmptySlot; slot = (slot + 1) & index.mask)
+		if (resources[index.byHash[slot]].hash == hash)
+			return resources[index.byHash[slot]].index;
 
 	return 0xFFFFFFFF;
 }
 
 uint32 Archive::findResource(const Common::UString &name, FileType type) const {
-	for (ResourceList::const_iterator r = getResources().begin(); r != getResources().end(); ++r)
-		if ((r->type == type) && (r->name == name))
-			return r->index;
+	const ResourceList  &resources = getResources();
+	const ResourceIndex &index     = getResourceIndex();
+
+	for (size_t slot = hashNameType(name, type) & index.mask; index.byName[slot] != kEmptySlot; slot = (slot + 1) & index.mask)
+		if (isNameTypeMatch(resources[index.byName[slot]], name, type))
+			return resources[index.byName[slot]].index;
 
 	return 0xFFFFFFFF;
 }
@@ -25,11 +25,14 @@
 #ifndef AURORA_ARCHIVE_H
 #define AURORA_ARCHIVE_H
 
-#include <list>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "src/common/types.h"
+#include "src/common/scopedptr.h"
 #include "src/common/ustring.h"
 #include "src/common/hash.h"
 
@@ -54,7 +57,7 @@ public:
 		Resource();
 	};
 
-	typedef std::list<Resource> ResourceList;
+	typedef std::vector<Resource> ResourceList;
 
 	Archive();
 	virtual ~Archive();
@@ -66,9 +69,19 @@ public:
 	virtual uint32 getResourceSize(uint32 index) const;
 
 	/** Return a stream of the resource's contents.
+	 *
+	 *  The archive is only accessed through positional reads, so it is safe to
+	 *  call this concurrently from several threads, provided the archive's
+	 *  stream supports thread-safe SeekableReadStream::readAt().
+	 *
+	 *  With tryNoCopy, the returned stream references the archive and must not
+	 *  outlive it. If the archive is memory-mapped (see Common::MappedReadFile),
+	 *  that stream points directly into the mapping. Compressed resources are
+	 *  then decompressed on demand while reading, which is cheap when reading
+	 *  front to back, but makes seeking backwards expensive.
 	 *
 	 *  @param  index The index of the resource we want.
-	 *  @param  tryNoCopy Try to return a SeekableSubReadStream of the archive instead of copying.
+	 *  @param  tryNoCopy Try to return a view into the archive instead of copying.
 	 *  @return A (sub)stream of the resource's contents.
 	 */
 	virtual Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const = 0;
@@ -76,10 +89,50 @@ public:
 	/** Return with which algorithm the name is hashed. */
 	virtual Common::HashAlgo getNameHashAlgo() const;
 
-	/** Return the index of the resource matching the hash, or 0xFFFFFFFF if not found. */
+	/** Return the index of the resource matching the hash, or 0xFFFFFFFF if not found.
+	 *
+	 *  If several resources match, the first one in the resource list is returned.
+	 *  The first lookup builds a hash index over the resource list, making every
+	 *  following lookup O(1).
+	 */
 	uint32 findResource(uint64 hash) const;
-	/** Return the index of the resource matching the name and type, or 0xFFFFFFFF if not found. */
+	/** Return the index of the resource matching the name and type, or 0xFFFFFFFF if not found.
+	 *
+	 *  If several resources match, the first one in the resource list is returned.
+	 *  The first lookup builds a hash index over the resource list, making every
+	 *  following lookup O(1).
+	 */
 	uint32 findResource(const Common::UString &name, FileType type) const;
+
+protected:
+	/** Throw away the resource index, because the resource list changed.
+	 *
+	 *  Needs to be called by archive classes that modify their resource list
+	 *  after construction. Must not be called while other threads are looking
+	 *  up resources.
+	 */
+	void invalidateResourceIndex();
+
+private:
+	/** An open-addressing hash index over the resource list.
+	 *
+	 *  Each slot holds the position of a resource within the resource
+	 *  list, or 0xFFFFFFFF for an empty slot.
+	 */
+	struct ResourceIndex {
+		std::vector<uint32> byName; ///< Slots keyed by case-insensitive name and type.
+		std::vector<uint32> byHash; ///< Slots keyed by name hash. Empty if names aren't hashed.
+
+		size_t mask; ///< Slot count minus one. The slot counts are powers of two.
+	};
+
+	/** The resource index, once it has been built. Owned by the archive. */
+	mutable boost::atomic<ResourceIndex *> _resourceIndex;
+	/** Mutex protecting the building of the resource index. Lookups don't need it. */
+	mutable boost::mutex _resourceIndexMutex;
+
+	const ResourceIndex &getResourceIndex() const;
+	void createResourceIndex(ResourceIndex &index) const;
 };
 
 } // End of namespace Aurora
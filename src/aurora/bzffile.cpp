@@ -99,11 +99,13 @@ void BZFFile::readVarResTable(Common::SeekableReadStream &bzf, uint32 offset) {
 }
 
 void BZFFile::mergeKEY(const KEYFile &key, uint32 dataFileIndex) {
-	const KEYFile::ResourceList &keyResList = key.getResources();
+	const KEYFile::ResourceList      &keyResList    = key.getResources();
+	const KEYFile::ResourceIndexList &keyResIndices = key.getBIFResources(dataFileIndex);
 
-	for (KEYFile::ResourceList::const_iterator keyRes = keyResList.begin(); keyRes != keyResList.end(); ++keyRes) {
-		if (keyRes->bifIndex != dataFileIndex)
-			continue;
+	_resources.reserve(_resources.size() + keyResIndices.size());
+
+	for (KEYFile::ResourceIndexList::const_iterator i = keyResIndices.begin(); i != keyResIndices.end(); ++i) {
+		const KEYFile::Resource *keyRes = &keyResList[*i];
 
 		if (keyRes->resIndex >= _iResources.size()) {
 			warning("Resource index out of range (%d/%d)", keyRes->resIndex, (int) _iResources.size());
@@ -123,6 +125,7 @@ void BZFFile::mergeKEY(const KEYFile &key, uint32 dataFileIndex) {
 		_resources.push_back(res);
 	}
 
+	invalidateResourceIndex();
 }
 
 uint32 BZFFile::getInternalResourceCount() const {
@@ -144,12 +147,17 @@ uint32 BZFFile::getResourceSize(uint32 index) const {
 	return getIResource(index).size;
 }
 
-Common::SeekableReadStream *BZFFile::getResource(uint32 index, bool UNUSED(tryNoCopy)) const {
+Common::SeekableReadStream *BZFFile::getResource(uint32 index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	_bzf->seek(res.offset);
+	if (tryNoCopy) {
+		// Decompress directly out of the archive, without reading the whole resource first
+		return new Common::LZMA1ReadStream(_bzf->subStreamAt(res.offset, res.packedSize), res.size, true);
+	}
+
+	Common::ScopedPtr<Common::SeekableReadStream> bzf(_bzf->subStreamAt(res.offset, res.packedSize));
 
-	return Common::decompressLZMA1(*_bzf, res.packedSize, res.size, true);
+	return Common::decompressLZMA1(*bzf, res.packedSize, res.size, true);
 }
 
 } // End of namespace Aurora
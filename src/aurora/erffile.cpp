@@ -27,11 +27,16 @@
  */
 
 #include <cassert>
+#include <cstring>
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "src/common/memreadstream.h"
 #include "src/common/readfile.h"
 #include "src/common/util.h"
 #include "src/common/strutil.h"
+#include "src/common/ptrmap.h"
 #include "src/common/error.h"
 #include "src/common/encoding.h"
 #include "src/common/md5.h"
@@ -52,6 +57,9 @@ static const uint32 kVersion21 = MKTAG('V', '2', '.', '1');
 static const uint32 kVersion22 = MKTAG('V', '2', '.', '2');
 static const uint32 kVersion30 = MKTAG('V', '3', '.', '0');
 
+/** The highest number of description languages a sensible ERF header can have. */
+static const uint32 kMaxLanguageCount = 32;
+
 namespace Aurora {
 
 static const size_t kNWNPremiumKeyLength = 56;
@@ -133,7 +141,7 @@ bool ERFFile::ERFHeader::isSensible(size_t fileSize) {
 	if ((buildYear > 2200) || (buildYear < 2000) || (buildDay > 366))
 		return false;
 
-	if ((resCount >= 131072) || (langCount > 32))
+	if ((resCount >= 131072) || (langCount > kMaxLanguageCount))
 		return false;
 
 	if ((offDescription != 0xFFFFFFFF) && (offDescription > fileSize))
@@ -222,13 +230,57 @@ void ERFFile::verifyPasswordDigest() {
 	throw Common::Exception("Invalid encryption type %u", (uint)_header.encryption);
 }
 
+/** All expanded Blowfish keys for Neverwinter Nights premium modules we've used so far.
+ *
+ *  The key of a premium module is one of the premium keys combined with the
+ *  MD5 of the module's .nwm file, and all HAKs of a module share that MD5. We
+ *  need to try every premium key on each of them, and expanding a Blowfish key
+ *  is expensive, so we keep the expanded keys around for the whole process.
+ */
+static Common::PtrMap<std::vector<byte>, Common::BlowfishKey> nwnPremiumKeyCache;
+static boost::mutex nwnPremiumKeyCacheMutex;
+
+const Common::BlowfishKey &ERFFile::getNWNPremiumKey(const std::vector<byte> &password) {
+	boost::lock_guard<boost::mutex> lock(nwnPremiumKeyCacheMutex);
+
+	Common::PtrMap<std::vector<byte>, Common::BlowfishKey>::iterator k = nwnPremiumKeyCache.find(password);
+	if (k != nwnPremiumKeyCache.end())
+		return *k->second;
+
+	Common::ScopedPtr<Common::BlowfishKey> key(new Common::BlowfishKey(password));
+	nwnPremiumKeyCache.insert(std::make_pair(password, key.get()));
+
+	return *key.release();
+}
+
+bool ERFFile::probeNWNPremiumKey(const Common::SeekableReadStream &erf, size_t headerPos,
+                                 const Common::BlowfishKey &key) {
+
+	/* Decrypt only the first block of the header, which contains the number of
+	 * languages. With a wrong key, that is nearly always far higher than what
+	 * ERFHeader::isSensible() allows, so we can reject most wrong keys without
+	 * decrypting the whole header. */
+
+	byte block[8];
+	if (erf.readAt(headerPos, block, sizeof(block)) != sizeof(block))
+		return false;
+
+	Common::decryptBlowfishEBC(block, sizeof(block), key);
+
+	return READ_LE_UINT32(block) <= kMaxLanguageCount;
+}
+
 bool ERFFile::decryptNWNPremiumHeader(Common::SeekableReadStream &erf, ERFHeader &header,
-                                      const std::vector<byte> &password) {
+                                      const Common::BlowfishKey &key) {
+
+	byte data[152];
+	if (erf.read(data, sizeof(data)) != sizeof(data))
+		throw Common::Exception(Common::kReadError);
 
-	Common::ScopedPtr<Common::SeekableReadStream>
-		decryptERF(decrypt(erf, erf.pos(), 152, kEncryptionBlowfishNWN, password));
+	Common::decryptBlowfishEBC(data, sizeof(data), key);
 
-	readV11Header(*decryptERF, header);
+	Common::MemoryReadStream decryptERF(data);
+	readV11Header(decryptERF, header);
 
 	return header.isSensible(erf.size());
 }
@@ -246,8 +298,12 @@ bool ERFFile::findNWNPremiumKey(Common::SeekableReadStream &erf, ERFHeader &head
 		if (!md5.empty())
 			std::memcpy(&password[0] + kNWNPremiumKeyLength - Common::kMD5Length, &md5[0], Common::kMD5Length);
 
+		const Common::BlowfishKey &key = getNWNPremiumKey(password);
+		if (!probeNWNPremiumKey(erf, headerPos, key))
+			continue;
+
 		erf.seek(headerPos);
-		if (decryptNWNPremiumHeader(erf, header, password))
+		if (decryptNWNPremiumHeader(erf, header, key))
 			return true;
 	}
 
@@ -302,9 +358,10 @@ void ERFFile::load() {
 void ERFFile::decryptNWNPremium() {
 	assert(_header.encryption == kEncryptionBlowfishNWN);
 
-	_erf->seek(0);
-
-	_erf.reset(decrypt(*_erf, kEncryptionBlowfishNWN, _password));
+	/* The whole file is encrypted in EBC mode, so we can decrypt it on demand.
+	 * Only the parts we actually read, like the resource lists and the
+	 * requested resources, are ever decrypted. */
+	_erf.reset(new Common::BlowfishEBCDecryptStream(_erf.release(), getNWNPremiumKey(_password), true));
 
 	_header.encryption = kEncryptionNone;
 }
@@ -712,13 +769,16 @@ uint32 ERFFile::getResourceSize(uint32 index) const {
 Common::SeekableReadStream *ERFFile::getResource(uint32 index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	if (tryNoCopy && (_header.encryption == kEncryptionNone) && (_header.compression == kCompressionNone))
-		return new Common::SeekableSubReadStream(_erf.get(), res.offset, res.offset + res.packedSize);
+	if (tryNoCopy && (_header.encryption == kEncryptionNone)) {
+		if (_header.compression == kCompressionNone)
+			return _erf->subStreamAt(res.offset, res.packedSize);
 
-	_erf->seek(res.offset);
+		// Decompress directly out of the archive, without reading the whole resource first
+		return decompressOnDemand(_erf->subStreamAt(res.offset, res.packedSize), res.unpackedSize);
+	}
 
 	// Read
-	Common::MemoryReadStream *stream = _erf->readStream(res.packedSize);
+	Common::MemoryReadStream *stream = _erf->readStreamAt(res.offset, res.packedSize);
 
 	// Decrypt
 	if (_header.encryption != kEncryptionNone)
@@ -751,18 +811,6 @@ Common::MemoryReadStream *ERFFile::decrypt(Common::SeekableReadStream *cryptStre
 	return decrypt(*stream, encryption, password);
 }
 
-Common::SeekableReadStream *ERFFile::decrypt(Common::SeekableReadStream &erf, size_t pos, size_t size,
-                                             Encryption encryption, const std::vector<byte> &password) {
-
-	return decrypt(new Common::SeekableSubReadStream(&erf, pos, pos + size), encryption, password);
-}
-
-Common::SeekableReadStream *ERFFile::decrypt(Common::SeekableReadStream &erf, size_t size,
-                                             Encryption encryption, const std::vector<byte> &password) {
-
-	return decrypt(erf, erf.pos(), size, encryption, password);
-}
-
 Common::SeekableReadStream *ERFFile::decompress(Common::MemoryReadStream *packedStream,
                                                 uint32 unpackedSize) const {
 
@@ -845,6 +893,38 @@ Common::SeekableReadStream *ERFFile::decompressZlib(const byte *compressedData,
 	return new Common::MemoryReadStream(data, unpackedSize, true);
 }
 
+Common::SeekableReadStream *ERFFile::decompressOnDemand(Common::SeekableReadStream *packedStream,
+                                                        uint32 unpackedSize) const {
+
+	assert(packedStream);
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(packedStream);
+
+	int windowBits = 0;
+
+	switch (_header.compression) {
+		case kCompressionBioWareZlib:
+			// Raw inflate. An extra one byte header specifies the window size
+			windowBits = -(stream->readByte() >> 4);
+			break;
+
+		case kCompressionHeaderlessZlib:
+			// Raw inflate, with the default maximum window size
+			windowBits = Common::kWindowBitsMaxRaw;
+			break;
+
+		case kCompressionStandardZlib:
+			// Inflate with zlib header, with the default maximum window size
+			windowBits = Common::kWindowBitsMax;
+			break;
+
+		default:
+			throw Common::Exception("Invalid ERF compression %u", (uint) _header.compression);
+	}
+
+	return new Common::DeflateReadStream(stream.release(), unpackedSize, windowBits, true);
+}
+
 Common::HashAlgo ERFFile::getNameHashAlgo() const {
 	// Only V3 uses hashing
 	return (_version == kVersion30) ? Common::kHashFNV64 : Common::kHashNone;
@@ -38,6 +38,7 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class BlowfishKey;
 }
 
 namespace Aurora {
@@ -274,13 +275,12 @@ private:
 	static Common::MemoryReadStream *decrypt(Common::SeekableReadStream *cryptStream,
 	                                         Encryption encryption, const std::vector<byte> &password);
 
-	static Common::SeekableReadStream *decrypt(Common::SeekableReadStream &erf, size_t pos, size_t size,
-	                                           Encryption encryption, const std::vector<byte> &password);
-	static Common::SeekableReadStream *decrypt(Common::SeekableReadStream &erf, size_t size,
-	                                           Encryption encryption, const std::vector<byte> &password);
+	static const Common::BlowfishKey &getNWNPremiumKey(const std::vector<byte> &password);
 
+	static bool probeNWNPremiumKey     (const Common::SeekableReadStream &erf, size_t headerPos,
+	                                    const Common::BlowfishKey &key);
 	static bool decryptNWNPremiumHeader(Common::SeekableReadStream &erf, ERFHeader &header,
-	                                    const std::vector<byte> &password);
+	                                    const Common::BlowfishKey &key);
 	static bool findNWNPremiumKey      (Common::SeekableReadStream &erf, ERFHeader &header,
 	                                    const std::vector<byte> &md5, std::vector<byte> &password);
 	static void readNWNPremiumHeader   (Common::SeekableReadStream &erf, ERFHeader &header,
@@ -302,6 +302,10 @@ private:
 
 	Common::SeekableReadStream *decompressZlib(const byte *compressedData, uint32 packedSize,
 	                                           uint32 unpackedSize, int windowBits) const;
+
+	/** Return a stream that decompresses the packed stream on demand. */
+	Common::SeekableReadStream *decompressOnDemand(Common::SeekableReadStream *packedStream,
+	                                               uint32 unpackedSize) const;
 	// '---
 
 	const IResource &getIResource(uint32 index) const;
@@ -22,27 +22,142 @@
  *  Writing BioWare's ERFs (encapsulated resource file).
  */
 
+#include <cstring>
 #include <ctime>
 
+#include <boost/bind.hpp>
+
+#include "src/common/util.h"
+#include "src/common/hash.h"
+#include "src/common/encoding.h"
+#include "src/common/deflate.h"
+#include "src/common/threadpool.h"
+
 #include "src/aurora/erfwriter.h"
+#include "src/aurora/util.h"
 
 namespace Aurora {
 
 static const uint32 kVersion10 = MKTAG('V', '1', '.', '0');
+static const uint32 kVersion20 = MKTAG('V', '2', '.', '0');
+static const uint32 kVersion22 = MKTAG('V', '2', '.', '2');
+static const uint32 kVersion30 = MKTAG('V', '3', '.', '0');
+
+/** The size of the chunks compressed files are split into. */
+static const size_t kChunkSize = 256 * 1024;
+
+/** The number of chunks per thread that may be waiting to be written. */
+static const size_t kMaxPendingChunksPerThread = 4;
+
+ERFWriter::Resource::Resource() : type(kFileTypeNone), nameOffset(0), offset(0), packedSize(0), unpackedSize(0) {
+}
+
+ERFWriter::Chunk::Chunk(uint32 r, bool f) : resource(r), first(f), last(false), done(false), failed(false) {
+}
+
+/** Write a FourCC as used by the UTF-16LE headers of ERF V2.0 and up. */
+static void writeUTF16LETag(Common::WriteStream &stream, uint32 tag) {
+	for (int i = 24; i >= 0; i -= 8)
+		stream.writeUint16LE((tag >> i) & 0xFF);
+}
+
+/** Write the current date as the build year and day. */
+static void writeBuildDate(Common::WriteStream &stream) {
+	std::time_t now = std::time(0);
+	std::tm *timepoint = std::localtime(&now);
+	stream.writeUint32LE(timepoint->tm_year);
+	stream.writeUint32LE(timepoint->tm_yday);
+}
+
+/** Return the header flags of ERF V2.2 and V3.0 for this compression. */
+static uint32 getCompressionFlags(ERFWriter::Compression compression) {
+	switch (compression) {
+		case ERFWriter::kCompressionNone:
+			return 0;
+
+		case ERFWriter::kCompressionBioWareZlib:
+			return 1 << 29;
+
+		case ERFWriter::kCompressionHeaderlessZlib:
+			return 7 << 29;
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Invalid ERF compression %u", (uint) compression);
+}
+
+/** Read as much as fits into a chunk. */
+static void readChunkData(Common::ReadStream &stream, std::vector<byte> &data) {
+	data.resize(kChunkSize);
+
+	size_t size = 0;
+	while (size < kChunkSize) {
+		const size_t n = stream.read(&data[size], kChunkSize - size);
+		if (n == 0)
+			break;
+
+		size += n;
+	}
+
+	data.resize(size);
+}
 
 ERFWriter::ERFWriter(uint32 id, uint32 fileCount, Common::SeekableWriteStream &stream, Version version,
-                     LocString description) : _stream(stream), _currentFileCount(0), _fileCount(fileCount) {
-	if (version != kERFVersion10)
-		throw Common::Exception("Unsupported ERF version");
+                     LocString description, Compression compression, size_t threadCount,
+                     const std::vector<Common::UString> &names) :
+	_stream(stream), _version(version), _compression(compression), _currentFileCount(0), _fileCount(fileCount),
+	_offsetToResourceData(0), _keyTableOffset(0), _resourceTableOffset(0),
+	_stringTableOffset(0), _stringTableSize(0), _stringTableUsed(0) {
+
+	if ((compression != kCompressionNone) && (version != kERFVersion22) && (version != kERFVersion30))
+		throw Common::Exception("This ERF version does not support compression");
+
+	switch (version) {
+		case kERFVersion10:
+			writeV10Header(id, description);
+			break;
+
+		case kERFVersion20:
+			writeV20Header(id);
+			break;
+
+		case kERFVersion22:
+			writeV22Header(id);
+			break;
+
+		case kERFVersion30:
+			writeV30Header(id, names);
+			break;
+
+		default:
+			throw Common::Exception("Unsupported ERF version");
+	}
 
-	stream.writeUint32BE(id);
-	stream.writeUint32BE(kVersion10);
+	_resources.reserve(_fileCount);
+
+	if (compression != kCompressionNone)
+		_pool.reset(new Common::ThreadPool(threadCount));
+}
+
+ERFWriter::~ERFWriter() {
+	// Stop all workers before throwing away the chunks they might still work on
+	_pool.reset();
+
+	for (std::deque<Chunk *>::iterator c = _chunks.begin(); c != _chunks.end(); ++c)
+		delete *c;
+}
+
+void ERFWriter::writeV10Header(uint32 id, const LocString &description) {
+	_stream.writeUint32BE(id);
+	_stream.writeUint32BE(kVersion10);
 
 	// Write Header
-	stream.writeUint32LE(description.getNumStrings()); // Language count
-	stream.writeUint32LE(description.getWrittenSize()); // Localized string size
+	_stream.writeUint32LE(description.getNumStrings()); // Language count
+	_stream.writeUint32LE(description.getWrittenSize()); // Localized string size
 
-	stream.writeUint32LE(_fileCount); // Entry Count
+	_stream.writeUint32LE(_fileCount); // Entry Count
 
 	// The size of the ERF header, which is immediately followed by the LocString table
 	static const uint32 kLocStringTableOffset = 160;
@@ -50,76 +165,353 @@ ERFWriter::ERFWriter(uint32 id, uint32 fileCount, Common::SeekableWriteStream &s
 	_keyTableOffset = kLocStringTableOffset + description.getWrittenSize();
 	_resourceTableOffset = _keyTableOffset + _fileCount * 24;
 
-	stream.writeUint32LE(kLocStringTableOffset); // LocString offset
-	stream.writeUint32LE(_keyTableOffset); // Key List offset
-	stream.writeUint32LE(_resourceTableOffset); // Resource offset
+	_stream.writeUint32LE(kLocStringTableOffset); // LocString offset
+	_stream.writeUint32LE(_keyTableOffset); // Key List offset
+	_stream.writeUint32LE(_resourceTableOffset); // Resource offset
 
 	// Write the creation time of the file
-	std::time_t now = std::time(0);
-	std::tm *timepoint = std::localtime(&now);
-	stream.writeUint32LE(timepoint->tm_year);
-	stream.writeUint32LE(timepoint->tm_yday);
+	writeBuildDate(_stream);
 
 	// Write the description string reference
 	if (description.getNumStrings())
-		stream.writeUint32LE(description.getID());
+		_stream.writeUint32LE(description.getID());
 	else
-		stream.writeUint32LE(0);
+		_stream.writeUint32LE(0);
 
 	// Write 116 bytes of reserved header data
-	stream.writeZeros(116);
+	_stream.writeZeros(116);
 
 	// Write the Localized string table
-	description.writeLocString(stream);
+	description.writeLocString(_stream);
 
 	// Write the empty key list
-	stream.writeZeros(_fileCount * 24);
+	_stream.writeZeros(_fileCount * 24);
 
 	// The offset to the resource table plus the size of the source table
 	_offsetToResourceData = _resourceTableOffset + 8 * _fileCount;
 
 	// Write the empty resource list
-	stream.writeZeros(8 * _fileCount);
+	_stream.writeZeros(8 * _fileCount);
 }
 
-ERFWriter::~ERFWriter() {
+void ERFWriter::writeV20Header(uint32 id) {
+	writeUTF16LETag(_stream, id);
+	writeUTF16LETag(_stream, kVersion20);
+
+	_stream.writeUint32LE(_fileCount);
+	writeBuildDate(_stream);
+	_stream.writeUint32LE(0xFFFFFFFF); // Unknown
+
+	// The resource list always starts at 0x20 in ERF V2.0
+	_resourceTableOffset  = 0x20;
+	_offsetToResourceData = _resourceTableOffset + _fileCount * 72;
+
+	// Write the empty resource list
+	_stream.writeZeros(_fileCount * 72);
+}
+
+void ERFWriter::writeV22Header(uint32 id) {
+	writeUTF16LETag(_stream, id);
+	writeUTF16LETag(_stream, kVersion22);
+
+	_stream.writeUint32LE(_fileCount);
+	writeBuildDate(_stream);
+	_stream.writeUint32LE(0xFFFFFFFF); // Unknown
+
+	_stream.writeUint32LE(getCompressionFlags(_compression));
+	_stream.writeUint32LE(0);  // Module ID
+	_stream.writeZeros(16);    // Password digest
+
+	// The resource list always starts at 0x38 in ERF V2.2
+	_resourceTableOffset  = 0x38;
+	_offsetToResourceData = _resourceTableOffset + _fileCount * 76;
+
+	// Write the empty resource list
+	_stream.writeZeros(_fileCount * 76);
+}
+
+void ERFWriter::writeV30Header(uint32 id, const std::vector<Common::UString> &names) {
+	/* The string table sits between the header and the resource list, so
+	 * we need to know all resource names before we can write anything. */
+	if (names.size() != _fileCount)
+		throw Common::Exception("ERF V3.0 needs all %u file names up front (%u)",
+		                        (uint)_fileCount, (uint)names.size());
+
+	_stringTableOffset = 0x30;
+	_stringTableSize   = 0;
+
+	for (std::vector<Common::UString>::const_iterator n = names.begin(); n != names.end(); ++n)
+		_stringTableSize += std::strlen(n->c_str()) + 1;
+
+	writeUTF16LETag(_stream, id);
+	writeUTF16LETag(_stream, kVersion30);
+
+	_stream.writeUint32LE(_stringTableSize);
+	_stream.writeUint32LE(_fileCount);
+
+	_stream.writeUint32LE(getCompressionFlags(_compression));
+	_stream.writeUint32LE(0);  // Module ID
+	_stream.writeZeros(16);    // Password digest
+
+	// Write the empty string table
+	_stream.writeZeros(_stringTableSize);
+
+	// The resource list always starts after the string table in ERF V3.0
+	_resourceTableOffset  = _stringTableOffset + _stringTableSize;
+	_offsetToResourceData = _resourceTableOffset + _fileCount * 28;
+
+	// Write the empty resource list
+	_stream.writeZeros(_fileCount * 28);
+}
+
+void ERFWriter::writeV30Name(Resource &resource) {
+	const uint32 size = std::strlen(resource.name.c_str()) + 1;
+	if ((_stringTableSize - _stringTableUsed) < size)
+		throw Common::Exception("ERF string table full: file name \"%s\" not given up front",
+		                        resource.name.c_str());
+
+	_stream.seek(_stringTableOffset + _stringTableUsed);
+	_stream.write(resource.name.c_str(), size);
+
+	resource.nameOffset = _stringTableUsed;
+	_stringTableUsed += size;
 }
 
 void ERFWriter::add(const Common::UString &resRef, FileType resType, Common::ReadStream &stream) {
 	if (_currentFileCount == _fileCount)
 		throw Common::Exception("More files added than expected");
 
-	// Write the key table entry
-	_stream.seek(_keyTableOffset + _currentFileCount * 24);
+	const uint32 index = _currentFileCount++;
+
+	_resources.push_back(Resource());
+	Resource &resource = _resources.back();
+
+	if (_version == kERFVersion10) {
+		// Files without a type are put into ERF archives as the generic RES type
+		if (resType == kFileTypeNone)
+			resType = kFileTypeRES;
 
-	// Files without a type are put into ERF archives as the generic RES type
-	if (resType == kFileTypeNone)
-		resType = kFileTypeRES;
+		/* Files with types above this line are not found in ERF archives.
+		 * They have no real numerical type ID usable for ERF archives. */
+		if (resType >= kFileTypeMAXArchive)
+			resType = kFileTypeRES;
 
-	/* Files with types above this line are not found in ERF archives.
-	 * They have no real numerical type ID usable for ERF archives. */
-	if (resType >= kFileTypeMAXArchive)
-		resType = kFileTypeRES;
+		resource.name = resRef;
+		resource.type = resType;
 
-	_stream.write(resRef.c_str(), MIN<size_t>(resRef.size(), 16));
-	_stream.writeZeros(16 - MIN<size_t>(resRef.size(), 16));
-	_stream.writeUint32LE(_currentFileCount);
-	_stream.writeUint16LE(resType);
-	_stream.writeUint16LE(0); // Unused
+		// Write the key table entry
+		_stream.seek(_keyTableOffset + index * 24);
 
-	// Write the actual resource data
+		_stream.write(resRef.c_str(), MIN<size_t>(resRef.size(), 16));
+		_stream.writeZeros(16 - MIN<size_t>(resRef.size(), 16));
+		_stream.writeUint32LE(index);
+		_stream.writeUint16LE(resType);
+		_stream.writeUint16LE(0); // Unused
+
+	} else {
+		// The resource names in later ERF versions include the extension
+		resource.name = TypeMan.addFileType(resRef, resType);
+		resource.type = resType;
+
+		if (_version == kERFVersion30)
+			writeV30Name(resource);
+	}
+
+	if (_compression == kCompressionNone) {
+		writeUncompressed(resource, stream);
+		writeResourceEntry(index);
+	} else
+		addCompressed(index, stream);
+
+	// The archive is complete. Wait for the remaining chunks and write them out
+	if (_pool && (_currentFileCount == _fileCount)) {
+		writeChunks(0);
+		_pool->wait();
+	}
+}
+
+void ERFWriter::writeUncompressed(Resource &resource, Common::ReadStream &stream) {
 	_stream.seek(_offsetToResourceData);
 	const size_t size = _stream.writeStream(stream);
 
-	// Write the resource table entry
-	_stream.seek(_resourceTableOffset + _currentFileCount * 8);
+	resource.offset       = _offsetToResourceData;
+	resource.packedSize   = size;
+	resource.unpackedSize = size;
 
-	_stream.writeUint32LE(_offsetToResourceData);
-	_stream.writeUint32LE(size);
-
-	// Advance data offset and file count
 	_offsetToResourceData += size;
-	_currentFileCount += 1;
+}
+
+void ERFWriter::addCompressed(uint32 resource, Common::ReadStream &stream) {
+	Common::ScopedPtr<Chunk> chunk(new Chunk(resource, true));
+	readChunkData(stream, chunk->data);
+
+	while (true) {
+		_resources[resource].unpackedSize += chunk->data.size();
+
+		// A full chunk might be followed by more data. If not, it's the last one
+		Common::ScopedPtr<Chunk> next;
+		if (chunk->data.size() == kChunkSize) {
+			next.reset(new Chunk(resource, false));
+			readChunkData(stream, next->data);
+
+			if (next->data.empty())
+				next.reset();
+		}
+
+		if (!next) {
+			chunk->last = true;
+			addChunk(chunk.release());
+			break;
+		}
+
+		// Prime the compressor of the next chunk with the end of this chunk
+		next->dictionary.assign(chunk->data.end() - Common::kDeflateDictionarySize, chunk->data.end());
+
+		addChunk(chunk.release());
+		chunk.reset(next.release());
+	}
+}
+
+void ERFWriter::addChunk(Chunk *chunk) {
+	Common::ScopedPtr<Chunk> newChunk(chunk);
+
+	// Write out what's ready. If too much is pending, wait for it, to keep the memory use in check
+	writeChunks(kMaxPendingChunksPerThread * _pool->getThreadCount());
+
+	_chunks.push_back(newChunk.release());
+	_pool->addJob(boost::bind(&ERFWriter::compressChunk, this, chunk));
+}
+
+void ERFWriter::compressChunk(Chunk *chunk) {
+	bool failed = false;
+	Common::Exception error;
+
+	try {
+		const byte *data       = chunk->data.empty()       ? 0 : &chunk->data[0];
+		const byte *dictionary = chunk->dictionary.empty() ? 0 : &chunk->dictionary[0];
+
+		Common::compressDeflateChunk(data, chunk->data.size(), dictionary, chunk->dictionary.size(),
+		                             chunk->last, chunk->packed);
+	} catch (Common::Exception &e) {
+		error = e;
+		failed = true;
+	} catch (std::exception &e) {
+		error = Common::Exception(e);
+		failed = true;
+	} catch (...) {
+		error = Common::Exception("Unknown exception caught");
+		failed = true;
+	}
+
+	// We don't need the uncompressed data anymore
+	std::vector<byte>().swap(chunk->data);
+	std::vector<byte>().swap(chunk->dictionary);
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	chunk->done   = true;
+	chunk->failed = failed;
+	chunk->error  = error;
+
+	_chunkDone.notify_all();
+}
+
+void ERFWriter::writeChunks(size_t maxPending) {
+	while (!_chunks.empty()) {
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+
+			if (!_chunks.front()->done && (_chunks.size() <= maxPending))
+				return;
+
+			while (!_chunks.front()->done)
+				_chunkDone.wait(lock);
+		}
+
+		Common::ScopedPtr<Chunk> chunk(_chunks.front());
+		_chunks.pop_front();
+
+		if (chunk->failed)
+			throw chunk->error;
+
+		writeChunk(*chunk);
+	}
+}
+
+void ERFWriter::writeChunk(const Chunk &chunk) {
+	Resource &resource = _resources[chunk.resource];
+
+	_stream.seek(_offsetToResourceData);
+
+	if (chunk.first) {
+		resource.offset = _offsetToResourceData;
+
+		// The window size is stored in an extra header byte
+		if (_compression == kCompressionBioWareZlib) {
+			_stream.writeByte(Common::kWindowBitsMax << 4);
+
+			resource.packedSize   += 1;
+			_offsetToResourceData += 1;
+		}
+	}
+
+	if (!chunk.packed.empty())
+		_stream.write(&chunk.packed[0], chunk.packed.size());
+
+	resource.packedSize   += chunk.packed.size();
+	_offsetToResourceData += chunk.packed.size();
+
+	if (chunk.last)
+		writeResourceEntry(chunk.resource);
+}
+
+void ERFWriter::writeResourceEntry(uint32 index) {
+	const Resource &resource = _resources[index];
+
+	switch (_version) {
+		case kERFVersion10:
+			_stream.seek(_resourceTableOffset + index * 8);
+
+			_stream.writeUint32LE(resource.offset);
+			_stream.writeUint32LE(resource.packedSize);
+			break;
+
+		case kERFVersion20:
+			_stream.seek(_resourceTableOffset + index * 72);
+
+			Common::writeStringFixed(_stream, resource.name, Common::kEncodingUTF16LE, 64);
+			_stream.writeUint32LE(resource.offset);
+			_stream.writeUint32LE(resource.packedSize);
+			break;
+
+		case kERFVersion22:
+			_stream.seek(_resourceTableOffset + index * 76);
+
+			Common::writeStringFixed(_stream, resource.name, Common::kEncodingUTF16LE, 64);
+			_stream.writeUint32LE(resource.offset);
+			_stream.writeUint32LE(resource.packedSize);
+			_stream.writeUint32LE(resource.unpackedSize);
+			break;
+
+		case kERFVersion30: {
+			Common::UString extension = TypeMan.addFileType("", resource.type);
+			if (extension.beginsWith("."))
+				extension.erase(extension.begin());
+
+			_stream.seek(_resourceTableOffset + index * 28);
+
+			_stream.writeUint32LE(resource.nameOffset);
+			_stream.writeUint64LE(Common::hashString(resource.name.toLower(), Common::kHashFNV64));
+			_stream.writeUint32LE(Common::hashString(extension, Common::kHashFNV32));
+			_stream.writeUint32LE(resource.offset);
+			_stream.writeUint32LE(resource.packedSize);
+			_stream.writeUint32LE(resource.unpackedSize);
+			break;
+		}
+
+		default:
+			break;
+	}
 }
 
 } // End of namespace Aurora
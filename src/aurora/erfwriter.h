@@ -25,19 +25,59 @@
 #ifndef AURORA_ERFWRITER_H
 #define AURORA_ERFWRITER_H
 
+#include <vector>
+#include <deque>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include "src/common/ustring.h"
+#include "src/common/scopedptr.h"
+#include "src/common/error.h"
 #include "src/common/writestream.h"
 #include "src/common/readstream.h"
 
 #include "src/aurora/locstring.h"
 
+namespace Common {
+	class ThreadPool;
+}
+
 namespace Aurora {
 
-class ERFWriter {
+/** Write an ERF archive.
+ *
+ *  The number of files has to be known beforehand, because all ERF versions
+ *  store the resource table directly in front of the resource data. Once the
+ *  last file has been added, the archive is complete.
+ *
+ *  Supported versions:
+ *  - 1.0, with a localized description, but without compression
+ *  - 2.0, without compression
+ *  - 2.2, optionally DEFLATE compressed
+ *  - 3.0, optionally DEFLATE compressed
+ *
+ *  See ERFFile in erffile.h for details on the versions.
+ *
+ *  Compressed files are read and compressed in chunks, so no file is ever
+ *  completely held in memory. The chunks are compressed by a pool of worker
+ *  threads, while the compressed data is written out in order, by the thread
+ *  calling add().
+ */
+class ERFWriter : boost::noncopyable {
 public:
 	enum Version {
-		kERFVersion10
+		kERFVersion10,
+		kERFVersion20,
+		kERFVersion22,
+		kERFVersion30
+	};
 
-		// TODO: Add other versions
+	enum Compression {
+		kCompressionNone,           ///< No compression at all.
+		kCompressionBioWareZlib,    ///< Raw DEFLATE with an extra header byte specifying the window size.
+		kCompressionHeaderlessZlib  ///< Raw DEFLATE.
 	};
 
 	/** Create an ERF writer by writing the header to the stream and reserve fileCount
@@ -48,22 +88,99 @@ public:
 	 *  @param stream The write stream in which the archive should be written.
 	 *  @param version The ERF version to write
 	 *  @param description The LocString, that should be used for the description.
+	 *                     Only ERF V1.0 has a description.
+	 *  @param compression How to compress the files. Only ERF V2.2 and V3.0 support compression.
+	 *  @param threadCount The number of threads to compress with. 0 means one thread per CPU core.
+	 *  @param names The names, including extension, of all files that will be added.
+	 *               Only needed for ERF V3.0, to size the string table.
 	 */
 	ERFWriter(uint32 id, uint32 fileCount, Common::SeekableWriteStream &stream,
-	          Version version = kERFVersion10, LocString description = LocString());
+	          Version version = kERFVersion10, LocString description = LocString(),
+	          Compression compression = kCompressionNone, size_t threadCount = 1,
+	          const std::vector<Common::UString> &names = std::vector<Common::UString>());
 	~ERFWriter();
 
-	/** Add a new stream to this archive to be packed. */
+	/** Add a new stream to this archive to be packed.
+	 *
+	 *  The stream is completely read before add() returns. When adding the
+	 *  last file, add() only returns after the whole archive is written.
+	 */
 	void add(const Common::UString &resRef, FileType resType, Common::ReadStream &stream);
 
 private:
+	/** A resource within the archive. */
+	struct Resource {
+		Common::UString name; ///< The resource's name, including extension for ERF V2.0 and up.
+		FileType type;        ///< The resource's type.
+
+		uint32 nameOffset;    ///< Offset of the name within the string table (ERF V3.0).
+
+		uint32 offset;        ///< The offset of the resource data within the archive.
+		uint32 packedSize;    ///< The size of the resource data within the archive.
+		uint32 unpackedSize;  ///< The size of the uncompressed resource data.
+
+		Resource();
+	};
+
+	/** A chunk of a resource, to be compressed by a worker thread. */
+	struct Chunk {
+		uint32 resource; ///< The index of the resource this chunk belongs to.
+
+		bool first; ///< Is this the first chunk of the resource?
+		bool last;  ///< Is this the last chunk of the resource?
+
+		std::vector<byte> data;       ///< The uncompressed data.
+		std::vector<byte> dictionary; ///< The uncompressed data in front of this chunk.
+		std::vector<byte> packed;     ///< The compressed data.
+
+		bool done;               ///< Was this chunk compressed?
+		bool failed;             ///< Did the compression fail?
+		Common::Exception error; ///< The reason why the compression failed.
+
+		Chunk(uint32 r, bool f);
+	};
+
 	Common::SeekableWriteStream &_stream;
 
+	Version _version;
+	Compression _compression;
+
 	uint32 _currentFileCount;
 	uint32 _fileCount;
 	uint32 _offsetToResourceData;
 	uint32 _keyTableOffset;
 	uint32 _resourceTableOffset;
+
+	uint32 _stringTableOffset; ///< The offset of the string table (ERF V3.0).
+	uint32 _stringTableSize;   ///< The size of the string table (ERF V3.0).
+	uint32 _stringTableUsed;   ///< The size of the string table filled with names (ERF V3.0).
+
+	std::vector<Resource> _resources;
+
+	Common::ScopedPtr<Common::ThreadPool> _pool;
+
+	/** The chunks currently being compressed, in archive order. */
+	std::deque<Chunk *> _chunks;
+
+	boost::mutex _mutex;
+	boost::condition_variable _chunkDone;
+
+	void writeV10Header(uint32 id, const LocString &description);
+	void writeV20Header(uint32 id);
+	void writeV22Header(uint32 id);
+	void writeV30Header(uint32 id, const std::vector<Common::UString> &names);
+
+	void writeV30Name(Resource &resource);
+
+	void writeUncompressed(Resource &resource, Common::ReadStream &stream);
+	void addCompressed(uint32 resource, Common::ReadStream &stream);
+	void addChunk(Chunk *chunk);
+
+	void compressChunk(Chunk *chunk);
+	void writeChunks(size_t maxPending);
+	void writeChunk(const Chunk &chunk);
+
+	void writeResourceEntry(uint32 index);
 };
 
 } // End of namespace Aurora
@@ -27,6 +27,7 @@
  */
 
 #include <cassert>
+#include <algorithm>
 
 #include "src/common/error.h"
 #include "src/common/readstream.h"
@@ -73,77 +74,65 @@ bool GDAFile::hasRow(size_t row) const {
 const GFF4Struct *GDAFile::getRow(size_t row) const {
 	assert(_rowStarts.size() == _rows.size());
 
-	/* To find the correct GFF4 for this row, we go through
-	 * the list of row start indices in reverse, until we
-	 * found one that's not bigger than the row we want.
+	/* To find the correct GFF4 for this row, we look for the
+	 * last row start index that's not bigger than the row we want.
 	 */
 
-	for (ptrdiff_t i = _rowStarts.size() - 1; i >= 0; i--) {
-		if (_rowStarts[i] <= row) {
-			row -= _rowStarts[i];
+	RowStarts::const_iterator start = std::upper_bound(_rowStarts.begin(), _rowStarts.end(), row);
+	if (start == _rowStarts.begin())
+		return 0;
 
-			if (row >= _rows[i]->size())
-				return 0;
+	const size_t i = (--start) - _rowStarts.begin();
 
-			return (*_rows[i])[row];
-		}
-	}
+	row -= _rowStarts[i];
+	if (row >= _rows[i]->size())
+		return 0;
 
-	return 0;
+	return (*_rows[i])[row];
 }
 
 size_t GDAFile::findRow(uint32 id) const {
-	size_t idColumn = findColumn("ID");
-	if (idColumn == kInvalidColumn)
+	RowIDMap::const_iterator r = _rowIDMap.find(id);
+	if (r == _rowIDMap.end())
 		return kInvalidRow;
 
-	// Go through all rows of all GFF4s, and look for the ID
-
-	size_t gff4 = 0;
-	for (size_t i = 0, j = 0; i < _rowCount; i++, j++) {
-		if (j >= _rows[gff4]->size()) {
-			if (++gff4 >= _rows.size())
-				break;
-
-			j = 0;
-		}
-
-		if ((*_rows[gff4])[j] && ((*_rows[gff4])[j]->getUint(idColumn) == id))
-			return i;
-	}
-
-	return kInvalidRow;
+	return r->second;
 }
 
 size_t GDAFile::findColumn(const Common::UString &name) const {
-	ColumnNameMap::const_iterator c = _columnNameMap.find(name);
-	if (c != _columnNameMap.end())
-		return c->second;
-
-	size_t column = findColumn(Common::hashStringCRC32(name.toLower(), Common::kEncodingUTF16LE));
-	_columnNameMap[name] = column;
-
-	return column;
+	return findColumn(Common::hashStringCRC32(name.toLower(), Common::kEncodingUTF16LE));
 }
 
 size_t GDAFile::findColumn(uint32 hash) const {
 	ColumnHashMap::const_iterator c = _columnHashMap.find(hash);
-	if (c != _columnHashMap.end())
-		return c->second;
+	if (c == _columnHashMap.end())
+		return kInvalidColumn;
+
+	return c->second;
+}
 
+void GDAFile::createColumnHashMap() {
 	for (size_t i = 0; i < _columns->size(); i++) {
 		if (!(*_columns)[i])
 			continue;
 
-		if ((*_columns)[i]->getUint(kGFF4G2DAColumnHash) == hash) {
-			_columnHashMap[hash] = kGFF4G2DAColumn1 + i;
-
-			return kGFF4G2DAColumn1 + i;
-		}
+		// If several columns have the same hash, the first one wins
+		_columnHashMap.insert(std::make_pair(_headers[i].hash, (size_t) kGFF4G2DAColumn1 + i));
 	}
+}
 
-	_columnHashMap[hash] = kInvalidColumn;
-	return kInvalidColumn;
+void GDAFile::addRowIDs(const GFF4List &rows, size_t rowStart) {
+	const size_t idColumn = findColumn("ID");
+	if (idColumn == kInvalidColumn)
+		return;
+
+	for (size_t i = 0; i < rows.size(); i++) {
+		if (!rows[i])
+			continue;
+
+		// If several rows have the same ID, the first one wins
+		_rowIDMap.insert(std::make_pair((uint32) rows[i]->getUint(idColumn), rowStart + i));
+	}
 }
 
 const GFF4Struct *GDAFile::getRowColumn(size_t row, uint32 hash, size_t &column) const {
@@ -297,6 +286,9 @@ void GDAFile::load(Common::SeekableReadStream *gda) {
 			_headers[i].field = (uint32) kGFF4G2DAColumn1 + i;
 		}
 
+		createColumnHashMap();
+		addRowIDs(*_rows.back(), _rowStarts.back());
+
 	} catch (Common::Exception &e) {
 		e.add("Failed reading GDA file");
 		throw;
@@ -335,6 +327,8 @@ void GDAFile::add(Common::SeekableReadStream *gda) {
 				                        hash1, (int)type1, hash2, (int)type2);
 		}
 
+		addRowIDs(*_rows.back(), _rowStarts.back());
+
 	} catch (Common::Exception &e) {
 		e.add("Failed adding GDA file");
 		throw;
@@ -26,9 +26,9 @@
 #define AURORA_GDAFILE_H
 
 #include <vector>
-#include <map>
 
 #include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
 
 #include "src/common/ustring.h"
 #include "src/common/ptrvector.h"
@@ -58,6 +58,10 @@ namespace Aurora {
  *  by the Dragon Age games. Within these MGDAs, rows are not anymore
  *  identified by raw row index (since this index is now meaningless),
  *  but by an "ID" column.
+ *
+ *  The column hashes and row IDs are indexed when the GDAs are loaded.
+ *  After that, all lookups are read-only and can safely be done from
+ *  several threads at once. Adding another GDA, however, can not.
  */
 class GDAFile : boost::noncopyable {
 public:
@@ -113,7 +117,10 @@ public:
 	/** Get a row as a GFF4 struct. */
 	const GFF4Struct *getRow(size_t row) const;
 
-	/** Find a row by its ID value. */
+	/** Find a row by its ID value.
+	 *
+	 *  If several rows have the same ID, the first one is returned.
+	 */
 	size_t findRow(uint32 id) const;
 
 	/** Find a column by its name. */
@@ -139,8 +146,8 @@ private:
 	typedef std::vector<Row> Rows;
 	typedef std::vector<size_t> RowStarts;
 
-	typedef std::map<uint32, size_t> ColumnHashMap;
-	typedef std::map<Common::UString, size_t> ColumnNameMap;
+	typedef boost::unordered_map<uint32, size_t> ColumnHashMap;
+	typedef boost::unordered_map<uint32, size_t> RowIDMap;
 
 
 	GFF4s _gff4s;
@@ -154,12 +161,17 @@ private:
 
 	RowStarts _rowStarts;
 
-	mutable ColumnHashMap _columnHashMap;
-	mutable ColumnNameMap _columnNameMap;
+	/** Map of column hashes to GFF4 field indices. */
+	ColumnHashMap _columnHashMap;
+	/** Map of row IDs to row indices. */
+	RowIDMap _rowIDMap;
 
 
 	void load(Common::SeekableReadStream *gda);
 
+	void createColumnHashMap();
+	void addRowIDs(const GFF4List &rows, size_t rowStart);
+
 	Type identifyType(const Columns &columns, const Row &rows, size_t column) const;
 
 	const GFF4Struct *getRowColumn(size_t row, uint32 hash, size_t &column) const;
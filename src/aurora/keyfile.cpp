@@ -80,6 +80,8 @@ void KEYFile::load(Common::SeekableReadStream &key) {
 		_resources.resize(resCount);
 		readResList(key, offResTable);
 
+		createBIFResourceIndex();
+
 	} catch (Common::Exception &e) {
 		e.add("Failed reading KEY file");
 		throw;
@@ -138,6 +140,23 @@ void KEYFile::readResList(Common::SeekableReadStream &key, uint32 offset) {
 	}
 }
 
+void KEYFile::createBIFResourceIndex() {
+	// Count first, so that each bucket is allocated only once
+
+	std::vector<uint32> counts(_bifs.size(), 0);
+	for (ResourceList::const_iterator res = _resources.begin(); res != _resources.end(); ++res)
+		if (res->bifIndex < counts.size())
+			counts[res->bifIndex]++;
+
+	_bifResources.resize(_bifs.size());
+	for (size_t i = 0; i < _bifResources.size(); i++)
+		_bifResources[i].reserve(counts[i]);
+
+	for (size_t i = 0; i < _resources.size(); i++)
+		if (_resources[i].bifIndex < _bifResources.size())
+			_bifResources[_resources[i].bifIndex].push_back(i);
+}
+
 const KEYFile::BIFList &KEYFile::getBIFs() const {
 	return _bifs;
 }
@@ -146,4 +165,13 @@ const KEYFile::ResourceList &KEYFile::getResources() const {
 	return _resources;
 }
 
+const KEYFile::ResourceIndexList &KEYFile::getBIFResources(uint32 bifIndex) const {
+	static const ResourceIndexList kEmptyList;
+
+	if (bifIndex >= _bifResources.size())
+		return kEmptyList;
+
+	return _bifResources[bifIndex];
+}
+
 } // End of namespace Aurora
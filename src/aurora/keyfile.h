@@ -81,6 +81,9 @@ public:
 	typedef std::vector<Resource> ResourceList;
 	typedef std::vector<Common::UString> BIFList;
 
+	/** A list of indices into the ResourceList. */
+	typedef std::vector<uint32> ResourceIndexList;
+
 	KEYFile(Common::SeekableReadStream &key);
 	~KEYFile();
 
@@ -90,14 +93,25 @@ public:
 	/** Return a list of all containing resources. */
 	const ResourceList &getResources() const;
 
+	/** Return the indices of all resources found in the bif with this index.
+	 *
+	 *  The indices are in the same order the resources appear in the ResourceList.
+	 */
+	const ResourceIndexList &getBIFResources(uint32 bifIndex) const;
+
 private:
 	BIFList      _bifs;      ///< All managed bifs.
 	ResourceList _resources; ///< All containing resources.
 
+	/** For each bif, the indices of its resources. */
+	std::vector<ResourceIndexList> _bifResources;
+
 	void load(Common::SeekableReadStream &key);
 
 	void readBIFList(Common::SeekableReadStream &key, uint32 offset);
 	void readResList(Common::SeekableReadStream &key, uint32 offset);
+
+	void createBIFResourceIndex();
 };
 
 } // End of namespace Aurora
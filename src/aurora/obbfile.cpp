@@ -23,6 +23,12 @@
  */
 
 #include <cassert>
+#include <cstring>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/locks.hpp>
 
 #include "src/common/util.h"
 #include "src/common/strutil.h"
@@ -30,16 +36,152 @@
 #include "src/common/error.h"
 #include "src/common/encoding.h"
 #include "src/common/deflate.h"
+#include "src/common/threadpool.h"
 
 #include "src/aurora/obbfile.h"
 #include "src/aurora/util.h"
 
+/** The uncompressed size of a chunk. Only the last chunk of a resource can be shorter. */
+static const size_t kChunkSize = 4096;
+
+/** The minimal number of chunks worth handing to another thread (64KB). */
+static const size_t kMinChunksPerThread = 16;
+
 namespace Aurora {
 
-OBBFile::OBBFile(Common::SeekableReadStream *obb) : _obb(obb) {
+/** A stream decompressing the chunks of an OBB resource on demand.
+ *
+ *  Only the chunk containing the current position is held in memory.
+ *  Chunks whose offset isn't known yet are found by decompressing the
+ *  chunks before them, and once all chunks have been seen, the chunk
+ *  index is handed back to the OBBFile.
+ *
+ *  The stream must not outlive the OBBFile it was created from.
+ */
+class OBBFile::ChunkReadStream : boost::noncopyable, public Common::SeekableReadStream {
+public:
+	ChunkReadStream(const OBBFile &obbFile, uint32 index) : _obbFile(&obbFile), _index(index),
+		_resource(&obbFile.getIResource(index)), _currentChunk(SIZE_MAX), _pos(0), _eos(false) {
+
+		const ChunkIndex *chunkIndex = _obbFile->findChunkIndex(_index);
+		if (chunkIndex)
+			_chunkIndex = *chunkIndex;
+		else
+			_chunkIndex.push_back(_resource->offset);
+	}
+
+	~ChunkReadStream() {
+	}
+
+	bool eos() const {
+		return _eos;
+	}
+
+	size_t pos() const {
+		return _pos;
+	}
+
+	size_t size() const {
+		return _resource->uncompressedSize;
+	}
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin) {
+		const size_t oldPos = _pos;
+		const size_t newPos = evalSeek(offset, whence, _pos, 0, size());
+		if (newPos > size())
+			throw Common::Exception(Common::kSeekError);
+
+		_pos = newPos;
+		_eos = false;
+
+		return oldPos;
+	}
+
+	size_t read(void *dataPtr, size_t dataSize) {
+		if (dataSize > (size() - _pos)) {
+			dataSize = size() - _pos;
+			_eos = true;
+		}
+
+		byte *data = reinterpret_cast<byte *>(dataPtr);
+
+		size_t bytesRead = 0;
+		while (bytesRead < dataSize) {
+			const size_t chunk     = _pos / kChunkSize;
+			const size_t chunkPos  = _pos % kChunkSize;
+			const size_t chunkSize = getChunkSize(*_resource, chunk);
+
+			loadChunk(chunk);
+
+			const size_t n = MIN(dataSize - bytesRead, chunkSize - chunkPos);
+			std::memcpy(data + bytesRead, _chunk + chunkPos, n);
+
+			bytesRead += n;
+			_pos      += n;
+		}
+
+		return bytesRead;
+	}
+
+private:
+	const OBBFile *_obbFile;
+
+	uint32 _index;
+	const IResource *_resource;
+
+	/** The offsets of the chunks found so far. */
+	ChunkIndex _chunkIndex;
+
+	byte _chunk[kChunkSize];
+	size_t _currentChunk;
+
+	size_t _pos;
+	bool _eos;
+
+	void loadChunk(size_t chunk) {
+		if (chunk == _currentChunk)
+			return;
+
+		const Common::SeekableReadStream &obb = *_obbFile->_obb;
+
+		/* We need to know where the chunk ends. If we don't, decompress all
+		 * chunks from the last known one onwards, noting down their offsets. */
+		while (_chunkIndex.size() <= (chunk + 1)) {
+			const size_t nextChunk = _chunkIndex.size() - 1;
+			const size_t offset    = _chunkIndex.back();
+
+			_currentChunk = SIZE_MAX;
+
+			const size_t compressedSize = decompressChunk(obb, offset, obb.size() - offset,
+			                                              _chunk, getChunkSize(*_resource, nextChunk));
+
+			_chunkIndex.push_back(offset + compressedSize);
+			_currentChunk = nextChunk;
+
+			if (_chunkIndex.size() == (getChunkCount(*_resource) + 1))
+				_obbFile->addChunkIndex(_index, new ChunkIndex(_chunkIndex));
+		}
+
+		if (chunk == _currentChunk)
+			return;
+
+		_currentChunk = SIZE_MAX;
+
+		decompressChunk(obb, _chunkIndex[chunk], _chunkIndex[chunk + 1] - _chunkIndex[chunk],
+		                _chunk, getChunkSize(*_resource, chunk));
+
+		_currentChunk = chunk;
+	}
+};
+
+OBBFile::OBBFile(Common::SeekableReadStream *obb, size_t threadCount) : _obb(obb),
+	_threadCount(Common::ThreadPool::getThreadCount(threadCount)) {
+
 	assert(_obb);
 
 	load(*_obb);
+
+	_chunkIndices.resize(_iResources.size(), 0);
 }
 
 OBBFile::~OBBFile() {
@@ -165,7 +307,69 @@ uint32 OBBFile::getResourceSize(uint32 index) const {
 	return getIResource(index).uncompressedSize;
 }
 
-Common::SeekableReadStream *OBBFile::getResource(uint32 index, bool UNUSED(tryNoCopy)) const {
+const OBBFile::ChunkIndex *OBBFile::findChunkIndex(uint32 index) const {
+	boost::lock_guard<boost::mutex> lock(_chunkIndexMutex);
+
+	return _chunkIndices[index];
+}
+
+void OBBFile::addChunkIndex(uint32 index, ChunkIndex *chunkIndex) const {
+	Common::ScopedPtr<ChunkIndex> newIndex(chunkIndex);
+
+	boost::lock_guard<boost::mutex> lock(_chunkIndexMutex);
+
+	// Another thread might have been faster. Both indices are the same, though
+	if (!_chunkIndices[index])
+		_chunkIndices[index] = newIndex.release();
+}
+
+size_t OBBFile::getChunkCount(const IResource &res) {
+	return (res.uncompressedSize + kChunkSize - 1) / kChunkSize;
+}
+
+size_t OBBFile::getChunkSize(const IResource &res, size_t chunk) {
+	return MIN<size_t>(res.uncompressedSize - chunk * kChunkSize, kChunkSize);
+}
+
+size_t OBBFile::decompressChunk(const Common::SeekableReadStream &obb, size_t offset,
+                                size_t compressedSize, byte *data, size_t size) {
+
+	Common::ScopedPtr<Common::SeekableReadStream> chunk(obb.subStreamAt(offset, compressedSize));
+
+	const size_t bytesChunk =
+		Common::decompressDeflateChunk(*chunk, Common::kWindowBitsMax, data, size, kChunkSize);
+
+	if (bytesChunk != size)
+		throw Common::Exception("Invalid OBB chunk size (%u != %u)", (uint)bytesChunk, (uint)size);
+
+	return chunk->pos();
+}
+
+void OBBFile::decompressIndexing(const IResource &res, byte *data, ChunkIndex &chunkIndex) const {
+	const size_t chunkCount = getChunkCount(res);
+
+	chunkIndex.reserve(chunkCount + 1);
+	chunkIndex.push_back(res.offset);
+
+	for (size_t i = 0; i < chunkCount; i++) {
+		const size_t offset = chunkIndex.back();
+
+		const size_t compressedSize = decompressChunk(*_obb, offset, _obb->size() - offset,
+		                                              data + i * kChunkSize, getChunkSize(res, i));
+
+		chunkIndex.push_back(offset + compressedSize);
+	}
+}
+
+void OBBFile::decompressChunks(const IResource &res, const ChunkIndex &chunkIndex, byte *data,
+                               size_t firstChunk, size_t lastChunk) const {
+
+	for (size_t i = firstChunk; i < lastChunk; i++)
+		decompressChunk(*_obb, chunkIndex[i], chunkIndex[i + 1] - chunkIndex[i],
+		                data + i * kChunkSize, getChunkSize(res, i));
+}
+
+Common::SeekableReadStream *OBBFile::getResource(uint32 index, bool tryNoCopy) const {
 	/* Decompress a single file.
 	 *
 	 * Files in OBB virtual filesystems are split up in zlib compressed chunks.
@@ -175,7 +379,9 @@ Common::SeekableReadStream *OBBFile::getResource(uint32 index, bool UNUSED(tryNo
 	 * Since we know the starting offset of the first chunk of the file, and
 	 * the uncompressed data size, we simple decompress one chunk after the
 	 * other, starting with the first of the file. Once we have decompressed
-	 * as many bytes as the uncompressed size, we know we're done.
+	 * as many bytes as the uncompressed size, we know we're done. On the way,
+	 * we note down where each chunk starts, so that the next time, we can
+	 * decompress the chunks independently of each other.
 	 *
 	 * The OBB virtual filesystem also has a chunk list and extra 16 bytes of
 	 * meta data at the end of the last compressed chunk, but we don't really
@@ -191,22 +397,45 @@ Common::SeekableReadStream *OBBFile::getResource(uint32 index, bool UNUSED(tryNo
 
 	const IResource &res = getIResource(index);
 
-	_obb->seek(res.offset);
+	if (tryNoCopy)
+		return new ChunkReadStream(*this, index);
 
 	Common::ScopedArray<byte> data(new byte[res.uncompressedSize]);
 
-	size_t offset = 0;
-	size_t bytesLeft = res.uncompressedSize;
+	const ChunkIndex *chunkIndex = findChunkIndex(index);
+	if (!chunkIndex) {
+		Common::ScopedPtr<ChunkIndex> newIndex(new ChunkIndex);
 
-	while (bytesLeft > 0) {
-		const size_t bytesChunk =
-			Common::decompressDeflateChunk(*_obb, Common::kWindowBitsMax,
-			                               data.get() + offset, bytesLeft, 4096);
+		decompressIndexing(res, data.get(), *newIndex);
+		addChunkIndex(index, newIndex.release());
 
-		offset    += bytesChunk;
-		bytesLeft -= bytesChunk;
+		return new Common::MemoryReadStream(data.release(), res.uncompressedSize, true);
 	}
 
+	const size_t chunkCount  = getChunkCount(res);
+	const size_t threadCount = MIN(_threadCount, chunkCount / kMinChunksPerThread);
+
+	if (threadCount <= 1) {
+		decompressChunks(res, *chunkIndex, data.get(), 0, chunkCount);
+
+		return new Common::MemoryReadStream(data.release(), res.uncompressedSize, true);
+	}
+
+	/* Chunk indices are complete when they are added, and are never changed
+	 * or removed afterwards. So we can safely hand this one to other threads. */
+
+	Common::ThreadPool pool(threadCount);
+
+	for (size_t i = 0; i < threadCount; i++) {
+		const size_t firstChunk = (chunkCount *  i     ) / threadCount;
+		const size_t lastChunk  = (chunkCount * (i + 1)) / threadCount;
+
+		pool.addJob(boost::bind(&OBBFile::decompressChunks, this, boost::cref(res),
+		                        boost::cref(*chunkIndex), data.get(), firstChunk, lastChunk));
+	}
+
+	pool.wait();
+
 	return new Common::MemoryReadStream(data.release(), res.uncompressedSize, true);
 }
 
@@ -27,8 +27,11 @@
 
 #include <vector>
 
+#include <boost/thread/mutex.hpp>
+
 #include "src/common/types.h"
 #include "src/common/scopedptr.h"
+#include "src/common/ptrvector.h"
 
 #include "src/aurora/types.h"
 #include "src/aurora/archive.h"
@@ -49,14 +52,25 @@ namespace Aurora {
  *  This class treats OBB files like an archive, allowing easy
  *  access to the files within.
  *
+ *  Each file is split into independently compressed chunks. The first
+ *  time a resource is decompressed, the offsets of its chunks are noted
+ *  down. Afterwards, the chunks of large resources can be decompressed
+ *  in parallel, and a stream requested with tryNoCopy only decompresses
+ *  the chunks that are actually read.
+ *
  *  TODO: Check if the OBB virtual filesystem is also used in Aspyr's
  *  ports of the Knights of the Old Republic games. Also, is it maybe
  *  also used for the iOS ports?
  */
 class OBBFile : public Archive {
 public:
-	/** Take over this stream and read an OBB file out of it. */
-	OBBFile(Common::SeekableReadStream *obb);
+	/** Take over this stream and read an OBB file out of it.
+	 *
+	 *  @param obb The stream to read the OBB file out of.
+	 *  @param threadCount The number of threads to decompress large resources with.
+	 *                     0 means one thread per CPU core.
+	 */
+	OBBFile(Common::SeekableReadStream *obb, size_t threadCount = 1);
 	~OBBFile();
 
 	/** Return the list of resources. */
@@ -65,10 +79,17 @@ public:
 	/** Return the size of a resource. */
 	uint32 getResourceSize(uint32 index) const;
 
-	/** Return a stream of the resource's contents. */
+	/** Return a stream of the resource's contents.
+	 *
+	 *  With tryNoCopy, the returned stream decompresses the resource on demand,
+	 *  only ever holding a single chunk in memory. Otherwise, the whole resource
+	 *  is decompressed at once.
+	 */
 	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
 
 private:
+	class ChunkReadStream;
+
 	/** Internal resource information. */
 	struct IResource {
 		uint32 offset;           ///< The offset of the resource within the OBB.
@@ -78,20 +99,59 @@ private:
 
 	typedef std::vector<IResource> IResourceList;
 
+	/** The offsets of all compressed chunks of a resource, plus the offset right after the last chunk. */
+	typedef std::vector<uint32> ChunkIndex;
+	typedef Common::PtrVector<ChunkIndex> ChunkIndexList;
+
 	Common::ScopedPtr<Common::SeekableReadStream> _obb;
 
+	size_t _threadCount;
+
 	/** External list of resource names and types. */
 	ResourceList _resources;
 
 	/** Internal list of resource offsets and sizes. */
 	IResourceList _iResources;
 
+	/** The chunk indices of all resources decompressed so far. */
+	mutable ChunkIndexList _chunkIndices;
+	/** Mutex protecting the chunk indices. */
+	mutable boost::mutex _chunkIndexMutex;
+
 	void load(Common::SeekableReadStream &obb);
 	void readResList(Common::SeekableReadStream &index);
 
 	Common::SeekableReadStream *getIndex(Common::SeekableReadStream &obb);
 
 	const IResource &getIResource(uint32 index) const;
+
+	/** Return the chunk index of a resource, or 0 if it's not yet known. */
+	const ChunkIndex *findChunkIndex(uint32 index) const;
+	/** Take over the complete chunk index of a resource, unless one is already known. */
+	void addChunkIndex(uint32 index, ChunkIndex *chunkIndex) const;
+
+	/** Decompress the resource from the start, noting down the offsets of its chunks. */
+	void decompressIndexing(const IResource &res, byte *data, ChunkIndex &chunkIndex) const;
+	/** Decompress a range of chunks of a resource, with a known chunk index. */
+	void decompressChunks(const IResource &res, const ChunkIndex &chunkIndex, byte *data,
+	                      size_t firstChunk, size_t lastChunk) const;
+
+	/** Return the number of chunks a resource is split into. */
+	static size_t getChunkCount(const IResource &res);
+	/** Return the uncompressed size of a chunk of a resource. */
+	static size_t getChunkSize(const IResource &res, size_t chunk);
+
+	/** Decompress a single chunk of a resource.
+	 *
+	 *  @param obb The OBB to read the chunk from.
+	 *  @param offset The offset of the compressed chunk within the OBB.
+	 *  @param compressedSize The compressed size of the chunk. May be larger than the actual size.
+	 *  @param data The buffer to decompress the chunk into.
+	 *  @param size The uncompressed size of the chunk.
+	 *  @return The actual compressed size of the chunk.
+	 */
+	static size_t decompressChunk(const Common::SeekableReadStream &obb, size_t offset,
+	                              size_t compressedSize, byte *data, size_t size);
 };
 
 } // End of namespace Aurora
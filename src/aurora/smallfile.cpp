@@ -22,7 +22,12 @@
  *  Decompressing "small" files, Nintendo DS LZSS (types 0x00 and 0x10), found in Sonic.
  */
 
+#include <algorithm>
+
+#include <boost/noncopyable.hpp>
+
 #include "src/common/scopedptr.h"
+#include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
 #include "src/common/memwritestream.h"
@@ -118,59 +123,127 @@ static void decompress10(Common::ReadStream &small, Common::WriteStream &out, ui
 		throw Common::Exception("Invalid \"small\" data");
 }
 
-/** Determine the maximum size of an LZSS-compressed block.
+static const size_t kLZ10MinLength       = 3;      ///< Shortest copy the format supports.
+static const size_t kLZ10MaxLength       = 0x12;   ///< Longest copy the format supports.
+static const size_t kLZ10WindowSize      = 0x1000; ///< Largest displacement the format supports.
+static const size_t kLZ10MinDisplacement = 2;      ///< Smallest displacement we use.
+
+/** Finds earlier occurrences of data for the LZSS 0x10 compression.
  *
- *  Since this function supports continuously copying bytes from the "edge"
- *  of the current compression pointer (which is the main difference between
- *  LZSS and vanilla LZ77), both newPtr and oldPtr need to point into the
- *  same memory region.
+ *  All positions within the window are kept in hash chains, keyed by the
+ *  first kLZ10MinLength bytes found there. Looking for a match only needs to
+ *  check the positions on the chain of the current data, instead of the
+ *  whole window.
  *
- *  Takes O(newLength * oldLength) = O(n^2) time.
+ *  Since LZSS can continuously copy bytes from the "edge" of the current
+ *  compression pointer, a match may overlap the data it's copied to.
  *
- *  @param  newPtr The start of the data that needs to be compressed.
- *  @param  newLength The number of bytes that still need to be compressed.
- *  @param  oldPtr The start of the raw file.
- *  @param  oldLength The number of bytes already compressed.
- *  @param  displacement The offset of the start of the longest block to refer to.
- *  @param  minDisplacement The minimum allowed value for a valid displacement.
- *  @return The length of the longest sequence of bytes that can be copied from oldPtr.
+ *  We never use a displacement of 1, so that the data can also be decompressed
+ *  by decoders that write 16 bits at a time (like into the NDS VRAM).
  */
-size_t getOccurrenceLength(const byte *newPtr, size_t newLength,
-                           const byte *oldPtr, size_t oldLength,
-                           size_t &displacement, size_t minDisplacement = 1) {
-	displacement = 0;
-
-	// Can we actually do anything with the data?
-	if ((minDisplacement > oldLength) || (newLength == 0))
-		return 0;
-
-	size_t maxLength = 0;
-	for (size_t i = 0; i < oldLength - minDisplacement; i++) {
-		/* Try out every single possible displacement value, from the
-		 * start of the old data to the end. */
-
-		const byte *currentOldPtr = oldPtr + i;
-		size_t currentLength = 0;
-
-		/* Determine the length we can copy if we go back (oldLength - i) bytes.
-		 *  Always check the next newLength bytes, because we do LZSS. */
-		for (size_t j = 0; j < newLength; j++, currentLength++)
-			if (currentOldPtr[j] != newPtr[j])
+class LZ10MatchFinder : boost::noncopyable {
+public:
+	/** Find matches within data.
+	 *
+	 *  @param data The complete data to compress.
+	 *  @param size The size of the data in bytes.
+	 *  @param maxChainLength The maximum number of candidates to check for each match.
+	 */
+	LZ10MatchFinder(const byte *data, size_t size, size_t maxChainLength) :
+		_data(data), _size(size), _maxChainLength(maxChainLength), _inserted(0) {
+
+		std::fill(_head, _head + kHashSize, (uint32) kNone);
+		std::fill(_prev, _prev + kLZ10WindowSize, (uint32) kNone);
+	}
+
+	/** Find the longest earlier occurrence of the data at this position.
+	 *
+	 *  Positions have to be queried in ascending order.
+	 *
+	 *  @param  pos The position of the data that needs to be compressed.
+	 *  @param  displacement How far back from pos the occurrence starts.
+	 *  @return The length of the occurrence, 0 if there's none.
+	 */
+	size_t find(size_t pos, size_t &displacement) {
+		// Add all the data before the position to the chains
+		while (_inserted < pos)
+			insert(_inserted++);
+
+		displacement = 0;
+
+		const size_t maxLength = MIN<size_t>(_size - pos, kLZ10MaxLength);
+		if (maxLength < kLZ10MinLength)
+			return 0;
+
+		const byte *newPtr = _data + pos;
+
+		size_t bestLength = 0;
+
+		// Go through the candidates, newest to oldest
+		uint32 candidate = _head[hash(newPtr)];
+		for (size_t i = 0; (i < _maxChainLength) && (candidate != kNone); i++) {
+			const size_t distance = pos - candidate;
+			if (distance > kLZ10WindowSize)
 				break;
 
-		if (currentLength > maxLength) {
-			// We've bettered our last try
-			maxLength = currentLength;
-			displacement = oldLength - i;
+			if (distance >= kLZ10MinDisplacement) {
+				const byte *oldPtr = _data + candidate;
 
-			// If we can't get any better than that, stop
-			if (maxLength == newLength)
-				break;
+				size_t length = 0;
+				while ((length < maxLength) && (oldPtr[length] == newPtr[length]))
+					length++;
+
+				if (length > bestLength) {
+					bestLength   = length;
+					displacement = distance;
+
+					// If we can't get any better than that, stop
+					if (bestLength == maxLength)
+						break;
+				}
+			}
+
+			candidate = _prev[candidate % kLZ10WindowSize];
 		}
+
+		return (bestLength >= kLZ10MinLength) ? bestLength : 0;
 	}
 
-	return maxLength;
-}
+private:
+	static const size_t kHashBits = 13;
+	static const size_t kHashSize = 1 << kHashBits;
+
+	static const uint32 kNone = 0xFFFFFFFF;
+
+	const byte *_data;
+	size_t _size;
+
+	size_t _maxChainLength;
+
+	/** All positions before this one are in the chains. */
+	size_t _inserted;
+
+	/** The newest position for each hash. */
+	uint32 _head[kHashSize];
+	/** For each position in the window, the next older position with the same hash. */
+	uint32 _prev[kLZ10WindowSize];
+
+	static uint32 hash(const byte *data) {
+		const uint32 value = (data[0] << 16) | (data[1] << 8) | data[2];
+
+		return (value * 2654435761U) >> (32 - kHashBits);
+	}
+
+	void insert(size_t pos) {
+		if ((_size - pos) < kLZ10MinLength)
+			return;
+
+		const uint32 h = hash(_data + pos);
+
+		_prev[pos % kLZ10WindowSize] = _head[h];
+		_head[h] = pos;
+	}
+};
 
 /* Simple LZSS 0x10 compression.
  *
@@ -179,15 +252,32 @@ size_t getOccurrenceLength(const byte *newPtr, size_t newLength,
  * See <https://github.com/gravgun/dsdecmp/blob/master/CSharp/DSDecmp/Formats/Nitro/LZ10.cs#L249>
  * and <https://code.google.com/p/dsdecmp/>.
  */
-static void compress10(Common::ReadStream &in, Common::WriteStream &small, uint32 size) {
+static void compress10(Common::ReadStream &in, Common::WriteStream &small, uint32 size,
+                       Small::Level level) {
+
 	Common::ScopedArray<byte> inBuffer(new byte[size]);
 	if (in.read(inBuffer.get(), size) != size)
 		throw Common::Exception(Common::kReadError);
 
+	/* The faster levels check fewer candidates for each match. The better levels
+	 * also do lazy matching: before using a match, they check whether starting
+	 * one byte later would find a longer one. If so, they encode the current byte
+	 * literally and use the longer match instead. */
+
+	const size_t maxChainLength = (level == Small::kLevelFast)   ?  16 :
+	                              (level == Small::kLevelNormal) ? 128 : kLZ10WindowSize;
+	const bool   lazy           = level != Small::kLevelFast;
+
+	Common::ScopedPtr<LZ10MatchFinder> finder(new LZ10MatchFinder(inBuffer.get(), size, maxChainLength));
+
 	// Buffer for 8 blocks (max. 2 bytes each), plus their flags byte
 	byte outBuffer[8 * 2 + 1] = { 0 };
 	size_t bufferedBlocks = 0, bufferLength = 1;
 
+	// A match we already found for the current position while looking ahead
+	bool   haveNext = false;
+	size_t nextLength = 0, nextDisplacement = 0;
+
 	size_t inRead = 0;
 	while (inRead < size) {
 		// If 8 blocks have been buffered, write them and reset the buffer
@@ -207,21 +297,30 @@ static void compress10(Common::ReadStream &in, Common::WriteStream &small, uint3
 		 * format supports) of the already compressed data, but only check the next
 		 * 0x12 bytes (the maximum copy length). */
 
-		const size_t newLength = MIN<size_t>(size - inRead, 0x12);
-		const size_t oldLength = MIN<size_t>(inRead, 0x1000);
+		size_t displacement = 0, length = 0;
+		if (haveNext) {
+			length       = nextLength;
+			displacement = nextDisplacement;
+		} else
+			length = finder->find(inRead, displacement);
+
+		haveNext = false;
 
-		size_t displacement = 0;
-		const size_t length =
-			getOccurrenceLength(inBuffer.get() + inRead            , newLength,
-			                    inBuffer.get() + inRead - oldLength, oldLength,
-			                    displacement);
+		if (lazy && (length > 0) && (length < kLZ10MaxLength)) {
+			nextLength = finder->find(inRead + 1, nextDisplacement);
+			haveNext   = true;
+
+			if (nextLength > length)
+				length = 0;
+		}
 
-		/* If the length of the occurrence is at least 3 bytes, we safe space by
-		 * referring to the earlier place in the data. If it's shorter (or even
-		 * non-existent), then just encode the next byte literally. */
+		/* If we found an occurrence (of at least 3 bytes), we safe space by
+		 * referring to the earlier place in the data. Otherwise, just encode
+		 * the next byte literally. */
 
-		if (length >= 3) {
-			inRead += length;
+		if (length > 0) {
+			inRead  += length;
+			haveNext = false;
 
 			// Mark the block as compressed
 			outBuffer[0] |= 1 << (7 - bufferedBlocks);
@@ -325,13 +424,13 @@ void Small::compress00(Common::SeekableReadStream &in, Common::WriteStream &smal
 	::Aurora::compress00(in, small, size);
 }
 
-void Small::compress10(Common::SeekableReadStream &in, Common::WriteStream &small) {
+void Small::compress10(Common::SeekableReadStream &in, Common::WriteStream &small, Level level) {
 	const size_t size = in.size() - in.pos();
 	if (size >= 0xFFFFFF)
 		throw Common::Exception("Small::compress10(): Input stream too large");
 
 	writeSmallHeader(small, 0x10, size);
-	::Aurora::compress10(in, small, size);
+	::Aurora::compress10(in, small, size, level);
 }
 
 } // End of namespace Aurora
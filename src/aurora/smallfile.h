@@ -35,6 +35,13 @@ namespace Aurora {
 
 class Small {
 public:
+	/** How hard compress10() tries to find repeated data. */
+	enum Level {
+		kLevelFast,   ///< Check few candidates, greedily. Fastest, but compresses worst.
+		kLevelNormal, ///< Check a good number of candidates, with lazy matching.
+		kLevelBest    ///< Check all candidates, with lazy matching. Slowest, but compresses best.
+	};
+
 	static void decompress(Common::ReadStream &small, Common::WriteStream &out);
 
 	/** Decompress this stream into a new SeekableReadStream. */
@@ -59,8 +66,12 @@ public:
 	 *
 	 *  Note that, depending on the input data, the result may be bigger
 	 *  that the input stream.
+	 *
+	 *  The level trades compression speed for compression ratio. The
+	 *  result can always be decompressed the same way.
 	 */
-	static void compress10(Common::SeekableReadStream &in, Common::WriteStream &small);
+	static void compress10(Common::SeekableReadStream &in, Common::WriteStream &small,
+	                       Level level = kLevelNormal);
 };
 
 } // End of namespace Aurora
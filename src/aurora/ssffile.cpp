@@ -139,8 +139,8 @@ void SSFFile::readEntriesNWN(Common::SeekableReadStream &ssf, size_t soundFileLe
 
 	offsets.resize(count);
 
-	for (size_t i = 0; i < count; i++)
-		offsets[i] = ssf.readUint32LE();
+	if (count > 0)
+		ssf.readArrayLE(&offsets[0], count);
 
 	for (size_t i = 0; i < count; i++) {
 		ssf.seek(offsets[i]);
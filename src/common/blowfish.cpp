@@ -23,11 +23,16 @@
  */
 
 #include <cassert>
+#include <cstring>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
 
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/scopedptr.h"
 #include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
 #include "src/common/blowfish.h"
 
 namespace Common {
@@ -244,7 +249,7 @@ static uint32 F(const BlowfishContext &ctx, uint32 x) {
 	return ((ctx.S[0][a] + ctx.S[1][b]) ^ ctx.S[2][c]) + ctx.S[3][d];
 }
 
-static void blowfishEnc(BlowfishContext &ctx, uint32 &xl, uint32 &xr) {
+static void blowfishEnc(const BlowfishContext &ctx, uint32 &xl, uint32 &xr) {
 	for (size_t i = 0; i < kRoundCount; i++) {
 		xl = xl ^ ctx.P[i];
 		xr = F(ctx, xl) ^ xr;
@@ -258,7 +263,7 @@ static void blowfishEnc(BlowfishContext &ctx, uint32 &xl, uint32 &xr) {
 	xl = xl ^ ctx.P[kRoundCount + 1];
 }
 
-static void blowfishDec(BlowfishContext &ctx, uint32 &xl, uint32 &xr) {
+static void blowfishDec(const BlowfishContext &ctx, uint32 &xl, uint32 &xr) {
 	for (size_t i = kRoundCount + 1; i > 1; i--) {
 		xl = xl ^ ctx.P[i];
 		xr = F(ctx, xl) ^ xr;
@@ -314,7 +319,7 @@ static void blowfishSetKey(BlowfishContext &ctx, const byte *key, size_t keyLeng
 	}
 }
 
-static void blowfishECB(BlowfishContext &ctx, Mode mode, const byte *input, byte *output) {
+static void blowfishECB(const BlowfishContext &ctx, Mode mode, const byte *input, byte *output) {
 	uint32 X0 = READ_BE_UINT32(input);
 	uint32 X1 = READ_BE_UINT32(input + 4);
 
@@ -335,47 +340,311 @@ static void blowfishECB(BlowfishContext &ctx, Mode mode, const byte *input, byte
 }
 // '--- Blowfish, based on the implementation from mbed TLS ---'
 
-MemoryReadStream *blowfishEBC(SeekableReadStream &input, const std::vector<byte> &key, Mode mode) {
-	BlowfishContext ctx;
+/** The number of blocks that are encrypted/decrypted in lockstep. */
+static const size_t kInterleave = 2;
+
+/** Encrypt several blocks at once, interleaving their rounds.
+ *
+ *  The blocks don't depend on each other, so the CPU can work on the S-box
+ *  lookups of all of them in parallel, instead of waiting for each round of
+ *  a single block to finish. Two rounds are done per step, so that the halves
+ *  don't need to be swapped.
+ */
+static void blowfishEncInterleaved(const BlowfishContext &ctx, uint32 *xl, uint32 *xr) {
+	uint32 l[kInterleave], r[kInterleave];
+	for (size_t j = 0; j < kInterleave; j++) {
+		l[j] = xl[j];
+		r[j] = xr[j];
+	}
+
+	for (size_t i = 0; i < kRoundCount; i += 2) {
+		for (size_t j = 0; j < kInterleave; j++) {
+			l[j] ^= ctx.P[i];
+			r[j] ^= F(ctx, l[j]);
+		}
+
+		for (size_t j = 0; j < kInterleave; j++) {
+			r[j] ^= ctx.P[i + 1];
+			l[j] ^= F(ctx, r[j]);
+		}
+	}
+
+	for (size_t j = 0; j < kInterleave; j++) {
+		xl[j] = r[j] ^ ctx.P[kRoundCount + 1];
+		xr[j] = l[j] ^ ctx.P[kRoundCount];
+	}
+}
+
+/** Decrypt several blocks at once, interleaving their rounds. */
+static void blowfishDecInterleaved(const BlowfishContext &ctx, uint32 *xl, uint32 *xr) {
+	uint32 l[kInterleave], r[kInterleave];
+	for (size_t j = 0; j < kInterleave; j++) {
+		l[j] = xl[j];
+		r[j] = xr[j];
+	}
+
+	for (size_t i = kRoundCount + 1; i > 1; i -= 2) {
+		for (size_t j = 0; j < kInterleave; j++) {
+			l[j] ^= ctx.P[i];
+			r[j] ^= F(ctx, l[j]);
+		}
+
+		for (size_t j = 0; j < kInterleave; j++) {
+			r[j] ^= ctx.P[i - 1];
+			l[j] ^= F(ctx, r[j]);
+		}
+	}
+
+	for (size_t j = 0; j < kInterleave; j++) {
+		xl[j] = r[j] ^ ctx.P[0];
+		xr[j] = l[j] ^ ctx.P[1];
+	}
+}
+
+/** Encrypt/decrypt a buffer of whole blocks in place. */
+static void blowfishECBBlocks(const BlowfishContext &ctx, Mode mode, byte *data, size_t size) {
+	assert((size % kBlockSize) == 0);
+
+	static const size_t kGroupSize = kInterleave * kBlockSize;
+
+	byte * const end = data + size - (size % kGroupSize);
+	for ( ; data < end; data += kGroupSize) {
+		uint32 xl[kInterleave], xr[kInterleave];
+
+		for (size_t j = 0; j < kInterleave; j++) {
+			xl[j] = READ_BE_UINT32(data + j * kBlockSize);
+			xr[j] = READ_BE_UINT32(data + j * kBlockSize + 4);
+		}
+
+		if (mode == kModeEncrypt)
+			blowfishEncInterleaved(ctx, xl, xr);
+		else
+			blowfishDecInterleaved(ctx, xl, xr);
 
-	blowfishSetKey(ctx, &key[0], key.size());
+		for (size_t j = 0; j < kInterleave; j++) {
+			WRITE_BE_UINT32(data + j * kBlockSize    , xl[j]);
+			WRITE_BE_UINT32(data + j * kBlockSize + 4, xr[j]);
+		}
+	}
+
+	for (size_t i = 0; i < (size % kGroupSize); i += kBlockSize)
+		blowfishECB(ctx, mode, data + i, data + i);
+}
 
-	size_t inputSize = input.size() - input.pos();
+/** Encrypt/decrypt a buffer of whole blocks in place, splitting large buffers across threads. */
+static void blowfishECBBlocksParallel(const BlowfishContext &ctx, Mode mode, byte *data, size_t size,
+                                      size_t threadCount) {
+
+	// Don't bother with threads for small buffers
+	static const size_t kMinChunkSize = 64 * 1024;
+
+	threadCount = ThreadPool::getThreadCount(threadCount);
+	threadCount = MIN(threadCount, size / kMinChunkSize);
+
+	if (threadCount <= 1) {
+		blowfishECBBlocks(ctx, mode, data, size);
+		return;
+	}
+
+	// Evenly sized chunks, each a multiple of the block size
+	const size_t blockCount = size / kBlockSize;
+	const size_t chunkSize  = ((blockCount + threadCount - 1) / threadCount) * kBlockSize;
+
+	ThreadPool pool(threadCount);
+	for (size_t offset = 0; offset < size; offset += chunkSize)
+		pool.addJob(boost::bind(&blowfishECBBlocks, boost::cref(ctx), mode,
+		                        data + offset, MIN(chunkSize, size - offset)));
+
+	pool.wait();
+}
+
+static MemoryReadStream *blowfishEBC(SeekableReadStream &input, const BlowfishContext &ctx, Mode mode) {
+	const size_t inputSize = input.size() - input.pos();
 
 	// Round up to the next multiple of the block size
 	const size_t outputSize = ((inputSize + kBlockSize - 1) / kBlockSize) * kBlockSize;
 
 	ScopedArray<byte> output(new byte[outputSize]);
 
-	byte buffer[kBlockSize];
-	byte *data = output.get();
-	while (inputSize > 0) {
-		const size_t toRead = MIN<size_t>(inputSize, kBlockSize);
+	if (input.read(output.get(), inputSize) != inputSize)
+		throw Exception(kReadError);
 
-		if (input.read(buffer, toRead) != toRead)
-			throw Exception(kReadError);
+	std::memset(output.get() + inputSize, 0, outputSize - inputSize);
 
-		if (toRead < kBlockSize)
-			std::memset(buffer + toRead, 0, kBlockSize - toRead);
+	blowfishECBBlocks(ctx, mode, output.get(), outputSize);
 
-		blowfishECB(ctx, mode, buffer, data);
+	return new MemoryReadStream(output.release(), outputSize, true);
+}
 
-		data      += toRead;
-		inputSize -= toRead;
-	}
+static void blowfishEBC(byte *data, size_t size, const BlowfishContext &ctx, Mode mode, size_t threadCount) {
+	if ((size % kBlockSize) != 0)
+		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) size);
 
-	return new MemoryReadStream(output.release(), outputSize, true);
+	blowfishECBBlocksParallel(ctx, mode, data, size, threadCount);
+}
+
+
+BlowfishKey::BlowfishKey(const std::vector<byte> &key) : _context(new BlowfishContext) {
+	blowfishSetKey(*_context, key.empty() ? 0 : &key[0], key.size());
+}
+
+BlowfishKey::~BlowfishKey() {
+}
+
+const BlowfishContext &BlowfishKey::getContext() const {
+	return *_context;
 }
 
+
 MemoryReadStream *encryptBlowfishEBC(SeekableReadStream &input, const std::vector<byte> &key) {
-	return blowfishEBC(input, key, kModeEncrypt);
+	return encryptBlowfishEBC(input, BlowfishKey(key));
 }
 
 MemoryReadStream *decryptBlowfishEBC(SeekableReadStream &input, const std::vector<byte> &key) {
 	if ((input.size() % 8) != 0)
 		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) input.size());
 
-	return blowfishEBC(input, key, kModeDecrypt);
+	return decryptBlowfishEBC(input, BlowfishKey(key));
+}
+
+void encryptBlowfishEBC(byte *data, size_t size, const std::vector<byte> &key, size_t threadCount) {
+	encryptBlowfishEBC(data, size, BlowfishKey(key), threadCount);
+}
+
+void decryptBlowfishEBC(byte *data, size_t size, const std::vector<byte> &key, size_t threadCount) {
+	decryptBlowfishEBC(data, size, BlowfishKey(key), threadCount);
+}
+
+MemoryReadStream *encryptBlowfishEBC(SeekableReadStream &input, const BlowfishKey &key) {
+	return blowfishEBC(input, key.getContext(), kModeEncrypt);
+}
+
+MemoryReadStream *decryptBlowfishEBC(SeekableReadStream &input, const BlowfishKey &key) {
+	if ((input.size() % 8) != 0)
+		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) input.size());
+
+	return blowfishEBC(input, key.getContext(), kModeDecrypt);
+}
+
+void encryptBlowfishEBC(byte *data, size_t size, const BlowfishKey &key, size_t threadCount) {
+	blowfishEBC(data, size, key.getContext(), kModeEncrypt, threadCount);
+}
+
+void decryptBlowfishEBC(byte *data, size_t size, const BlowfishKey &key, size_t threadCount) {
+	blowfishEBC(data, size, key.getContext(), kModeDecrypt, threadCount);
+}
+
+
+BlowfishEBCDecryptStream::BlowfishEBCDecryptStream(const SeekableReadStream *input,
+		const std::vector<byte> &key, bool disposeInput) :
+		_input(input, disposeInput), _context(new BlowfishContext), _pos(0), _eos(false) {
+
+	assert(input);
+
+	if ((_input->size() % kBlockSize) != 0)
+		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) _input->size());
+
+	blowfishSetKey(*_context, &key[0], key.size());
+}
+
+BlowfishEBCDecryptStream::BlowfishEBCDecryptStream(const SeekableReadStream *input,
+		const BlowfishKey &key, bool disposeInput) :
+		_input(input, disposeInput), _context(new BlowfishContext(key.getContext())), _pos(0), _eos(false) {
+
+	assert(input);
+
+	if ((_input->size() % kBlockSize) != 0)
+		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) _input->size());
+}
+
+BlowfishEBCDecryptStream::~BlowfishEBCDecryptStream() {
+}
+
+bool BlowfishEBCDecryptStream::eos() const {
+	return _eos;
+}
+
+size_t BlowfishEBCDecryptStream::pos() const {
+	return _pos;
+}
+
+size_t BlowfishEBCDecryptStream::size() const {
+	return _input->size();
+}
+
+size_t BlowfishEBCDecryptStream::seek(ptrdiff_t offset, Origin whence) {
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, size());
+	if (newPos > size())
+		throw Exception(kSeekError);
+
+	_pos = newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t BlowfishEBCDecryptStream::read(void *dataPtr, size_t dataSize) {
+	if (dataSize > (size() - _pos)) {
+		dataSize = size() - _pos;
+		_eos = true;
+	}
+
+	const size_t bytesRead = readAt(_pos, dataPtr, dataSize);
+	if (bytesRead != dataSize)
+		_eos = true;
+
+	_pos += bytesRead;
+
+	return bytesRead;
+}
+
+size_t BlowfishEBCDecryptStream::readAt(size_t offset, void *dataPtr, size_t dataSize) const {
+	const size_t streamSize = size();
+	if (offset >= streamSize)
+		return 0;
+
+	assert(dataPtr);
+	dataSize = MIN(dataSize, streamSize - offset);
+
+	/* Each block decrypts independently, so we only need to read and decrypt
+	 * the blocks overlapping the requested range. Whole blocks are read and
+	 * decrypted directly in the output buffer. Only the partial blocks at the
+	 * start and the end of the range go through a temporary block. */
+
+	byte *data = reinterpret_cast<byte *>(dataPtr);
+
+	size_t bytesRead = 0;
+	while (bytesRead < dataSize) {
+		const size_t position = offset + bytesRead;
+		const size_t skip     = position % kBlockSize;
+		const size_t toRead   = dataSize - bytesRead;
+
+		if ((skip == 0) && (toRead >= kBlockSize)) {
+			const size_t wholeBlocks = toRead - (toRead % kBlockSize);
+
+			if (_input->readAt(position, data + bytesRead, wholeBlocks) != wholeBlocks)
+				throw Exception(kReadError);
+
+			blowfishECBBlocks(*_context, kModeDecrypt, data + bytesRead, wholeBlocks);
+
+			bytesRead += wholeBlocks;
+			continue;
+		}
+
+		byte block[kBlockSize];
+		if (_input->readAt(position - skip, block, kBlockSize) != kBlockSize)
+			throw Exception(kReadError);
+
+		blowfishECB(*_context, kModeDecrypt, block, block);
+
+		const size_t toCopy = MIN(kBlockSize - skip, toRead);
+		std::memcpy(data + bytesRead, block + skip, toCopy);
+
+		bytesRead += toCopy;
+	}
+
+	return bytesRead;
 }
 
 } // End of namespace Common
@@ -27,18 +27,102 @@
 
 #include <vector>
 
+#include <boost/noncopyable.hpp>
+
 #include "src/common/types.h"
+#include "src/common/scopedptr.h"
+#include "src/common/disposableptr.h"
+#include "src/common/readstream.h"
 
 namespace Common {
 
-class SeekableReadStream;
 class MemoryReadStream;
 
+struct BlowfishContext;
+
+/** A Blowfish key, expanded into the key schedule used for encryption and decryption.
+ *
+ *  Expanding a key needs 521 block encryptions. So when the same key is used
+ *  over and over again, it pays to expand it only once.
+ */
+class BlowfishKey : boost::noncopyable {
+public:
+	BlowfishKey(const std::vector<byte> &key);
+	~BlowfishKey();
+
+	const BlowfishContext &getContext() const;
+
+private:
+	ScopedPtr<BlowfishContext> _context;
+};
+
 /** Encrypt the stream with the Blowfish algorithm in EBC mode. */
 MemoryReadStream *encryptBlowfishEBC(SeekableReadStream &input, const std::vector<byte> &key);
 /** Decrypt the stream with the Blowfish algorithm in EBC mode. */
 MemoryReadStream *decryptBlowfishEBC(SeekableReadStream &input, const std::vector<byte> &key);
 
+/** Encrypt a buffer in place with the Blowfish algorithm in EBC mode.
+ *
+ *  The size of the buffer has to be a multiple of 8 bytes. Large buffers are
+ *  split into chunks that are encrypted by threadCount threads in parallel.
+ *  A threadCount of 0 means as many threads as there are hardware threads.
+ */
+void encryptBlowfishEBC(byte *data, size_t size, const std::vector<byte> &key, size_t threadCount = 1);
+/** Decrypt a buffer in place with the Blowfish algorithm in EBC mode.
+ *
+ *  The size of the buffer has to be a multiple of 8 bytes. Large buffers are
+ *  split into chunks that are decrypted by threadCount threads in parallel.
+ *  A threadCount of 0 means as many threads as there are hardware threads.
+ */
+void decryptBlowfishEBC(byte *data, size_t size, const std::vector<byte> &key, size_t threadCount = 1);
+
+/** Encrypt the stream with the Blowfish algorithm in EBC mode, using an already expanded key. */
+MemoryReadStream *encryptBlowfishEBC(SeekableReadStream &input, const BlowfishKey &key);
+/** Decrypt the stream with the Blowfish algorithm in EBC mode, using an already expanded key. */
+MemoryReadStream *decryptBlowfishEBC(SeekableReadStream &input, const BlowfishKey &key);
+
+/** Encrypt a buffer in place with the Blowfish algorithm in EBC mode, using an already expanded key. */
+void encryptBlowfishEBC(byte *data, size_t size, const BlowfishKey &key, size_t threadCount = 1);
+/** Decrypt a buffer in place with the Blowfish algorithm in EBC mode, using an already expanded key. */
+void decryptBlowfishEBC(byte *data, size_t size, const BlowfishKey &key, size_t threadCount = 1);
+
+/** A stream that decrypts a Blowfish EBC encrypted stream on demand.
+ *
+ *  Since the blocks in EBC mode are independent of each other, only the
+ *  blocks that are actually read need to be decrypted. The input stream is
+ *  exclusively accessed through readAt(), and readAt() on this stream is
+ *  thread-safe if it is on the input stream.
+ *
+ *  The size of the input stream has to be a multiple of 8 bytes.
+ */
+class BlowfishEBCDecryptStream : boost::noncopyable, public SeekableReadStream {
+public:
+	BlowfishEBCDecryptStream(const SeekableReadStream *input, const std::vector<byte> &key,
+	                         bool disposeInput = false);
+	BlowfishEBCDecryptStream(const SeekableReadStream *input, const BlowfishKey &key,
+	                         bool disposeInput = false);
+	~BlowfishEBCDecryptStream();
+
+	bool eos() const;
+
+	size_t read(void *dataPtr, size_t dataSize);
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize) const;
+
+private:
+	DisposablePtr<const SeekableReadStream> _input;
+
+	ScopedPtr<BlowfishContext> _context;
+
+	size_t _pos;
+	bool _eos;
+};
+
 } // End of namespace Common
 
 #endif // COMMON_BLOWFISH_H
@@ -0,0 +1,212 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Base class for streams decompressing their data on demand.
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include "src/common/decompressreadstream.h"
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+namespace Common {
+
+static const size_t kInputBufferSize = 4096;
+
+/** The size of a frame of decompressed data. The window holds two frames. */
+static const size_t kFrameSize = 16384;
+
+/** The distance between two checkpoints, in decompressed data. Has to be a multiple of kFrameSize. */
+static const size_t kCheckpointDistance = 4 * 1024 * 1024;
+
+DecompressReadStream::Checkpoint::Checkpoint(size_t o, size_t i, State *s) :
+	outputPos(o), inputPos(i), state(s) {
+
+}
+
+DecompressReadStream::DecompressReadStream(SeekableReadStream *input, size_t outputSize,
+		bool disposeInput) : _input(input, disposeInput), _inputStart(0),
+		_inputBuffer(new byte[kInputBufferSize]), _window(new byte[2 * kFrameSize]),
+		_windowStart(0), _windowSize(0), _size(outputSize), _pos(0), _eos(false) {
+
+	assert(input);
+
+	setInputStart();
+}
+
+DecompressReadStream::~DecompressReadStream() {
+}
+
+bool DecompressReadStream::eos() const {
+	return _eos;
+}
+
+size_t DecompressReadStream::pos() const {
+	return _pos;
+}
+
+size_t DecompressReadStream::size() const {
+	return _size;
+}
+
+size_t DecompressReadStream::seek(ptrdiff_t offset, Origin whence) {
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	// Data in front of the window has to be decompressed again
+	if (newPos < _windowStart)
+		rewind(newPos);
+
+	// Data after the window is only decompressed once it's actually read
+	_pos = newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t DecompressReadStream::read(void *dataPtr, size_t dataSize) {
+	assert(dataPtr);
+
+	if (dataSize > (_size - _pos)) {
+		dataSize = _size - _pos;
+		_eos = true;
+	}
+
+	byte *data = reinterpret_cast<byte *>(dataPtr);
+
+	size_t bytesRead = 0;
+	while (bytesRead < dataSize) {
+		if (_pos >= (_windowStart + _windowSize)) {
+			decompressFrame();
+			continue;
+		}
+
+		const size_t n = MIN(dataSize - bytesRead, _windowStart + _windowSize - _pos);
+		std::memcpy(data + bytesRead, _window.get() + (_pos - _windowStart), n);
+
+		bytesRead += n;
+		_pos      += n;
+	}
+
+	return bytesRead;
+}
+
+void DecompressReadStream::decompressFully(byte *dataPtr, size_t dataSize) {
+	while (dataSize > 0) {
+		const size_t decompressed = decompress(dataPtr, dataSize);
+		if (decompressed == 0)
+			throw Exception("Failed to decompress: premature end of compressed data");
+
+		dataPtr  += decompressed;
+		dataSize -= decompressed;
+	}
+}
+
+void DecompressReadStream::decompressFrame() {
+	// Drop the older frame to make room
+	if (_windowSize == (2 * kFrameSize)) {
+		std::memmove(_window.get(), _window.get() + kFrameSize, kFrameSize);
+
+		_windowStart += kFrameSize;
+		_windowSize  -= kFrameSize;
+	}
+
+	const size_t frameSize = MIN(kFrameSize, _size - (_windowStart + _windowSize));
+
+	decompressFully(_window.get() + _windowSize, frameSize);
+	_windowSize += frameSize;
+
+	addCheckpoint();
+}
+
+void DecompressReadStream::addCheckpoint() {
+	const size_t outputPos = _windowStart + _windowSize;
+	if (((outputPos % kCheckpointDistance) != 0) || (outputPos >= _size))
+		return;
+
+	// We might have been here before
+	if (!_checkpoints.empty() && (_checkpoints.back()->outputPos >= outputPos))
+		return;
+
+	size_t pendingInput = 0;
+	State *state = saveState(pendingInput);
+	if (!state)
+		return;
+
+	_checkpoints.push_back(new Checkpoint(outputPos, _input->pos() - pendingInput, state));
+}
+
+void DecompressReadStream::rewind(size_t pos) {
+	const Checkpoint *checkpoint = 0;
+	for (PtrVector<Checkpoint>::const_iterator c = _checkpoints.begin(); c != _checkpoints.end(); ++c) {
+		if ((*c)->outputPos > pos)
+			break;
+
+		checkpoint = *c;
+	}
+
+	if (checkpoint) {
+		_input->seek(checkpoint->inputPos);
+		restoreState(*checkpoint->state);
+
+		_windowStart = checkpoint->outputPos;
+	} else {
+		_input->seek(_inputStart);
+		restart();
+
+		_windowStart = 0;
+	}
+
+	_windowSize = 0;
+}
+
+DecompressReadStream::State *DecompressReadStream::saveState(size_t &UNUSED(pendingInput)) {
+	return 0;
+}
+
+void DecompressReadStream::restoreState(const State &UNUSED(state)) {
+	// Decompressors that never save their state never need to restore it
+	assert(false);
+}
+
+size_t DecompressReadStream::readInput(const byte *&data) {
+	data = _inputBuffer.get();
+
+	const size_t inputPos = _input->pos();
+	if (inputPos >= _input->size())
+		return 0;
+
+	const size_t toRead = MIN(kInputBufferSize, _input->size() - inputPos);
+	if (_input->read(_inputBuffer.get(), toRead) != toRead)
+		throw Exception(kReadError);
+
+	return toRead;
+}
+
+void DecompressReadStream::setInputStart() {
+	_inputStart = _input->pos();
+}
+
+} // End of namespace Common
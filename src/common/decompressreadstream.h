@@ -0,0 +1,154 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Base class for streams decompressing their data on demand.
+ */
+
+#ifndef COMMON_DECOMPRESSREADSTREAM_H
+#define COMMON_DECOMPRESSREADSTREAM_H
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/scopedptr.h"
+#include "src/common/disposableptr.h"
+#include "src/common/ptrvector.h"
+#include "src/common/readstream.h"
+
+namespace Common {
+
+/** A stream that decompresses data from an input stream on demand.
+ *
+ *  Only a small, constant amount of memory is needed, independent of the
+ *  size of the decompressed data. Data is decompressed as it is read.
+ *
+ *  The last two frames of decompressed data are kept, so that short seeks
+ *  backward, like when reading a string and going back to its end, cost
+ *  nothing. Seeking further forward decompresses and discards the data up
+ *  to the new position.
+ *
+ *  Seeking further backward restarts the decompression from a checkpoint.
+ *  If the decompressor can save its state, a checkpoint is taken every few
+ *  MB of decompressed data. Otherwise, the only checkpoint is the beginning
+ *  of the compressed data. Either way, streams that are read front to back,
+ *  like when dumping them into a file, are handled best.
+ *
+ *  The compressed data starts at the position of the input stream when the
+ *  DecompressReadStream is created and ends with the input stream.
+ */
+class DecompressReadStream : boost::noncopyable, public SeekableReadStream {
+public:
+	~DecompressReadStream();
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+	size_t read(void *dataPtr, size_t dataSize);
+
+protected:
+	/** A saved state of the decompressor. */
+	class State : boost::noncopyable {
+	public:
+		virtual ~State() { }
+	};
+
+	DecompressReadStream(SeekableReadStream *input, size_t outputSize, bool disposeInput);
+
+	/** Reset the decompressor, to decompress from the start again. */
+	virtual void restart() = 0;
+
+	/** Decompress up to dataSize bytes into dataPtr.
+	 *
+	 *  This should return as soon as any data has been decompressed. If no
+	 *  more data can be decompressed at all, 0 is returned.
+	 */
+	virtual size_t decompress(byte *dataPtr, size_t dataSize) = 0;
+
+	/** Save the current state of the decompressor.
+	 *
+	 *  @param  pendingInput Set to the number of bytes of compressed data that
+	 *                       were already read but not yet decompressed.
+	 *  @return The saved state, or 0 if the decompressor can't save its state.
+	 */
+	virtual State *saveState(size_t &pendingInput);
+
+	/** Restore a saved state of the decompressor, without any pending input. */
+	virtual void restoreState(const State &state);
+
+	/** Read the next block of compressed data.
+	 *
+	 *  @param  data Set to the compressed data, which stays valid until the next call.
+	 *  @return The number of bytes of compressed data, or 0 at the end of the input.
+	 */
+	size_t readInput(const byte *&data);
+
+	/** Mark the current position of the input stream as the start of the compressed data. */
+	void setInputStart();
+
+private:
+	/** A position to restart the decompression from. */
+	struct Checkpoint {
+		size_t outputPos; ///< The position within the decompressed data.
+		size_t inputPos;  ///< The position within the compressed data.
+
+		ScopedPtr<State> state; ///< The state of the decompressor.
+
+		Checkpoint(size_t o, size_t i, State *s);
+	};
+
+	DisposablePtr<SeekableReadStream> _input;
+
+	size_t _inputStart;
+
+	ScopedArray<byte> _inputBuffer;
+
+	/** The last decompressed frames. */
+	ScopedArray<byte> _window;
+
+	size_t _windowStart; ///< The position of the window within the decompressed data.
+	size_t _windowSize;  ///< The number of bytes in the window.
+
+	PtrVector<Checkpoint> _checkpoints;
+
+	size_t _size;
+	size_t _pos;
+
+	bool _eos;
+
+	/** Decompress exactly dataSize bytes, or throw. */
+	void decompressFully(byte *dataPtr, size_t dataSize);
+
+	/** Decompress the next frame into the window, dropping the oldest frame if necessary. */
+	void decompressFrame();
+
+	/** Restart the decompression from the last checkpoint in front of this position. */
+	void rewind(size_t pos);
+
+	/** Take a checkpoint at the end of the window, if one is due. */
+	void addCheckpoint();
+};
+
+} // End of namespace Common
+
+#endif // COMMON_DECOMPRESSREADSTREAM_H
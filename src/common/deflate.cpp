@@ -27,6 +27,7 @@
 #include <boost/scope_exit.hpp>
 
 #include "src/common/deflate.h"
+#include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/scopedptr.h"
 #include "src/common/ptrvector.h"
@@ -203,4 +204,135 @@ size_t decompressDeflateChunk(SeekableReadStream &input, int windowBits,
 	return strm.total_out;
 }
 
+void compressDeflateChunk(const byte *data, size_t dataSize, const byte *dictionary, size_t dictionarySize,
+                          bool lastChunk, std::vector<byte> &output) {
+
+	z_stream strm;
+	strm.zalloc = Z_NULL;
+	strm.zfree  = Z_NULL;
+	strm.opaque = Z_NULL;
+
+	int zResult = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, kWindowBitsMaxRaw, 8, Z_DEFAULT_STRATEGY);
+	if (zResult != Z_OK)
+		throw Exception("Could not initialize zlib deflate: %s (%d)", zError(zResult), zResult);
+
+	BOOST_SCOPE_EXIT( (&strm) ) {
+			deflateEnd(&strm);
+	} BOOST_SCOPE_EXIT_END
+
+	if (dictionary && (dictionarySize > 0)) {
+		dictionarySize = MIN(dictionarySize, kDeflateDictionarySize);
+
+		zResult = deflateSetDictionary(&strm, dictionary, dictionarySize);
+		if (zResult != Z_OK)
+			throw Exception("Could not set zlib deflate dictionary: %s (%d)", zError(zResult), zResult);
+	}
+
+	setZStreamInput(strm, dataSize, data);
+
+	/* Only the last chunk finishes the stream. All other chunks are flushed
+	 * to a byte boundary, without marking the last block as final, so that
+	 * the next chunk's data can directly follow. Some extra space is needed
+	 * on top of deflateBound() for the flush marker. */
+	const size_t outputStart = output.size();
+	output.resize(outputStart + deflateBound(&strm, dataSize) + 16);
+
+	strm.avail_out = output.size() - outputStart;
+	strm.next_out  = &output[outputStart];
+
+	zResult = deflate(&strm, lastChunk ? Z_FINISH : Z_SYNC_FLUSH);
+	if (( lastChunk && (zResult != Z_STREAM_END)) ||
+	    (!lastChunk && ((zResult != Z_OK) || (strm.avail_in != 0))))
+		throw Exception("Failed to deflate: %s (%d)", zError(zResult), zResult);
+
+	output.resize(output.size() - strm.avail_out);
+}
+
+/** A copy of the state of a zlib inflate stream. */
+class DeflateReadStream::ZState : public DecompressReadStream::State {
+public:
+	ZState(z_stream &strm) {
+		const int zResult = inflateCopy(&_strm, &strm);
+		if (zResult != Z_OK)
+			throw Exception("Could not copy zlib inflate state: %s (%d)", zError(zResult), zResult);
+
+		// The input still pending belongs to the original stream
+		setZStreamInput(_strm, 0, 0);
+	}
+
+	~ZState() {
+		inflateEnd(&_strm);
+	}
+
+	z_stream &getStream() const {
+		return _strm;
+	}
+
+private:
+	mutable z_stream _strm;
+};
+
+DeflateReadStream::DeflateReadStream(SeekableReadStream *input, size_t outputSize, int windowBits,
+		bool disposeInput) : DecompressReadStream(input, outputSize, disposeInput),
+		_strm(new z_stream), _streamEnd(false) {
+
+	initZStream(*_strm, windowBits, 0, 0);
+}
+
+DeflateReadStream::~DeflateReadStream() {
+	inflateEnd(_strm.get());
+}
+
+void DeflateReadStream::restart() {
+	const int zResult = inflateReset(_strm.get());
+	if (zResult != Z_OK)
+		throw Exception("Could not reset zlib inflate: %s (%d)", zError(zResult), zResult);
+
+	setZStreamInput(*_strm, 0, 0);
+
+	_streamEnd = false;
+}
+
+DecompressReadStream::State *DeflateReadStream::saveState(size_t &pendingInput) {
+	pendingInput = _strm->avail_in;
+
+	return new ZState(*_strm);
+}
+
+void DeflateReadStream::restoreState(const State &state) {
+	inflateEnd(_strm.get());
+
+	const int zResult = inflateCopy(_strm.get(), &static_cast<const ZState &>(state).getStream());
+	if (zResult != Z_OK)
+		throw Exception("Could not restore zlib inflate state: %s (%d)", zError(zResult), zResult);
+
+	_streamEnd = false;
+}
+
+size_t DeflateReadStream::decompress(byte *dataPtr, size_t dataSize) {
+	_strm->avail_out = dataSize;
+	_strm->next_out  = dataPtr;
+
+	while ((_strm->avail_out == dataSize) && !_streamEnd) {
+		if (_strm->avail_in == 0) {
+			const byte *input = 0;
+
+			const size_t inputSize = readInput(input);
+			if (inputSize == 0)
+				break;
+
+			setZStreamInput(*_strm, inputSize, input);
+		}
+
+		// Decompress. Z_SYNC_FLUSH, because we want to decompress partwise.
+		const int zResult = inflate(_strm.get(), Z_SYNC_FLUSH);
+		if (zResult == Z_STREAM_END)
+			_streamEnd = true;
+		else if (zResult != Z_OK)
+			throw Exception("Failed to inflate: %s (%d)", zError(zResult), zResult);
+	}
+
+	return dataSize - _strm->avail_out;
+}
+
 } // End of namespace Common
@@ -25,12 +25,17 @@
 #ifndef COMMON_DEFLATE_H
 #define COMMON_DEFLATE_H
 
+#include <vector>
+
 #include "src/common/types.h"
+#include "src/common/scopedptr.h"
+#include "src/common/decompressreadstream.h"
+
+struct z_stream_s;
 
 namespace Common {
 
 /* TODO (should be need it):
- * - Compression
  * - Decompress dynamically, without needing to know the size
  *   of the decompressed data beforehand
  */
@@ -41,6 +46,9 @@ class SeekableReadStream;
 static const int kWindowBitsMax    =  15;
 static const int kWindowBitsMaxRaw = -kWindowBitsMax;
 
+/** The maximum distance DEFLATE looks back for matches. */
+static const size_t kDeflateDictionarySize = 32768;
+
 /** Decompress (inflate) using zlib's DEFLATE algorithm.
  *
  *  @param  data       The compressed input data.
@@ -117,6 +125,63 @@ SeekableReadStream *decompressDeflateWithoutOutputSize(ReadStream &input, size_t
 size_t decompressDeflateChunk(SeekableReadStream &input, int windowBits, byte *output, size_t outputSize,
                               unsigned int frameSize = 4096);
 
+/** Compress (deflate) one chunk of a larger piece of data, using zlib's DEFLATE algorithm.
+ *
+ *  The chunks are compressed independently of each other, so that several
+ *  chunks of the same data can be compressed at the same time. The output
+ *  is raw DEFLATE data, without a header or a trailer. Appending the output
+ *  of all chunks, in order, creates one valid raw DEFLATE stream.
+ *
+ *  To not lose too much compression at the chunk boundaries, the data just
+ *  in front of the chunk can be given as a dictionary.
+ *
+ *  @param data           The uncompressed data of this chunk.
+ *  @param dataSize       The size of the uncompressed data in bytes.
+ *  @param dictionary     Up to kDeflateDictionarySize bytes of the uncompressed
+ *                        data directly in front of this chunk. Can be 0.
+ *  @param dictionarySize The size of the dictionary in bytes.
+ *  @param lastChunk      Is this the last chunk? Only the last chunk ends the stream.
+ *  @param output         The compressed data is appended to this vector.
+ */
+void compressDeflateChunk(const byte *data, size_t dataSize, const byte *dictionary, size_t dictionarySize,
+                          bool lastChunk, std::vector<byte> &output);
+
+/** A stream that decompresses (inflates) using zlib's DEFLATE algorithm on demand.
+ *
+ *  Unlike decompressDeflate(), this never holds the whole compressed or
+ *  decompressed data in memory. See DecompressReadStream for the details.
+ */
+class DeflateReadStream : public DecompressReadStream {
+public:
+	/** Create a decompressing stream.
+	 *
+	 *  @param  input        The compressed input data, from the current position
+	 *                       until the end of the stream.
+	 *  @param  outputSize   The size of the decompressed output data.
+	 *  @param  windowBits   The base two logarithm of the window size (the size of
+	 *                       the history buffer). See the zlib documentation on
+	 *                       inflateInit2() for details.
+	 *  @param  disposeInput Take over ownership of the input stream.
+	 */
+	DeflateReadStream(SeekableReadStream *input, size_t outputSize, int windowBits,
+	                  bool disposeInput = false);
+	~DeflateReadStream();
+
+protected:
+	void restart();
+	size_t decompress(byte *dataPtr, size_t dataSize);
+
+	State *saveState(size_t &pendingInput);
+	void restoreState(const State &state);
+
+private:
+	class ZState;
+
+	ScopedPtr<z_stream_s> _strm;
+
+	bool _streamEnd;
+};
+
 } // End of namespace Common
 
 #endif // COMMON_DEFLATE_H
@@ -28,12 +28,20 @@
 #include <iconv.h>
 
 #include <vector>
+#include <string>
+#include <iterator>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "utf8cpp/utf8.h"
 
 #include "src/common/encoding.h"
 #include "src/common/encoding_strings.h"
+#include "src/common/encoding_tables.h"
+#include "src/common/endianness.h"
 #include "src/common/error.h"
 #include "src/common/scopedptr.h"
-#include "src/common/singleton.h"
 #include "src/common/ustring.h"
 #include "src/common/memreadstream.h"
 #include "src/common/writestream.h"
@@ -57,22 +65,22 @@ static const size_t kTerminatorLength  [kEncodingMAX] = {
 	1, 1, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1
 };
 
-/** A manager handling string encoding conversions. */
-class ConversionManager : public Singleton<ConversionManager> {
+/** A manager handling string encoding conversions through iconv.
+ *
+ *  An iconv context carries conversion state and must not be used by more than
+ *  one thread at a time. So every thread gets its own manager, and with it its
+ *  own set of contexts, which are only opened when they're first needed.
+ */
+class ConversionManager : boost::noncopyable {
 public:
 	ConversionManager() {
 		for (size_t i = 0; i < kEncodingMAX; i++) {
 			_contextFrom[i] = (iconv_t) -1;
 			_contextTo  [i] = (iconv_t) -1;
-		}
-
-		for (size_t i = 0; i < kEncodingMAX; i++)
-			if ((_contextFrom[i] = iconv_open("UTF-8", kEncodingName[i])) == ((iconv_t) -1))
-				warning("Failed to initialize %s -> UTF-8 conversion: %s", kEncodingName[i], strerror(errno));
 
-		for (size_t i = 0; i < kEncodingMAX; i++)
-			if ((_contextTo  [i] = iconv_open(kEncodingName[i], "UTF-8")) == ((iconv_t) -1))
-				warning("Failed to initialize UTF-8 -> %s conversion: %s", kEncodingName[i], strerror(errno));
+			_openedFrom[i] = false;
+			_openedTo  [i] = false;
+		}
 	}
 
 	~ConversionManager() {
@@ -90,10 +98,10 @@ public:
 			return false;
 
 		if (from == kEncodingUTF8)
-			return _contextTo[to] != ((iconv_t) -1);
+			return getContextTo(to) != ((iconv_t) -1);
 
 		if (to == kEncodingUTF8)
-			return _contextFrom[from] != ((iconv_t) -1);
+			return getContextFrom(from) != ((iconv_t) -1);
 
 		return false;
 	}
@@ -102,14 +110,14 @@ public:
 		if (((size_t) encoding) >= kEncodingMAX)
 			throw Exception("Invalid encoding %d", encoding);
 
-		return convert(_contextFrom[encoding], data, n, kEncodingGrowthFrom[encoding], 1);
+		return convert(getContextFrom(encoding), data, n, kEncodingGrowthFrom[encoding], 1);
 	}
 
 	MemoryReadStream *convert(Encoding encoding, const UString &str, bool terminate = true) {
 		if (((size_t) encoding) >= kEncodingMAX)
 			throw Exception("Invalid encoding %d", encoding);
 
-		return convert(_contextTo[encoding], str, kEncodingGrowthTo[encoding],
+		return convert(getContextTo(encoding), str, kEncodingGrowthTo[encoding],
 		               terminate ? kTerminatorLength[encoding] : 0);
 	}
 
@@ -117,6 +125,31 @@ private:
 	iconv_t _contextFrom[kEncodingMAX];
 	iconv_t _contextTo  [kEncodingMAX];
 
+	bool _openedFrom[kEncodingMAX];
+	bool _openedTo  [kEncodingMAX];
+
+	iconv_t &getContextFrom(Encoding encoding) {
+		if (!_openedFrom[encoding]) {
+			_openedFrom[encoding] = true;
+
+			if ((_contextFrom[encoding] = iconv_open("UTF-8", kEncodingName[encoding])) == ((iconv_t) -1))
+				warning("Failed to initialize %s -> UTF-8 conversion: %s", kEncodingName[encoding], strerror(errno));
+		}
+
+		return _contextFrom[encoding];
+	}
+
+	iconv_t &getContextTo(Encoding encoding) {
+		if (!_openedTo[encoding]) {
+			_openedTo[encoding] = true;
+
+			if ((_contextTo[encoding] = iconv_open(kEncodingName[encoding], "UTF-8")) == ((iconv_t) -1))
+				warning("Failed to initialize UTF-8 -> %s conversion: %s", kEncodingName[encoding], strerror(errno));
+		}
+
+		return _contextTo[encoding];
+	}
+
 	byte *doConvert(iconv_t &ctx, byte *data, size_t nIn, size_t nOut, size_t &size) {
 		size_t inBytes  = nIn;
 		size_t outBytes = nOut;
@@ -176,13 +209,17 @@ private:
 	}
 };
 
-}
+/** The conversion manager of the current thread. */
+static boost::thread_specific_ptr<ConversionManager> _conversionManager;
 
-#define ConvMan Common::ConversionManager::instance()
+static ConversionManager &getConversionManager() {
+	if (!_conversionManager.get())
+		_conversionManager.reset(new ConversionManager);
 
-DECLARE_SINGLETON(Common::ConversionManager)
+	return *_conversionManager;
+}
 
-namespace Common {
+#define ConvMan getConversionManager()
 
 UString getEncodingName(Encoding encoding) {
 	if (((size_t) encoding) >= kEncodingMAX)
@@ -191,105 +228,321 @@ UString getEncodingName(Encoding encoding) {
 	return kEncodingName[encoding];
 }
 
+/** Return the codepage table of a single-byte encoding we can convert ourselves. */
+static const uint16 *getCodepageTable(Encoding encoding) {
+	switch (encoding) {
+		case kEncodingLatin9:
+			return kCodepageLatin9;
+		case kEncodingCP1250:
+			return kCodepageCP1250;
+		case kEncodingCP1251:
+			return kCodepageCP1251;
+		case kEncodingCP1252:
+			return kCodepageCP1252;
+
+		default:
+			break;
+	}
+
+	return 0;
+}
+
+/** Can we convert this encoding from and into UTF-8 without iconv? */
+static bool isBuiltinEncoding(Encoding encoding) {
+	return (encoding == kEncodingASCII)   || (encoding == kEncodingUTF8)    ||
+	       (encoding == kEncodingUTF16LE) || (encoding == kEncodingUTF16BE) ||
+	       getCodepageTable(encoding);
+}
+
 bool hasSupportEncoding(Encoding encoding) {
+	if (isBuiltinEncoding(encoding))
+		return true;
+
 	return ConvMan.hasSupportTranscode(kEncodingUTF8, encoding     ) &&
 	       ConvMan.hasSupportTranscode(encoding     , kEncodingUTF8);
 }
 
-static uint32 readFakeChar(SeekableReadStream &stream, Encoding encoding) {
-	byte data[2];
+/** Return the size of a single character in an encoding, as far as terminators are concerned. */
+static size_t getCharSize(Encoding encoding) {
+	if (((size_t) encoding) >= kEncodingMAX)
+		return 1;
 
-	switch (encoding) {
-		case kEncodingASCII:
-		case kEncodingLatin9:
-		case kEncodingUTF8:
-		case kEncodingCP1250:
-		case kEncodingCP1251:
-		case kEncodingCP1252:
-		case kEncodingCP932:
-		case kEncodingCP936:
-		case kEncodingCP949:
-		case kEncodingCP950:
-			if (stream.read(data, 1) != 1)
-				return 0;
+	return kTerminatorLength[encoding];
+}
 
-			return data[0];
+/** Find the first end-of-string terminator in the data, or return size if there is none. */
+static size_t findTerminator(const byte *data, size_t size, size_t charSize) {
+	if (charSize == 1) {
+		const byte *end = static_cast<const byte *>(std::memchr(data, 0, size));
 
-		case kEncodingUTF16LE:
-			if (stream.read(data, 2) != 2)
-				return 0;
+		return end ? (end - data) : size;
+	}
 
-			return READ_LE_UINT16(data);
+	for (size_t i = 0; (i + 1) < size; i += 2)
+		if ((data[i] == 0) && (data[i + 1] == 0))
+			return i;
 
-		case kEncodingUTF16BE:
-			if (stream.read(data, 2) != 2)
-				return 0;
+	return size;
+}
 
-			return READ_BE_UINT16(data);
+/** Append the run of ASCII characters at the start of the data to a UTF-8 string.
+ *
+ *  Most strings are mostly ASCII, so we look at 8 bytes at once to find the
+ *  end of the run. Returns the length of the run.
+ */
+static size_t appendASCII(std::string &str, const byte *data, size_t size) {
+	static const uint64 kHighBits = (((uint64) 0x80808080) << 32) | 0x80808080;
 
-		default:
-			break;
+	size_t n = 0;
+	while (((n + 8) <= size) && !(READ_UINT64(data + n) & kHighBits))
+		n += 8;
+
+	while ((n < size) && (data[n] < 0x80))
+		n++;
+
+	str.append(reinterpret_cast<const char *>(data), n);
+	return n;
+}
+
+static bool decodeCodepage(std::string &str, const byte *data, size_t size, const uint16 *table) {
+	str.reserve(size);
+
+	size_t i = 0;
+	while ((i += appendASCII(str, data + i, size - i)) < size) {
+		const uint32 c = table[data[i++] - 0x80];
+		if (c == 0)
+			return false;
+
+		utf8::append(c, std::back_inserter(str));
 	}
 
-	return 0;
+	return true;
 }
 
-static void writeFakeChar(std::vector<byte> &output, uint32 c, Encoding encoding) {
-	byte data[2];
+static bool decodeUTF16(std::string &str, const byte *data, size_t size, bool bigEndian) {
+	// A lone byte at the end is an incomplete character
+	if ((size % 2) != 0)
+		return false;
+
+	str.reserve(size / 2);
+
+	for (size_t i = 0; i < size; i += 2) {
+		uint32 c = bigEndian ? READ_BE_UINT16(data + i) : READ_LE_UINT16(data + i);
+		if (c < 0x80) {
+			str += (char) c;
+			continue;
+		}
+
+		if ((c >= 0xDC00) && (c <= 0xDFFF))
+			return false;
+
+		if ((c >= 0xD800) && (c <= 0xDBFF)) {
+			// Surrogate pair
+
+			if ((i + 4) > size)
+				return false;
+
+			i += 2;
+
+			const uint32 low = bigEndian ? READ_BE_UINT16(data + i) : READ_LE_UINT16(data + i);
+			if ((low < 0xDC00) || (low > 0xDFFF))
+				return false;
+
+			c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+		}
+
+		utf8::append(c, std::back_inserter(str));
+	}
+
+	return true;
+}
+
+/** Convert a string in the given encoding, up to its first terminator, to UTF-8. */
+static UString createString(const byte *data, size_t size, Encoding encoding) {
+	if (size == 0)
+		return "";
+
+	size = findTerminator(data, size, getCharSize(encoding));
+
+	std::string str;
+	bool success = true;
 
 	switch (encoding) {
 		case kEncodingASCII:
-		case kEncodingLatin9:
 		case kEncodingUTF8:
-		case kEncodingCP1250:
-		case kEncodingCP1251:
-		case kEncodingCP1252:
-		case kEncodingCP932:
-		case kEncodingCP936:
-		case kEncodingCP949:
-		case kEncodingCP950:
-			output.push_back(c);
+			str.assign(reinterpret_cast<const char *>(data), size);
 			break;
 
 		case kEncodingUTF16LE:
-			WRITE_LE_UINT16(data, c);
-			output.push_back(data[0]);
-			output.push_back(data[1]);
-			break;
-
 		case kEncodingUTF16BE:
-			WRITE_BE_UINT16(data, c);
-			output.push_back(data[0]);
-			output.push_back(data[1]);
+			success = decodeUTF16(str, data, size, encoding == kEncodingUTF16BE);
 			break;
 
 		default:
+			if (!getCodepageTable(encoding))
+				return ConvMan.convert(encoding, const_cast<byte *>(data), size);
+
+			success = decodeCodepage(str, data, size, getCodepageTable(encoding));
 			break;
 	}
+
+	if (!success) {
+		warning("Failed to convert a string from %s: Invalid byte sequence", kEncodingName[encoding]);
+		return "[!?!]";
+	}
+
+	return UString(str);
 }
 
-static UString createString(std::vector<byte> &output, Encoding encoding) {
-	switch (encoding) {
-		case kEncodingASCII:
-		case kEncodingUTF8:
-			output.push_back('\0');
-			return UString(reinterpret_cast<const char *>(&output[0]));
+static bool encodeCodepage(std::vector<byte> &output, const UString &str, const uint16 *table) {
+	output.reserve(str.size() + 1);
 
-		default:
-			return ConvMan.convert(encoding, &output[0], output.size());
+	for (UString::iterator it = str.begin(); it != str.end(); ++it) {
+		const uint32 c = *it;
+		if (c < 0x80) {
+			output.push_back(c);
+			continue;
+		}
+
+		if (!table)
+			return false;
+
+		// Non-ASCII characters are rare enough that looking through the table is fine
+		size_t i = 0;
+		while ((i < 128) && (table[i] != c))
+			i++;
+
+		if (i == 128)
+			return false;
+
+		output.push_back(0x80 + i);
 	}
 
-	return "";
+	return true;
+}
+
+static bool encodeUTF16(std::vector<byte> &output, const UString &str, bool bigEndian) {
+	output.reserve(2 * str.size() + 2);
+
+	byte data[2];
+	for (UString::iterator it = str.begin(); it != str.end(); ++it) {
+		uint32 c = *it;
+
+		if (c >= 0x10000) {
+			// Surrogate pair
+			c -= 0x10000;
+
+			if (bigEndian)
+				WRITE_BE_UINT16(data, 0xD800 | (c >> 10));
+			else
+				WRITE_LE_UINT16(data, 0xD800 | (c >> 10));
+
+			output.push_back(data[0]);
+			output.push_back(data[1]);
+
+			c = 0xDC00 | (c & 0x3FF);
+		}
+
+		if (bigEndian)
+			WRITE_BE_UINT16(data, c);
+		else
+			WRITE_LE_UINT16(data, c);
+
+		output.push_back(data[0]);
+		output.push_back(data[1]);
+	}
+
+	return true;
+}
+
+/** Convert a UTF-8 string into an encoding we can convert ourselves. */
+static MemoryReadStream *createBuiltinString(const UString &str, Encoding encoding, bool terminate) {
+	std::vector<byte> output;
+
+	bool success = false;
+	if ((encoding == kEncodingUTF16LE) || (encoding == kEncodingUTF16BE))
+		success = encodeUTF16(output, str, encoding == kEncodingUTF16BE);
+	else
+		success = encodeCodepage(output, str, getCodepageTable(encoding));
+
+	if (!success) {
+		warning("Failed to convert a string into %s: Invalid character", kEncodingName[encoding]);
+		return 0;
+	}
+
+	if (terminate)
+		output.resize(output.size() + getCharSize(encoding), 0);
+
+	if (output.empty())
+		return new MemoryReadStream(static_cast<const byte *>(0), 0);
+
+	byte *data = new byte[output.size()];
+	std::memcpy(data, &output[0], output.size());
+
+	return new MemoryReadStream(data, output.size(), true);
+}
+
+/** Read a string in the given encoding out of the stream, up to a terminating character.
+ *
+ *  Instead of reading the stream character by character, we read it in chunks,
+ *  look for the terminator in the chunk and then seek back to just after it.
+ *
+ *  If line is true, the string is also terminated by a line feed, and carriage
+ *  returns are dropped.
+ */
+static void readStringData(SeekableReadStream &stream, std::vector<byte> &output,
+                           Encoding encoding, bool line) {
+
+	static const size_t kChunkSize = 256;
+
+	const size_t charSize = getCharSize(encoding);
+
+	byte chunk[kChunkSize];
+	while (true) {
+		const size_t n = stream.read(chunk, kChunkSize);
+
+		size_t start = 0, i = 0;
+		for ( ; (i + charSize) <= n; i += charSize) {
+			uint32 c = chunk[i];
+			if (encoding == kEncodingUTF16LE)
+				c = READ_LE_UINT16(chunk + i);
+			else if (encoding == kEncodingUTF16BE)
+				c = READ_BE_UINT16(chunk + i);
+
+			if ((c == '\0') || (line && (c == '\n')))
+				break;
+
+			if (line && (c == '\r')) {
+				output.insert(output.end(), chunk + start, chunk + i);
+				start = i + charSize;
+			}
+		}
+
+		output.insert(output.end(), chunk + start, chunk + i);
+
+		if ((i + charSize) <= n) {
+			// Found the terminator. Seek back to right after it
+			stream.seek((ptrdiff_t) (i + charSize) - (ptrdiff_t) n, SeekableReadStream::kOriginCurrent);
+			return;
+		}
+
+		if (n < kChunkSize)
+			return;
+
+		// A partial character at the end of a full chunk is read again with the next chunk
+		if (i < n)
+			stream.seek((ptrdiff_t) i - (ptrdiff_t) n, SeekableReadStream::kOriginCurrent);
+	}
 }
 
 UString readString(SeekableReadStream &stream, Encoding encoding) {
 	std::vector<byte> output;
 
-	uint32 c;
-	while (((c = readFakeChar(stream, encoding)) != '\0') && !stream.eos())
-		writeFakeChar(output, c, encoding);
+	readStringData(stream, output, encoding, false);
+	if (output.empty())
+		return "";
 
-	return createString(output, encoding);
+	return createString(&output[0], output.size(), encoding);
 }
 
 UString readStringFixed(SeekableReadStream &stream, Encoding encoding, size_t length) {
@@ -300,38 +553,22 @@ UString readStringFixed(SeekableReadStream &stream, Encoding encoding, size_t le
 	output.resize(length);
 
 	length = stream.read(&output[0], length);
-	output.resize(length);
 
-	return createString(output, encoding);
+	return createString(&output[0], length, encoding);
 }
 
 UString readStringLine(SeekableReadStream &stream, Encoding encoding) {
 	std::vector<byte> output;
 
-	uint32 c;
-	while (((c = readFakeChar(stream, encoding)) != '\0') && !stream.eos()) {
-		if (c == '\n')
-			break;
-
-		if (c == '\r')
-			continue;
-
-		writeFakeChar(output, c, encoding);
-	}
+	readStringData(stream, output, encoding, true);
+	if (output.empty())
+		return "";
 
-	return createString(output, encoding);
+	return createString(&output[0], output.size(), encoding);
 }
 
 UString readString(const byte *data, size_t size, Encoding encoding) {
-	if (size == 0)
-		return "";
-
-	std::vector<byte> output;
-	output.resize(size);
-
-	std::memcpy(&output[0], data, size);
-
-	return createString(output, encoding);
+	return createString(data, size, encoding);
 }
 
 size_t writeString(WriteStream &stream, const UString &str, Encoding encoding, bool terminate) {
@@ -358,6 +595,9 @@ MemoryReadStream *convertString(const UString &str, Encoding encoding, bool term
 		return new MemoryReadStream(reinterpret_cast<const byte *>(str.c_str()),
 		                            std::strlen(str.c_str()) + (terminateString ? 1 : 0));
 
+	if (isBuiltinEncoding(encoding))
+		return createBuiltinString(str, encoding, terminateString);
+
 	return ConvMan.convert(encoding, str, terminateString);
 }
 
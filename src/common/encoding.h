@@ -20,6 +20,8 @@
 
 /** @file
  *  Utility functions for working with differing string encodings.
+ *
+ *  All these functions can safely be called from several threads at once.
  */
 
 #ifndef COMMON_ENCODING_H
@@ -130,4 +130,96 @@ SeekableReadStream *decompressLZMA1(ReadStream &input, size_t inputSize, size_t
 	return new MemoryReadStream(outputData, outputSize, true);
 }
 
+
+struct LZMA1ReadStream::Decoder {
+	lzma_filter filters[2];
+	lzma_stream strm;
+
+	Decoder() {
+		filters[0].id      = LZMA_FILTER_LZMA1;
+		filters[0].options = 0;
+		filters[1].id      = LZMA_VLI_UNKNOWN;
+		filters[1].options = 0;
+
+		const lzma_stream init = LZMA_STREAM_INIT;
+		strm = init;
+	}
+
+	~Decoder() {
+		kLZMAAllocator.free(0, filters[0].options);
+		lzma_end(&strm);
+	}
+
+	void start() {
+		lzma_ret lzmaRet = LZMA_OK;
+
+		if ((lzmaRet = lzma_raw_decoder(&strm, filters)) != LZMA_OK)
+			throw Exception("Failed to create raw LZMA1 decoder: %d", (int) lzmaRet);
+
+		strm.next_in  = 0;
+		strm.avail_in = 0;
+	}
+};
+
+LZMA1ReadStream::LZMA1ReadStream(SeekableReadStream *input, size_t outputSize, bool disposeInput) :
+	DecompressReadStream(input, outputSize, disposeInput), _decoder(new Decoder), _streamEnd(false) {
+
+	if (!lzma_filter_decoder_is_supported(_decoder->filters[0].id))
+		throw Exception("LZMA1 compression not supported");
+
+	uint32 propsSize;
+	if (lzma_properties_size(&propsSize, &_decoder->filters[0]) != LZMA_OK)
+		throw Exception("Can't get LZMA1 properties size");
+
+	byte props[16];
+	if ((propsSize > sizeof(props)) || (input->read(props, propsSize) != propsSize))
+		throw Exception("Failed to read LZMA1 properties");
+
+	if (lzma_properties_decode(&_decoder->filters[0], &kLZMAAllocator, props, propsSize) != LZMA_OK)
+		throw Exception("Failed to decode LZMA1 properties");
+
+	// The actual compressed data starts after the properties
+	setInputStart();
+
+	_decoder->start();
+}
+
+LZMA1ReadStream::~LZMA1ReadStream() {
+}
+
+void LZMA1ReadStream::restart() {
+	// lzma_raw_decoder() reinitializes an already used lzma_stream
+	_decoder->start();
+
+	_streamEnd = false;
+}
+
+size_t LZMA1ReadStream::decompress(byte *dataPtr, size_t dataSize) {
+	lzma_stream &strm = _decoder->strm;
+
+	strm.next_out  = dataPtr;
+	strm.avail_out = dataSize;
+
+	while ((strm.avail_out == dataSize) && !_streamEnd) {
+		if (strm.avail_in == 0) {
+			const byte *input = 0;
+
+			const size_t inputSize = readInput(input);
+			if (inputSize == 0)
+				break;
+
+			strm.next_in  = input;
+			strm.avail_in = inputSize;
+		}
+
+		const lzma_ret lzmaRet = lzma_code(&strm, LZMA_RUN);
+		if (lzmaRet == LZMA_STREAM_END)
+			_streamEnd = true;
+		else if (lzmaRet != LZMA_OK)
+			throw Exception("Failed to uncompress LZMA1 data: %d", (int) lzmaRet);
+	}
+
+	return dataSize - strm.avail_out;
+}
+
 } // End of namespace Common
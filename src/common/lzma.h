@@ -26,6 +26,8 @@
 #define COMMON_LZMA_H
 
 #include "src/common/types.h"
+#include "src/common/scopedptr.h"
+#include "src/common/decompressreadstream.h"
 
 namespace Common {
 
@@ -58,6 +60,35 @@ byte *decompressLZMA1(const byte *data, size_t inputSize, size_t outputSize, boo
  */
 SeekableReadStream *decompressLZMA1(ReadStream &input, size_t inputSize, size_t outputSize, bool noEndMarker = false);
 
+/** A stream that decompresses LZMA1 on demand.
+ *
+ *  Unlike decompressLZMA1(), this never holds the whole compressed or
+ *  decompressed data in memory. See DecompressReadStream for the details.
+ */
+class LZMA1ReadStream : public DecompressReadStream {
+public:
+	/** Create a decompressing stream.
+	 *
+	 *  @param  input        The compressed input data, including the LZMA1 properties,
+	 *                       from the current position until the end of the stream.
+	 *  @param  outputSize   The size of the decompressed output data.
+	 *  @param  disposeInput Take over ownership of the input stream.
+	 */
+	LZMA1ReadStream(SeekableReadStream *input, size_t outputSize, bool disposeInput = false);
+	~LZMA1ReadStream();
+
+protected:
+	void restart();
+	size_t decompress(byte *dataPtr, size_t dataSize);
+
+private:
+	struct Decoder;
+
+	ScopedPtr<Decoder> _decoder;
+
+	bool _streamEnd;
+};
+
 } // End of namespace Common
 
 #endif // COMMON_LZMA_H
@@ -0,0 +1,245 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Implementing the stream reading interfaces for memory-mapped files.
+ */
+
+#if defined(UNIX)
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+#elif defined(WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+	#include <io.h>
+#endif
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include "src/common/mappedreadfile.h"
+#include "src/common/memreadstream.h"
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/ustring.h"
+#include "src/common/platform.h"
+
+namespace Common {
+
+/** Map the whole file into memory. An empty file results in an empty, but valid mapping. */
+static bool mapFile(std::FILE *file, const byte *&data, size_t &size) {
+	data = 0;
+	size = 0;
+
+#if defined(UNIX)
+	const int fd = fileno(file);
+
+	struct stat fileStat;
+	if ((fstat(fd, &fileStat) != 0) || (fileStat.st_size < 0))
+		return false;
+
+	if ((uint64)((size_t) fileStat.st_size) != (uint64) fileStat.st_size)
+		return false;
+
+	size = (size_t) fileStat.st_size;
+	if (size == 0)
+		return true;
+
+	void *mapping = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (mapping == MAP_FAILED)
+		return false;
+
+	data = reinterpret_cast<const byte *>(mapping);
+	return true;
+
+#elif defined(WIN32)
+	HANDLE fileHandle = (HANDLE) _get_osfhandle(_fileno(file));
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || (fileSize.QuadPart < 0))
+		return false;
+
+	if ((uint64)((size_t) fileSize.QuadPart) != (uint64) fileSize.QuadPart)
+		return false;
+
+	size = (size_t) fileSize.QuadPart;
+	if (size == 0)
+		return true;
+
+	// The view stays valid after the mapping object handle has been closed
+	HANDLE mapping = CreateFileMapping(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+	if (!mapping)
+		return false;
+
+	data = reinterpret_cast<const byte *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	CloseHandle(mapping);
+
+	return data != 0;
+
+#else
+	return false;
+#endif
+}
+
+#if defined(UNIX)
+static void unmapFile(const byte *data, size_t size) {
+	if (data)
+		munmap(const_cast<byte *>(data), size);
+}
+#elif defined(WIN32)
+static void unmapFile(const byte *data, size_t UNUSED(size)) {
+	if (data)
+		UnmapViewOfFile(data);
+}
+#else
+static void unmapFile(const byte *UNUSED(data), size_t UNUSED(size)) {
+}
+#endif
+
+
+MappedReadFile::MappedReadFile() : _data(0), _size(0), _isOpen(false), _eos(false) {
+}
+
+MappedReadFile::MappedReadFile(const UString &fileName) :
+	_data(0), _size(0), _isOpen(false), _eos(false) {
+
+	if (!open(fileName))
+		throw Exception("Can't open file \"%s\"", fileName.c_str());
+}
+
+MappedReadFile::~MappedReadFile() {
+	close();
+}
+
+bool MappedReadFile::open(const UString &fileName) {
+	close();
+
+	std::FILE *file = Platform::openFile(fileName, Platform::kFileModeRead);
+	if (!file)
+		return false;
+
+	// The mapping stays valid after the file itself has been closed
+	_isOpen = mapFile(file, _data, _size);
+
+	std::fclose(file);
+
+	if (!_isOpen) {
+		_data = 0;
+		_size = 0;
+	}
+
+	// The read window covers the whole mapping, and doubles as our current position
+	_bufferPos = _data;
+	_bufferEnd = _data + _size;
+
+	return _isOpen;
+}
+
+void MappedReadFile::close() {
+	unmapFile(_data, _size);
+
+	_data = 0;
+	_size = 0;
+	_eos  = false;
+
+	_bufferPos = 0;
+	_bufferEnd = 0;
+
+	_isOpen = false;
+}
+
+bool MappedReadFile::isOpen() const {
+	return _isOpen;
+}
+
+bool MappedReadFile::eos() const {
+	return _eos;
+}
+
+size_t MappedReadFile::pos() const {
+	return _bufferPos - _data;
+}
+
+size_t MappedReadFile::size() const {
+	return _size;
+}
+
+size_t MappedReadFile::seek(ptrdiff_t offset, Origin whence) {
+	if (!_isOpen)
+		throw Exception(kSeekError);
+
+	const size_t oldPos = pos();
+	const size_t newPos = evalSeek(offset, whence, oldPos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	_bufferPos = _data + newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t MappedReadFile::read(void *dataPtr, size_t dataSize) {
+	if (!_isOpen)
+		return 0;
+
+	assert(dataPtr);
+
+	if (dataSize > getBufferedSize()) {
+		dataSize = getBufferedSize();
+		_eos = true;
+	}
+
+	if (dataSize > 0)
+		std::memcpy(dataPtr, _bufferPos, dataSize);
+
+	_bufferPos += dataSize;
+
+	return dataSize;
+}
+
+size_t MappedReadFile::readAt(size_t offset, void *dataPtr, size_t dataSize) const {
+	if (!_isOpen || (offset >= _size))
+		return 0;
+
+	assert(dataPtr);
+	dataSize = MIN(dataSize, _size - offset);
+
+	std::memcpy(dataPtr, _data + offset, dataSize);
+
+	return dataSize;
+}
+
+SeekableReadStream *MappedReadFile::subStreamAt(size_t offset, size_t dataSize) const {
+	if (!_isOpen || (offset > _size) || (dataSize > (_size - offset)))
+		throw Exception(kReadError);
+
+	return new MemoryReadStream(_data + offset, dataSize);
+}
+
+const byte *MappedReadFile::getData() const {
+	return _data;
+}
+
+} // End of namespace Common
@@ -60,28 +60,26 @@ size_t MemoryReadStream::read(void *dataPtr, size_t dataSize) {
 	assert(dataPtr);
 
 	// Read at most as many bytes as are still available...
-	if (dataSize > _size - _pos) {
-		dataSize = _size - _pos;
+	if (dataSize > getBufferedSize()) {
+		dataSize = getBufferedSize();
 		_eos = true;
 	}
-	std::memcpy(dataPtr, _ptr, dataSize);
+	std::memcpy(dataPtr, _bufferPos, dataSize);
 
-	_ptr += dataSize;
-	_pos += dataSize;
+	_bufferPos += dataSize;
 
 	return dataSize;
 }
 
 size_t MemoryReadStream::seek(ptrdiff_t offset, Origin whence) {
-	assert((size_t)_pos <= _size);
+	const size_t oldPos = pos();
+	assert(oldPos <= _size);
 
-	const size_t oldPos = _pos;
-	const size_t newPos = evalSeek(offset, whence, _pos, 0, size());
+	const size_t newPos = evalSeek(offset, whence, oldPos, 0, size());
 	if (newPos > _size)
 		throw Exception(kSeekError);
 
-	_pos = newPos;
-	_ptr = _ptrOrig.get() + newPos;
+	initBuffer(newPos);
 
 	// Reset end-of-stream flag on a successful seek
 	_eos = false;
@@ -89,12 +87,31 @@ size_t MemoryReadStream::seek(ptrdiff_t offset, Origin whence) {
 	return oldPos;
 }
 
+size_t MemoryReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) const {
+	assert(dataPtr);
+
+	if (offset >= _size)
+		return 0;
+
+	dataSize = MIN(dataSize, _size - offset);
+	std::memcpy(dataPtr, _ptrOrig.get() + offset, dataSize);
+
+	return dataSize;
+}
+
+SeekableReadStream *MemoryReadStream::subStreamAt(size_t offset, size_t dataSize) const {
+	if ((offset > _size) || (dataSize > (_size - offset)))
+		throw Exception(kReadError);
+
+	return new MemoryReadStream(_ptrOrig.get() + offset, dataSize);
+}
+
 bool MemoryReadStream::eos() const {
 	return _eos;
 }
 
 size_t MemoryReadStream::pos() const {
-	return _pos;
+	return _bufferPos - _ptrOrig.get();
 }
 
 size_t MemoryReadStream::size() const {
@@ -69,24 +69,27 @@ public:
 	 *  wraps it. If disposeMemory is true, the MemoryReadStream takes ownership
 	 *  of the buffer and hence delete[]'s it when destructed. */
 	MemoryReadStream(const byte *dataPtr, size_t dataSize, bool disposeMemory = false) :
-		_ptrOrig(dataPtr, disposeMemory), _ptr(dataPtr), _size(dataSize), _pos(0), _eos(false) {
+		_ptrOrig(dataPtr, disposeMemory), _size(dataSize), _eos(false) {
 
+		initBuffer();
 	}
 
 	/** Create a MemoryReadStream around a static string buffer, optionally including the
 	 *  terminating \0. Never disposes its memory. */
 	MemoryReadStream(const char *str, bool useTerminator = false) :
-		_ptrOrig(reinterpret_cast<const byte *>(str), false), _ptr(reinterpret_cast<const byte *>(str)),
-		_size(strlen(str) + (useTerminator ? 1 : 0)), _pos(0), _eos(false) {
+		_ptrOrig(reinterpret_cast<const byte *>(str), false),
+		_size(strlen(str) + (useTerminator ? 1 : 0)), _eos(false) {
 
+		initBuffer();
 	}
 
 	/** Template constructor to create a MemoryReadStream around a static array buffer.
 	 *  Never disposes its memory. */
 	template<size_t N>
 	MemoryReadStream(const byte (&array)[N]) :
-		_ptrOrig(array, false), _ptr(array), _size(N), _pos(0), _eos(false) {
+		_ptrOrig(array, false), _size(N), _eos(false) {
 
+		initBuffer();
 	}
 
 	~MemoryReadStream() { }
@@ -100,17 +103,27 @@ public:
 
 	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
 
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize) const;
+
+	SeekableReadStream *subStreamAt(size_t offset, size_t dataSize) const;
+
 	const byte *getData() const;
 
 private:
 	DisposableArray<const byte> _ptrOrig;
-	const byte *_ptr;
 
 	const size_t _size;
 
-	size_t _pos;
-
 	bool _eos;
+
+	/** Point the read window at the data, from the current position to the end.
+	 *
+	 *  The read window doubles as our current position.
+	 */
+	void initBuffer(size_t pos = 0) {
+		_bufferPos = _ptrOrig.get() + pos;
+		_bufferEnd = _ptrOrig.get() + _size;
+	}
 };
 
 
@@ -22,19 +22,26 @@
  *  Implementing the stream reading interfaces for files.
  */
 
+#if defined(UNIX)
+	#include <unistd.h>
+	#include <errno.h>
+#endif
+
 #include <cassert>
+#include <cstring>
 
 #include "src/common/readfile.h"
+#include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/ustring.h"
 #include "src/common/platform.h"
 
 namespace Common {
 
-ReadFile::ReadFile() : _handle(0), _size(kSizeInvalid) {
+ReadFile::ReadFile() : _handle(0), _size(kSizeInvalid), _eos(false) {
 }
 
-ReadFile::ReadFile(const UString &fileName) : _handle(0), _size(kSizeInvalid) {
+ReadFile::ReadFile(const UString &fileName) : _handle(0), _size(kSizeInvalid), _eos(false) {
 	if (!open(fileName))
 		throw Exception("Can't open file \"%s\"", fileName.c_str());
 }
@@ -78,6 +85,8 @@ bool ReadFile::open(const UString &fileName) {
 
 	_size = (size_t)fileSize;
 
+	_buffer.reset(new byte[kBufferSize]);
+
 	return true;
 }
 
@@ -87,6 +96,15 @@ void ReadFile::close() {
 
 	_handle = 0;
 	_size   = kSizeInvalid;
+	_eos    = false;
+
+	dropBuffer();
+	_buffer.reset();
+}
+
+void ReadFile::dropBuffer() {
+	_bufferPos = 0;
+	_bufferEnd = 0;
 }
 
 bool ReadFile::isOpen() const {
@@ -97,14 +115,15 @@ bool ReadFile::eos() const {
 	if (!_handle)
 		return true;
 
-	return std::feof(_handle) != 0;
+	return _eos;
 }
 
 size_t ReadFile::pos() const {
 	if (!_handle)
 		return kPositionInvalid;
 
-	return (size_t)std::ftell(_handle);
+	// The file position is ahead of us by what's still left in the read-ahead buffer
+	return (size_t)std::ftell(_handle) - getBufferedSize();
 }
 
 size_t ReadFile::size() const {
@@ -121,6 +140,12 @@ size_t ReadFile::seek(ptrdiff_t offset, Origin whence) {
 
 	size_t oldPos = pos();
 
+	if (whence == kOriginCurrent)
+		offset -= getBufferedSize();
+
+	dropBuffer();
+	_eos = false;
+
 	if (std::fseek(_handle, offset, kSeekToWhence[whence]) != 0)
 		throw Exception(kSeekError);
 
@@ -136,7 +161,88 @@ size_t ReadFile::read(void *dataPtr, size_t dataSize) {
 		return 0;
 
 	assert(dataPtr);
-	return std::fread(dataPtr, 1, dataSize, _handle);
+
+	byte *data = reinterpret_cast<byte *>(dataPtr);
+
+	// First, take what we can out of the read-ahead buffer
+	size_t bytesRead = MIN(dataSize, getBufferedSize());
+
+	if (bytesRead > 0) {
+		std::memcpy(data, _bufferPos, bytesRead);
+		_bufferPos += bytesRead;
+	}
+
+	if (bytesRead < dataSize) {
+		if ((dataSize - bytesRead) >= kBufferSize) {
+			// Big reads go directly into the caller's memory
+
+			bytesRead += std::fread(data + bytesRead, 1, dataSize - bytesRead, _handle);
+
+		} else {
+			// Small reads refill the read-ahead buffer
+
+			const size_t bufferSize = std::fread(_buffer.get(), 1, kBufferSize, _handle);
+
+			_bufferPos = _buffer.get();
+			_bufferEnd = _buffer.get() + bufferSize;
+
+			const size_t n = MIN(dataSize - bytesRead, bufferSize);
+
+			std::memcpy(data + bytesRead, _bufferPos, n);
+			_bufferPos += n;
+			bytesRead  += n;
+		}
+	}
+
+	if (bytesRead < dataSize)
+		_eos = true;
+
+	return bytesRead;
+}
+
+size_t ReadFile::readAt(size_t offset, void *dataPtr, size_t dataSize) const {
+	if (!_handle || (offset >= _size))
+		return 0;
+
+	assert(dataPtr);
+	dataSize = MIN(dataSize, _size - offset);
+
+#if defined(UNIX)
+	/* pread() reads directly from the file descriptor, without touching the file
+	 * position. This makes it safe to use from several threads at the same time. */
+
+	const int fd = fileno(_handle);
+
+	size_t bytesRead = 0;
+	while (bytesRead < dataSize) {
+		const ssize_t n = ::pread(fd, reinterpret_cast<byte *>(dataPtr) + bytesRead,
+		                          dataSize - bytesRead, offset + bytesRead);
+
+		if ((n < 0) && (errno == EINTR))
+			continue;
+		if (n <= 0)
+			break;
+
+		bytesRead += n;
+	}
+
+	return bytesRead;
+#else
+	/* No positional reads available. Serialize the callers and restore the
+	 * file position afterwards. */
+
+	boost::mutex::scoped_lock lock(_readAtMutex);
+
+	const long oldPos = std::ftell(_handle);
+	if ((oldPos < 0) || (std::fseek(_handle, offset, SEEK_SET) != 0))
+		return 0;
+
+	const size_t bytesRead = std::fread(dataPtr, 1, dataSize, _handle);
+
+	std::fseek(_handle, oldPos, SEEK_SET);
+
+	return bytesRead;
+#endif
 }
 
 MemoryReadStream *ReadFile::readIntoMemory(const UString &fileName) {
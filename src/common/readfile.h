@@ -28,8 +28,10 @@
 #include <cstdio>
 
 #include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "src/common/types.h"
+#include "src/common/scopedptr.h"
 #include "src/common/readstream.h"
 
 namespace Common {
@@ -37,7 +39,11 @@ namespace Common {
 class UString;
 class MemoryReadStream;
 
-/** A simple streaming file reading class. */
+/** A simple streaming file reading class.
+ *
+ *  Small reads are served out of a read-ahead buffer, so that reading a file
+ *  value by value doesn't need a call into the C library for each value.
+ */
 class ReadFile : boost::noncopyable, public SeekableReadStream {
 public:
 	ReadFile();
@@ -68,13 +74,28 @@ public:
 	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
 	size_t read(void *dataPtr, size_t dataSize);
 
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize) const;
+
 	/** Read the whole file into memory and return a stream of its contents. */
 	static MemoryReadStream *readIntoMemory(const UString &fileName);
 
 
 protected:
+	static const size_t kBufferSize = 4096;
+
 	std::FILE *_handle; ///< The actual file handle.
 	size_t _size;       ///< The file's size.
+
+	bool _eos; ///< Did we try to read past the end of the file?
+
+	/** The read-ahead buffer, made available through the ReadStream read window. */
+	ScopedArray<byte> _buffer;
+
+	/** Discard the data remaining in the read-ahead buffer. */
+	void dropBuffer();
+
+	/** Serializes readAt() on platforms without positional file reads. */
+	mutable boost::mutex _readAtMutex;
 };
 
 } // End of namespace Common
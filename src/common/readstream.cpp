@@ -58,7 +58,7 @@ namespace Common {
 
 const uint32 ReadStream::kEOF;
 
-ReadStream::ReadStream() {
+ReadStream::ReadStream() : _bufferPos(0), _bufferEnd(0) {
 }
 
 ReadStream::~ReadStream() {
@@ -80,6 +80,42 @@ SeekableReadStream::SeekableReadStream() {
 SeekableReadStream::~SeekableReadStream() {
 }
 
+size_t SeekableReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) const {
+	/* Generic fallback for streams that can't do positional reads natively.
+	 * We temporarily move the position indicator, so this isn't thread-safe. */
+
+	SeekableReadStream &stream = const_cast<SeekableReadStream &>(*this);
+
+	const size_t streamSize = size();
+	if ((streamSize != kSizeInvalid) && (offset >= streamSize))
+		return 0;
+
+	const size_t oldPos = stream.seek(offset);
+
+	const size_t bytesRead = stream.read(dataPtr, dataSize);
+
+	stream.seek(oldPos);
+
+	return bytesRead;
+}
+
+MemoryReadStream *SeekableReadStream::readStreamAt(size_t offset, size_t dataSize) const {
+	ScopedArray<byte> buf(new byte[dataSize]);
+
+	if (readAt(offset, buf.get(), dataSize) != dataSize)
+		throw Exception(kReadError);
+
+	return new MemoryReadStream(buf.release(), dataSize, true);
+}
+
+SeekableReadStream *SeekableReadStream::subStreamAt(size_t offset, size_t dataSize) const {
+	const size_t streamSize = size();
+	if ((streamSize == kSizeInvalid) || (offset > streamSize) || (dataSize > (streamSize - offset)))
+		throw Exception(kReadError);
+
+	return new ReadAtSubReadStream(this, offset, offset + dataSize);
+}
+
 size_t SeekableReadStream::evalSeek(ptrdiff_t offset, Origin whence, size_t pos, size_t begin, size_t size) {
 	switch (whence) {
 		case kOriginEnd:
@@ -162,6 +198,84 @@ size_t SeekableSubReadStream::seek(ptrdiff_t offset, Origin whence) {
 	return oldPos;
 }
 
+size_t SeekableSubReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) const {
+	if (offset >= size())
+		return 0;
+
+	dataSize = MIN(dataSize, size() - offset);
+
+	return _parentStream->readAt(_begin + offset, dataPtr, dataSize);
+}
+
+SeekableReadStream *ReadAtSubReadStream::subStreamAt(size_t offset, size_t dataSize) const {
+	if ((offset > size()) || (dataSize > (size() - offset)))
+		throw Exception(kReadError);
+
+	return _parentStream->subStreamAt(_begin + offset, dataSize);
+}
+
+
+ReadAtSubReadStream::ReadAtSubReadStream(const SeekableReadStream *parentStream, size_t begin,
+                                         size_t end, bool disposeParentStream) :
+	_parentStream(parentStream, disposeParentStream), _begin(begin), _end(end), _pos(0), _eos(false) {
+
+	assert(parentStream);
+	assert(_begin <= _end);
+}
+
+ReadAtSubReadStream::~ReadAtSubReadStream() {
+}
+
+bool ReadAtSubReadStream::eos() const {
+	return _eos;
+}
+
+size_t ReadAtSubReadStream::read(void *dataPtr, size_t dataSize) {
+	if (dataSize > (size() - _pos)) {
+		dataSize = size() - _pos;
+		_eos = true;
+	}
+
+	const size_t bytesRead = _parentStream->readAt(_begin + _pos, dataPtr, dataSize);
+	if (bytesRead != dataSize)
+		_eos = true;
+
+	_pos += bytesRead;
+
+	return bytesRead;
+}
+
+size_t ReadAtSubReadStream::pos() const {
+	return _pos;
+}
+
+size_t ReadAtSubReadStream::size() const {
+	return _end - _begin;
+}
+
+size_t ReadAtSubReadStream::seek(ptrdiff_t offset, Origin whence) {
+	assert(_pos <= size());
+
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, size());
+	if (newPos > size())
+		throw Exception(kSeekError);
+
+	_pos = newPos;
+	_eos = false; // reset eos on successful seek
+
+	return oldPos;
+}
+
+size_t ReadAtSubReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) const {
+	if (offset >= size())
+		return 0;
+
+	dataSize = MIN(dataSize, size() - offset);
+
+	return _parentStream->readAt(_begin + offset, dataPtr, dataSize);
+}
+
 
 SeekableSubReadStreamEndian::SeekableSubReadStreamEndian(SeekableReadStream *parentStream,
 		size_t begin, size_t end, bool bigEndian, bool disposeParentStream) :
@@ -50,6 +50,11 @@
 #ifndef COMMON_READSTREAM_H
 #define COMMON_READSTREAM_H
 
+#include <cstring>
+#include <algorithm>
+
+#include <boost/noncopyable.hpp>
+
 #include "src/common/types.h"
 #include "src/common/endianness.h"
 #include "src/common/disposableptr.h"
@@ -90,6 +95,9 @@ public:
 
 	/** Read an unsigned byte from the stream and return it. */
 	byte readByte() {
+		if (_bufferPos != _bufferEnd)
+			return *_bufferPos++;
+
 		byte b;
 		if (read(&b, 1) != 1)
 			throw Exception(kReadError);
@@ -121,8 +129,7 @@ public:
 	 */
 	uint16 readUint16LE() {
 		uint16 val;
-		if (read(&val, 2) != 2)
-			throw Exception(kReadError);
+		readFixed(&val, 2);
 
 		return FROM_LE_16(val);
 	}
@@ -132,8 +139,7 @@ public:
 	 */
 	uint32 readUint32LE() {
 		uint32 val;
-		if (read(&val, 4) != 4)
-			throw Exception(kReadError);
+		readFixed(&val, 4);
 
 		return FROM_LE_32(val);
 	}
@@ -143,8 +149,7 @@ public:
 	 */
 	uint64 readUint64LE() {
 		uint64 val;
-		if (read(&val, 8) != 8)
-			throw Exception(kReadError);
+		readFixed(&val, 8);
 
 		return FROM_LE_64(val);
 	}
@@ -154,8 +159,7 @@ public:
 	 */
 	uint16 readUint16BE() {
 		uint16 val;
-		if (read(&val, 2) != 2)
-			throw Exception(kReadError);
+		readFixed(&val, 2);
 
 		return FROM_BE_16(val);
 	}
@@ -165,8 +169,7 @@ public:
 	 */
 	uint32 readUint32BE() {
 		uint32 val;
-		if (read(&val, 4) != 4)
-			throw Exception(kReadError);
+		readFixed(&val, 4);
 
 		return FROM_BE_32(val);
 	}
@@ -176,8 +179,7 @@ public:
 	 */
 	uint64 readUint64BE() {
 		uint64 val;
-		if (read(&val, 8) != 8)
-			throw Exception(kReadError);
+		readFixed(&val, 8);
 
 		return FROM_BE_64(val);
 	}
@@ -252,12 +254,93 @@ public:
 		return convertIEEEDouble(readUint64BE());
 	}
 
+	/** Read an array of count values of type T, stored in little endian
+	 *  (LSB first) order, from the stream.
+	 *
+	 *  This reads the whole array at once, instead of value by value.
+	 *  When reading fails, a kReadError exception is thrown.
+	 */
+	template<typename T>
+	void readArrayLE(T *array, size_t count) {
+		readArray(array, count);
+
+#if defined(XOREOS_BIG_ENDIAN)
+		swapArray(array, count);
+#endif
+	}
+
+	/** Read an array of count values of type T, stored in big endian
+	 *  (MSB first) order, from the stream.
+	 *
+	 *  This reads the whole array at once, instead of value by value.
+	 *  When reading fails, a kReadError exception is thrown.
+	 */
+	template<typename T>
+	void readArrayBE(T *array, size_t count) {
+		readArray(array, count);
+
+#if defined(XOREOS_LITTLE_ENDIAN)
+		swapArray(array, count);
+#endif
+	}
+
 	/** Read the specified amount of data into a new[]'ed buffer
 	 *  which then is wrapped into a MemoryReadStream.
 	 *
 	 *  When reading fails, a kReadError exception is thrown.
 	 */
 	MemoryReadStream *readStream(size_t dataSize);
+
+protected:
+	/** The data that has already been fetched from the stream, but not yet consumed.
+	 *
+	 *  Streams that have their data in memory, or that read ahead into a
+	 *  buffer, can point this window at that data. The read methods above
+	 *  then take their data directly out of the window, without calling
+	 *  read(). Consuming data out of the window has to be equivalent to
+	 *  read()ing it: subclasses need to take it into account for pos() and
+	 *  treat it as discarded when seeking.
+	 *
+	 *  Streams that don't use the window leave it empty, and all reads go
+	 *  through read().
+	 */
+	const byte *_bufferPos;
+	const byte *_bufferEnd;
+
+	/** Return the number of bytes left in the read window. */
+	size_t getBufferedSize() const {
+		return _bufferEnd - _bufferPos;
+	}
+
+private:
+	/** Read exactly dataSize bytes, preferably out of the read window. */
+	FORCEINLINE void readFixed(void *dataPtr, size_t dataSize) {
+		if (getBufferedSize() >= dataSize) {
+			std::memcpy(dataPtr, _bufferPos, dataSize);
+			_bufferPos += dataSize;
+
+			return;
+		}
+
+		if (read(dataPtr, dataSize) != dataSize)
+			throw Exception(kReadError);
+	}
+
+	template<typename T>
+	void readArray(T *array, size_t count) {
+		const size_t dataSize = count * sizeof(T);
+
+		if ((dataSize > 0) && (read(array, dataSize) != dataSize))
+			throw Exception(kReadError);
+	}
+
+	template<typename T>
+	static void swapArray(T *array, size_t count) {
+		byte *data = reinterpret_cast<byte *>(array);
+
+		for (size_t i = 0; i < count; i++, data += sizeof(T))
+			std::reverse(data, data + sizeof(T));
+	}
 };
 
 
@@ -318,6 +401,44 @@ public:
 		return seek(offset, kOriginCurrent);
 	}
 
+	/** Read data from a specific position within the stream, similar to pread().
+	 *
+	 *  This neither uses nor changes the stream position indicator. For streams
+	 *  that implement this natively (ReadFile, MemoryReadStream and the sub
+	 *  streams thereof), it is safe to call readAt() from several threads at
+	 *  the same time, as long as nobody else is reading from or seeking in the
+	 *  stream concurrently.
+	 *
+	 *  The default implementation falls back to seek() and read() and is not
+	 *  thread-safe.
+	 *
+	 *  @param  offset the position within the stream to read from.
+	 *  @param  dataPtr pointer to a buffer into which the data is read.
+	 *  @param  dataSize number of bytes to be read.
+	 *  @return the number of bytes which were actually read.
+	 */
+	virtual size_t readAt(size_t offset, void *dataPtr, size_t dataSize) const;
+
+	/** Read the specified amount of data from a specific position within the stream
+	 *  into a new[]'ed buffer which then is wrapped into a MemoryReadStream.
+	 *
+	 *  Like readAt(), this does not touch the stream position indicator.
+	 *  When reading fails, a kReadError exception is thrown.
+	 */
+	MemoryReadStream *readStreamAt(size_t offset, size_t dataSize) const;
+
+	/** Return a stream of the specified amount of data at a specific position
+	 *  within the stream, avoiding to copy the data if possible.
+	 *
+	 *  Streams that hold their data in memory (MemoryReadStream, MappedReadFile)
+	 *  return a MemoryReadStream that points directly into their data. All other
+	 *  streams return a ReadAtSubReadStream. Either way, the returned stream
+	 *  references this stream and must not outlive it.
+	 *
+	 *  When the range lies outside the stream, a kReadError exception is thrown.
+	 */
+	virtual SeekableReadStream *subStreamAt(size_t offset, size_t dataSize) const;
+
 	/** Evaluate the seek offset relative to whence into a position from the beginning. */
 	static size_t evalSeek(ptrdiff_t offset, Origin whence, size_t pos, size_t begin, size_t size);
 };
@@ -367,6 +488,8 @@ public:
 
 	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
 
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize) const;
+
 protected:
 	SeekableReadStream *_parentStream;
 
@@ -374,6 +497,45 @@ protected:
 };
 
 
+/** ReadAtSubReadStream provides access to a SeekableReadStream restricted to
+ *  the range [begin, end), exclusively through the parent stream's readAt().
+ *
+ *  Unlike SeekableSubReadStream, it never touches the position indicator of the
+ *  parent stream. Several ReadAtSubReadStreams of the same parent can therefore
+ *  be used at the same time, even from different threads, provided the parent
+ *  stream's readAt() is thread-safe.
+ */
+class ReadAtSubReadStream : boost::noncopyable, public SeekableReadStream {
+public:
+	ReadAtSubReadStream(const SeekableReadStream *parentStream, size_t begin, size_t end,
+	                    bool disposeParentStream = false);
+	~ReadAtSubReadStream();
+
+	bool eos() const;
+
+	size_t read(void *dataPtr, size_t dataSize);
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize) const;
+
+	SeekableReadStream *subStreamAt(size_t offset, size_t dataSize) const;
+
+private:
+	DisposablePtr<const SeekableReadStream> _parentStream;
+
+	size_t _begin;
+	size_t _end;
+
+	size_t _pos;
+
+	bool _eos;
+};
+
+
 /** This is a wrapper around SeekableSubReadStream, but it adds non-endian
  *  read methods whose endianness is set on the stream creation.
  *
@@ -48,6 +48,7 @@ src_common_libcommon_la_SOURCES += \
     src/common/strutil.h \
     src/common/encoding.h \
     src/common/encoding_strings.h \
+    src/common/encoding_tables.h \
     src/common/platform.h \
     src/common/readstream.h \
     src/common/memreadstream.h \
@@ -55,13 +56,16 @@ src_common_libcommon_la_SOURCES += \
     src/common/memwritestream.h \
     src/common/stdinstream.h \
     src/common/stdoutstream.h \
+    src/common/decompressreadstream.h \
     src/common/streamtokenizer.h \
     src/common/readfile.h \
+    src/common/mappedreadfile.h \
     src/common/writefile.h \
     src/common/filepath.h \
     src/common/zipfile.h \
     src/common/binsearch.h \
     src/common/cli.h \
+    src/common/threadpool.h \
     $(EMPTY)
 
 src_common_libcommon_la_SOURCES += \
@@ -83,10 +87,13 @@ src_common_libcommon_la_SOURCES += \
     src/common/memwritestream.cpp \
     src/common/stdinstream.cpp \
     src/common/stdoutstream.cpp \
+    src/common/decompressreadstream.cpp \
     src/common/streamtokenizer.cpp \
     src/common/readfile.cpp \
+    src/common/mappedreadfile.cpp \
     src/common/writefile.cpp \
     src/common/filepath.cpp \
     src/common/zipfile.cpp \
     src/common/cli.cpp \
+    src/common/threadpool.cpp \
     $(EMPTY)
@@ -0,0 +1,144 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A simple pool of worker threads.
+ */
+
+#include <exception>
+
+#include <boost/bind.hpp>
+
+#include "src/common/threadpool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(size_t threadCount) : _threadCount(getThreadCount(threadCount)),
+	_busy(0), _quit(false) {
+
+	if (_threadCount <= 1)
+		return;
+
+	for (size_t i = 0; i < _threadCount; i++)
+		_threads.create_thread(boost::bind(&ThreadPool::threadMain, this));
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+
+		_jobs.clear();
+		_quit = true;
+	}
+
+	_jobAdded.notify_all();
+	_threads.join_all();
+}
+
+size_t ThreadPool::getThreadCount() const {
+	return _threadCount;
+}
+
+size_t ThreadPool::getHardwareThreadCount() {
+	const size_t count = boost::thread::hardware_concurrency();
+
+	return (count > 0) ? count : 1;
+}
+
+size_t ThreadPool::getThreadCount(size_t count) {
+	return (count == 0) ? getHardwareThreadCount() : count;
+}
+
+void ThreadPool::addJob(const Job &job) {
+	if (_threadCount <= 1) {
+		runJob(job);
+		return;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+
+		_jobs.push_back(job);
+	}
+
+	_jobAdded.notify_one();
+}
+
+void ThreadPool::wait() {
+	boost::mutex::scoped_lock lock(_mutex);
+
+	while (!_jobs.empty() || (_busy > 0))
+		_jobsDone.wait(lock);
+
+	if (_exception) {
+		Exception e(*_exception);
+		_exception.reset();
+
+		throw e;
+	}
+}
+
+void ThreadPool::runJob(const Job &job) {
+	Exception error;
+
+	try {
+		job();
+		return;
+	} catch (Exception &e) {
+		error = e;
+	} catch (std::exception &e) {
+		error = Exception(e);
+	} catch (...) {
+		error = Exception("Unknown exception in worker thread");
+	}
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	if (!_exception)
+		_exception.reset(new Exception(error));
+}
+
+void ThreadPool::threadMain() {
+	boost::mutex::scoped_lock lock(_mutex);
+
+	while (true) {
+		while (_jobs.empty() && !_quit)
+			_jobAdded.wait(lock);
+
+		if (_quit)
+			break;
+
+		Job job = _jobs.front();
+		_jobs.pop_front();
+
+		_busy++;
+
+		lock.unlock();
+		runJob(job);
+		lock.lock();
+
+		_busy--;
+
+		if (_jobs.empty() && (_busy == 0))
+			_jobsDone.notify_all();
+	}
+}
+
+} // End of namespace Common
@@ -0,0 +1,105 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A simple pool of worker threads.
+ */
+
+#ifndef COMMON_THREADPOOL_H
+#define COMMON_THREADPOOL_H
+
+#include <deque>
+
+#include <boost/noncopyable.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/scopedptr.h"
+#include "src/common/error.h"
+
+namespace Common {
+
+/** A pool of worker threads, working through a queue of independent jobs.
+ *
+ *  Jobs are run in the order they were added, but, with more than one
+ *  thread, they might of course finish in any order. If a job throws an
+ *  exception, the first such exception is kept and rethrown by wait().
+ *
+ *  A pool with only one thread does not start any threads at all. Instead,
+ *  each job is run directly within addJob(). This makes a ThreadPool(1)
+ *  behave exactly like a simple serial loop.
+ */
+class ThreadPool : boost::noncopyable {
+public:
+	typedef boost::function<void ()> Job;
+
+	/** Create a pool of threadCount worker threads.
+	 *
+	 *  A threadCount of 0 creates as many threads as there are hardware threads.
+	 */
+	ThreadPool(size_t threadCount = 0);
+	~ThreadPool();
+
+	/** Return the number of threads working on jobs. */
+	size_t getThreadCount() const;
+
+	/** Add a job to the queue. */
+	void addJob(const Job &job);
+
+	/** Wait until all jobs in the queue have finished.
+	 *
+	 *  If any of the jobs threw an exception, that exception is rethrown here.
+	 */
+	void wait();
+
+	/** Return the number of threads the hardware can run concurrently, at least 1. */
+	static size_t getHardwareThreadCount();
+
+	/** Return the number of threads to use for a user-requested thread count.
+	 *
+	 *  A count of 0 means "as many as there are hardware threads".
+	 */
+	static size_t getThreadCount(size_t count);
+
+private:
+	size_t _threadCount;
+
+	boost::thread_group _threads;
+
+	std::deque<Job> _jobs;
+	size_t _busy;
+	bool _quit;
+
+	ScopedPtr<Exception> _exception;
+
+	boost::mutex _mutex;
+	boost::condition_variable _jobAdded;
+	boost::condition_variable _jobsDone;
+
+	void threadMain();
+	void runJob(const Job &job);
+};
+
+} // End of namespace Common
+
+#endif // COMMON_THREADPOOL_H
@@ -161,16 +161,24 @@ size_t ZipFile::getFileSize(uint32 index) const {
 SeekableReadStream *ZipFile::getFile(uint32 index, bool tryNoCopy) const {
 	const IFile &file = getIFile(index);
 
+	// Positional view of the whole ZIP, so we don't step on the toes of concurrent readers
+	ScopedPtr<SeekableReadStream> zip(_zip->subStreamAt(0, _zip->size()));
+
 	uint16 compMethod;
 	uint32 compSize;
 	uint32 realSize;
 
-	getFileProperties(*_zip, file, compMethod, compSize, realSize);
+	getFileProperties(*zip, file, compMethod, compSize, realSize);
 
 	if (tryNoCopy && (compMethod == 0))
-		return new SeekableSubReadStream(_zip.get(), _zip->pos(), _zip->pos() + compSize);
+		return _zip->subStreamAt(zip->pos(), compSize);
+
+	if (tryNoCopy && (compMethod == 8)) {
+		// Decompress directly out of the archive, without reading the whole file first
+		return new DeflateReadStream(_zip->subStreamAt(zip->pos(), compSize), realSize, kWindowBitsMaxRaw, true);
+	}
 
-	return decompressFile(*_zip, compMethod, compSize, realSize);
+	return decompressFile(*zip, compMethod, compSize, realSize);
 }
 
 SeekableReadStream *ZipFile::decompressFile(SeekableReadStream &zip, uint32 method,
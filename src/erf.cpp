@@ -22,12 +22,24 @@
  *  Tool to pack ERF (.erf, .mod, .nwm, .sav) archives.
  */
 
+#include <cstdio>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "src/common/scopedptr.h"
+#include "src/common/ptrvector.h"
 #include "src/common/error.h"
 #include "src/common/platform.h"
 #include "src/common/cli.h"
 #include "src/common/readfile.h"
 #include "src/common/writefile.h"
 #include "src/common/filepath.h"
+#include "src/common/threadpool.h"
 
 #include "src/aurora/erfwriter.h"
 #include "src/aurora/util.h"
@@ -39,9 +51,40 @@ static const uint32 kMODID = MKTAG('M', 'O', 'D', ' ');
 static const uint32 kHAKID = MKTAG('H', 'A', 'K', ' ');
 static const uint32 kSAVID = MKTAG('S', 'A', 'V', ' ');
 
+/** The number of files per thread that may be read ahead of the one being written. */
+static const size_t kMaxReadAheadPerThread = 4;
+
+/** A file to pack, read into memory by one of the reader threads. */
+struct PackFile {
+	Common::UString path;
+	Aurora::FileType type;
+
+	Common::ScopedPtr<Common::SeekableReadStream> data;
+
+	bool done;
+	bool failed;
+	Common::Exception error;
+
+	PackFile(const Common::UString &p, Aurora::FileType t) : path(p), type(t), done(false), failed(false) {
+	}
+};
+
+/** The files to pack, in order, shared between the reader threads and the writer. */
+struct PackQueue : boost::noncopyable {
+	Common::PtrVector<PackFile> files;
+
+	boost::mutex mutex;
+	boost::condition_variable fileRead;
+};
+
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Common::UString &archive, std::set<Common::UString> &files, uint32 id,
-                      Aurora::GameID &game);
+                      Common::UString &archive, std::set<Common::UString> &files, uint32 &id,
+                      Aurora::GameID &game, Aurora::ERFWriter::Version &version,
+                      Aurora::ERFWriter::Compression &compression, uint32 &jobs);
+
+void packFiles(const Common::UString &archive, const std::set<Common::UString> &files, uint32 id,
+               Aurora::GameID game, Aurora::ERFWriter::Version version,
+               Aurora::ERFWriter::Compression compression, uint32 jobs);
 
 int main(int argc, char **argv) {
 	initPlatform();
@@ -57,25 +100,15 @@ int main(int argc, char **argv) {
 		Common::UString archive;
 		std::set<Common::UString> files;
 
-		if (!parseCommandLine(args, returnValue, archive, files, id, game))
-			return returnValue;
-
-		Common::WriteFile writeFile(archive);
+		Aurora::ERFWriter::Version version = Aurora::ERFWriter::kERFVersion10;
+		Aurora::ERFWriter::Compression compression = Aurora::ERFWriter::kCompressionNone;
 
-		size_t i = 1;
-		Aurora::ERFWriter erfWriter(id, files.size(), writeFile);
-		for (std::set<Common::UString>::const_iterator iter = files.begin(); iter != files.end(); ++iter, ++i) {
-			std::printf("Packing %u/%u: %s ... ", (uint)i, (uint)files.size(), iter->c_str());
-			std::fflush(stdout);
+		uint32 jobs = 1;
 
-			Common::UString file = *iter;
-			Common::ReadFile fileStream(file);
-
-			const Aurora::FileType type = TypeMan.unaliasFileType(TypeMan.getFileType(file), game);
+		if (!parseCommandLine(args, returnValue, archive, files, id, game, version, compression, jobs))
+			return returnValue;
 
-			erfWriter.add(Common::FilePath::getStem(file), type, fileStream);
-			std::printf("Done\n");
-		}
+		packFiles(archive, files, id, game, version, compression, jobs);
 	} catch (...) {
 		Common::exceptionDispatcherError();
 	}
@@ -84,8 +117,9 @@ int main(int argc, char **argv) {
 }
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Common::UString &archive, std::set<Common::UString> &files, uint32 id,
-                      Aurora::GameID &game) {
+                      Common::UString &archive, std::set<Common::UString> &files, uint32 &id,
+                      Aurora::GameID &game, Aurora::ERFWriter::Version &version,
+                      Aurora::ERFWriter::Compression &compression, uint32 &jobs) {
 	using Common::CLI::NoOption;
 	using Common::CLI::kContinueParsing;
 	using Common::CLI::Parser;
@@ -95,6 +129,7 @@ bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue
 	using Common::CLI::makeEndArgs;
 	using Common::CLI::makeAssigners;
 	using Aurora::GameID;
+	using Aurora::ERFWriter;
 
 	NoOption archiveOpt(false, new ValGetter<Common::UString &>(archive, "output archive"));
 	NoOption filesOpt(true, new ValGetter<std::set<Common::UString> &>(files, "files[...]"));
@@ -118,9 +153,168 @@ bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue
 	                 kContinueParsing,
 	                 makeAssigners(new ValAssigner<uint32>(kSAVID, id)));
 	parser.addSpace();
+	parser.addOption("v10", "Write a V1.0 ERF (default)",
+	                 kContinueParsing,
+	                 makeAssigners(new ValAssigner<ERFWriter::Version>(ERFWriter::kERFVersion10, version)));
+	parser.addOption("v20", "Write a V2.0 ERF",
+	                 kContinueParsing,
+	                 makeAssigners(new ValAssigner<ERFWriter::Version>(ERFWriter::kERFVersion20, version)));
+	parser.addOption("v22", "Write a V2.2 ERF",
+	                 kContinueParsing,
+	                 makeAssigners(new ValAssigner<ERFWriter::Version>(ERFWriter::kERFVersion22, version)));
+	parser.addOption("v30", "Write a V3.0 ERF",
+	                 kContinueParsing,
+	                 makeAssigners(new ValAssigner<ERFWriter::Version>(ERFWriter::kERFVersion30, version)));
+	parser.addSpace();
+	parser.addOption("zlib", "Compress the files with BioWare's zlib variant (V2.2 and V3.0 only)",
+	                 kContinueParsing,
+	                 makeAssigners(new ValAssigner<ERFWriter::Compression>(ERFWriter::kCompressionBioWareZlib,
+	                 compression)));
+	parser.addOption("zlib-headerless", "Compress the files with headerless zlib (V2.2 and V3.0 only)",
+	                 kContinueParsing,
+	                 makeAssigners(new ValAssigner<ERFWriter::Compression>(ERFWriter::kCompressionHeaderlessZlib,
+	                 compression)));
+	parser.addSpace();
+	parser.addOption("jobs", 'j', "Number of threads to read and compress files with "
+	                 "(0 = one per CPU core; default: 1)",
+	                 kContinueParsing, new ValGetter<uint32 &>(jobs, "n"));
+	parser.addSpace();
 	parser.addOption("jade", "Unalias file types according to Jade Empire rules",
 	                 kContinueParsing,
 	                 makeAssigners(new ValAssigner<GameID>(Aurora::kGameIDJade, game)));
 
 	return parser.process(argv);
 }
+
+static void readPackFile(PackQueue &queue, PackFile &file) {
+	Common::SeekableReadStream *data = 0;
+
+	bool failed = false;
+	Common::Exception error;
+
+	try {
+		Common::ReadFile fileStream(file.path);
+
+		data = fileStream.readStream(fileStream.size());
+	} catch (Common::Exception &e) {
+		error = e;
+		failed = true;
+	} catch (std::exception &e) {
+		error = Common::Exception(e);
+		failed = true;
+	} catch (...) {
+		error = Common::Exception("Unknown exception caught");
+		failed = true;
+	}
+
+	boost::mutex::scoped_lock lock(queue.mutex);
+
+	file.data.reset(data);
+	file.done   = true;
+	file.failed = failed;
+	file.error  = error;
+
+	queue.fileRead.notify_all();
+}
+
+static void printSummary(size_t fileCount, uint64 byteCount, const boost::posix_time::time_duration &duration) {
+	const double seconds   = MAX<double>(duration.total_microseconds() / 1000000.0, 0.000001);
+	const double megabytes = byteCount / (1024.0 * 1024.0);
+
+	std::printf("Packed %u files (%.2f MB) in %.2f seconds: %.2f MB/s, %.2f files/s\n",
+	            (uint)fileCount, megabytes, seconds, megabytes / seconds, fileCount / seconds);
+}
+
+void packFiles(const Common::UString &archive, const std::set<Common::UString> &files, uint32 id,
+               Aurora::GameID game, Aurora::ERFWriter::Version version,
+               Aurora::ERFWriter::Compression compression, uint32 jobs) {
+
+	const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+
+	PackQueue queue;
+	std::vector<Common::UString> names;
+
+	names.reserve(files.size());
+	for (std::set<Common::UString>::const_iterator f = files.begin(); f != files.end(); ++f) {
+		queue.files.push_back(new PackFile(*f, TypeMan.unaliasFileType(TypeMan.getFileType(*f), game)));
+
+		names.push_back(TypeMan.addFileType(Common::FilePath::getStem(*f), queue.files.back()->type));
+	}
+
+	/* The reader threads and the ERFWriter's compression threads share the
+	 * thread budget. A pool of a single thread runs its jobs inline, so we only
+	 * split off readers once there are enough threads for two real pools. The
+	 * compression is the more expensive part, so it gets the bigger half. */
+
+	const size_t threads = Common::ThreadPool::getThreadCount(jobs);
+
+	size_t readerThreads = threads, compressThreads = 1;
+	if (compression != Aurora::ERFWriter::kCompressionNone) {
+		readerThreads   = (threads >= 4) ? (threads / 2) : 1;
+		compressThreads = threads - ((readerThreads > 1) ? readerThreads : 0);
+	}
+
+	Common::WriteFile writeFile(archive);
+	Aurora::ERFWriter erfWriter(id, files.size(), writeFile, version, Aurora::LocString(),
+	                            compression, compressThreads, names);
+
+	/* The reader threads read the files into memory, a few files ahead of the
+	 * one we're currently writing. The files are then added to the archive
+	 * (and compressed by the ERFWriter's threads) strictly in order.
+	 *
+	 * With only a single thread, there's nothing to overlap the reading with.
+	 * Then we stream each file straight into the archive instead. */
+
+	Common::ThreadPool readers(readerThreads);
+
+	const bool   threaded  = readers.getThreadCount() > 1;
+	const size_t readAhead = kMaxReadAheadPerThread * readers.getThreadCount();
+
+	size_t nextRead = 0;
+	uint64 byteCount = 0;
+
+	for (size_t i = 0; i < queue.files.size(); i++) {
+		if (threaded)
+			for (; (nextRead < queue.files.size()) && (nextRead <= (i + readAhead)); nextRead++)
+				readers.addJob(boost::bind(&readPackFile, boost::ref(queue), boost::ref(*queue.files[nextRead])));
+
+		PackFile &file = *queue.files[i];
+
+		std::printf("Packing %u/%u: %s ... ", (uint)(i + 1), (uint)queue.files.size(), file.path.c_str());
+		std::fflush(stdout);
+
+		if (!threaded) {
+			Common::ReadFile fileStream(file.path);
+
+			erfWriter.add(Common::FilePath::getStem(file.path), file.type, fileStream);
+			byteCount += fileStream.size();
+
+			std::printf("Done\n");
+			continue;
+		}
+
+		{
+			boost::mutex::scoped_lock lock(queue.mutex);
+
+			while (!file.done)
+				queue.fileRead.wait(lock);
+		}
+
+		if (file.failed)
+			throw file.error;
+
+		erfWriter.add(Common::FilePath::getStem(file.path), file.type, *file.data);
+		byteCount += file.data->size();
+
+		file.data.reset();
+
+		std::printf("Done\n");
+	}
+
+	readers.wait();
+
+	writeFile.flush();
+	writeFile.close();
+
+	printSummary(queue.files.size(), byteCount, boost::posix_time::microsec_clock::universal_time() - start);
+}
@@ -44,8 +44,11 @@ static const uint32 kPixelFlagsIsRGB     = 0x00000040;
 
 namespace Images {
 
-DDS::DDS(Common::SeekableReadStream &dds) {
+DDS::DDS(Common::SeekableReadStream &dds, size_t threadCount) {
 	load(dds);
+
+	// In xoreos-tools, we always want decompressed images
+	decompress(threadCount);
 }
 
 DDS::~DDS() {
@@ -77,9 +80,6 @@ void DDS::load(Common::SeekableReadStream &dds) {
 		e.add("Failed reading DDS file");
 		throw;
 	}
-
-	// In xoreos-tools, we always want decompressed images
-	decompress();
 }
 
 void DDS::readHeader(Common::SeekableReadStream &dds, DataType &dataType) {
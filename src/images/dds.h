@@ -43,7 +43,12 @@ namespace Images {
  */
 class DDS : public Decoder {
 public:
-	DDS(Common::SeekableReadStream &dds);
+	/** Load a DDS image, decompressing it using threadCount threads.
+	 *
+	 *  @param dds The stream to read the image from.
+	 *  @param threadCount The number of threads to use for decompression. 0 = one per CPU core.
+	 */
+	DDS(Common::SeekableReadStream &dds, size_t threadCount = 1);
 	~DDS();
 
 	/** Return true if the data within this stream is a DDS image. */
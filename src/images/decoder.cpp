@@ -24,10 +24,11 @@
 
 #include <cassert>
 
-#include "src/common/scopedptr.h"
+#include <boost/bind.hpp>
+
 #include "src/common/util.h"
 #include "src/common/error.h"
-#include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
 
 #include "src/images/decoder.h"
 #include "src/images/util.h"
@@ -136,7 +137,10 @@ const Decoder::MipMap &Decoder::getMipMap(size_t mipMap, size_t layer) const {
 	return *_mipMaps[index];
 }
 
-void Decoder::decompress(MipMap &out, const MipMap &in, PixelFormat format) {
+/** Mip maps with more rows of 4x4 pixel blocks than this are decompressed in strips. */
+static const uint32 kStripRows = 64;
+
+void Decoder::prepareDecompress(MipMap &out, const MipMap &in, PixelFormat format) {
 	if ((format != kPixelFormatDXT1) &&
 	    (format != kPixelFormatDXT3) &&
 	    (format != kPixelFormatDXT5))
@@ -152,45 +156,96 @@ void Decoder::decompress(MipMap &out, const MipMap &in, PixelFormat format) {
 	out.size   = MAX(out.width * out.height * 4, 64);
 
 	out.data.reset(new byte[out.size]);
+}
+
+void Decoder::decompressRows(MipMap *out, const MipMap *in, PixelFormat format,
+                             uint32 firstRow, uint32 rowCount) {
+
+	/* Decompressing a strip of block rows is the same as decompressing a
+	 * smaller image starting at that row. The last strip takes all the
+	 * remaining pixel rows, including those of a partial block row. */
 
-	Common::ScopedPtr<Common::MemoryReadStream> stream(new Common::MemoryReadStream(in.data.get(), in.size));
+	const uint32 height = out->height;
+	const uint32 pitch  = out->width * 4;
+
+	const uint32 blockSize = (format == kPixelFormatDXT1) ? 8 : 16;
+	const uint32 rowSize   = ((out->width + 3) / 4) * blockSize;
+
+	const uint32 firstLine = firstRow * 4;
+	const uint32 lineCount = ((firstRow + rowCount) >= (height / 4)) ? (height - firstLine) : (rowCount * 4);
+
+	const size_t srcOffset = (size_t) firstRow * rowSize;
+	if (srcOffset > in->size)
+		throw Common::Exception(Common::kReadError);
+
+	byte       *dest    = out->data.get() + (size_t) firstLine * pitch;
+	const byte *src     = in->data.get() + srcOffset;
+	const size_t srcSize = in->size - srcOffset;
 
 	if      (format == kPixelFormatDXT1)
-		decompressDXT1(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT1(dest, src, srcSize, out->width, lineCount, pitch);
 	else if (format == kPixelFormatDXT3)
-		decompressDXT3(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT3(dest, src, srcSize, out->width, lineCount, pitch);
 	else if (format == kPixelFormatDXT5)
-		decompressDXT5(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT5(dest, src, srcSize, out->width, lineCount, pitch);
 }
 
-void Decoder::decompress() {
+void Decoder::decompress(MipMap &out, const MipMap &in, PixelFormat format) {
+	prepareDecompress(out, in, format);
+
+	decompressRows(&out, &in, format, 0, (out.height + 3) / 4);
+}
+
+void Decoder::decompress(size_t threadCount) {
 	if (!isCompressed())
 		return;
 
-	for (MipMaps::iterator m = _mipMaps.begin(); m != _mipMaps.end(); ++m) {
-		MipMap decompressed;
+	MipMaps decompressed;
+	decompressed.reserve(_mipMaps.size());
+
+	Common::ThreadPool pool(threadCount);
+
+	for (MipMaps::const_iterator m = _mipMaps.begin(); m != _mipMaps.end(); ++m) {
+		decompressed.push_back(new MipMap);
 
-		decompress(decompressed, **m, _format);
+		MipMap &out = *decompressed.back();
+		prepareDecompress(out, **m, _format);
 
-		decompressed.swap(**m);
+		/* Only split a mip map into strips when there are actually several threads
+		 * to work on them. Strips always start on a full row of blocks. */
+
+		const uint32 fullRows   = out.height / 4;
+		const uint32 stripCount = (pool.getThreadCount() > 1) ? MAX<uint32>(fullRows / kStripRows, 1) : 1;
+
+		for (uint32 i = 0; i < stripCount; i++) {
+			const uint32 firstRow = i * kStripRows;
+			const uint32 rowCount = (i == (stripCount - 1)) ? ((out.height + 3) / 4 - firstRow) : kStripRows;
+
+			pool.addJob(boost::bind(&Decoder::decompressRows, &out, *m, _format, firstRow, rowCount));
+		}
 	}
 
+	pool.wait();
+
+	for (size_t i = 0; i < _mipMaps.size(); i++)
+		decompressed[i]->swap(*_mipMaps[i]);
+
 	_format = kPixelFormatR8G8B8A8;
 }
 
-void Decoder::dumpTGA(const Common::UString &fileName) const {
+void Decoder::dumpTGA(const Common::UString &fileName, bool rle) const {
 	if (_mipMaps.size() < 1)
 		throw Common::Exception("Image contains no mip maps");
 
 	if (!isCompressed()) {
-		Images::dumpTGA(fileName, *this);
+		Images::dumpTGA(fileName, *this, rle);
 		return;
 	}
 
 	Decoder decoder(*this);
 	decoder.decompress();
 
-	Images::dumpTGA(fileName, decoder);
+	Images::dumpTGA(fileName, decoder, rle);
 }
 
 void Decoder::flipHorizontally() {
@@ -85,8 +85,8 @@ public:
 	/** Return TXI data, if embedded in the image. */
 	virtual Common::SeekableReadStream *getTXI() const;
 
-	/** Dump the image into a TGA. */
-	void dumpTGA(const Common::UString &fileName) const;
+	/** Dump the image into a TGA, optionally run-length encoded. */
+	void dumpTGA(const Common::UString &fileName, bool rle = false) const;
 
 	/** Flip the whole image horizontally. */
 	void flipHorizontally();
@@ -108,10 +108,22 @@ protected:
 	/** Is the image data compressed? */
 	bool isCompressed() const;
 
-	/** Manually decompress the texture image data. */
-	void decompress();
+	/** Manually decompress the texture image data.
+	 *
+	 *  The mip maps are decompressed using threadCount threads in parallel,
+	 *  with big mip maps split into strips of block rows. A threadCount of 0
+	 *  uses as many threads as there are CPU cores.
+	 */
+	void decompress(size_t threadCount = 1);
 
 	static void decompress(MipMap &out, const MipMap &in, PixelFormat format);
+
+private:
+	/** Check that the mip map can be decompressed and allocate the output mip map. */
+	static void prepareDecompress(MipMap &out, const MipMap &in, PixelFormat format);
+	/** Decompress rowCount rows of 4x4 pixel blocks, starting at firstRow. */
+	static void decompressRows(MipMap *out, const MipMap *in, PixelFormat format,
+	                           uint32 firstRow, uint32 rowCount);
 };
 
 } // End of namespace Images
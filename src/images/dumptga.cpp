@@ -22,7 +22,7 @@
  *  A simple TGA image dumper.
  */
 
-#include <cstdio>
+#include <cstring>
 
 #include "src/common/scopedptr.h"
 #include "src/common/error.h"
@@ -33,68 +33,156 @@
 
 namespace Images {
 
-static void writePixel(Common::WriteStream &file, const byte *&data, PixelFormat format) {
-	if (format == kPixelFormatR8G8B8) {
-		file.writeByte(data[2]);
-		file.writeByte(data[1]);
-		file.writeByte(data[0]);
-		file.writeByte(0xFF);
-		data += 3;
-	} else if (format == kPixelFormatB8G8R8) {
-		file.writeByte(data[0]);
-		file.writeByte(data[1]);
-		file.writeByte(data[2]);
-		file.writeByte(0xFF);
-		data += 3;
+/** Return the number of bytes a pixel takes up in the image data, or 0 if unsupported. */
+static uint32 getBytesPerPixel(PixelFormat format) {
+	switch (format) {
+		case kPixelFormatR8G8B8:
+		case kPixelFormatB8G8R8:
+			return 3;
+
+		case kPixelFormatR8G8B8A8:
+		case kPixelFormatB8G8R8A8:
+			return 4;
+
+		case kPixelFormatR5G6B5:
+		case kPixelFormatA1R5G5B5:
+		case kPixelFormatDepth16:
+			return 2;
+
+		default:
+			break;
+	}
+
+	return 0;
+}
+
+/** Convert one row of pixels into the 32-bit BGRA the TGA stores.
+ *
+ *  The loops are kept simple and branch-free, so that the compiler
+ *  can vectorize them.
+ */
+static void convertRow(byte *row, const byte *data, uint32 width, PixelFormat format) {
+	if (format == kPixelFormatB8G8R8A8) {
+		std::memcpy(row, data, width * 4);
+
 	} else if (format == kPixelFormatR8G8B8A8) {
-		file.writeByte(data[2]);
-		file.writeByte(data[1]);
-		file.writeByte(data[0]);
-		file.writeByte(data[3]);
-		data += 4;
-	} else if (format == kPixelFormatB8G8R8A8) {
-		file.writeByte(data[0]);
-		file.writeByte(data[1]);
-		file.writeByte(data[2]);
-		file.writeByte(data[3]);
-		data += 4;
+		for (uint32 x = 0; x < width; x++, data += 4, row += 4) {
+			const uint32 color = READ_LE_UINT32(data);
+
+			WRITE_LE_UINT32(row, (color & 0xFF00FF00) | ((color >> 16) & 0xFF) | ((color & 0xFF) << 16));
+		}
+
+	} else if (format == kPixelFormatR8G8B8) {
+		for (uint32 x = 0; x < width; x++, data += 3, row += 4) {
+			row[0] = data[2];
+			row[1] = data[1];
+			row[2] = data[0];
+			row[3] = 0xFF;
+		}
+
+	} else if (format == kPixelFormatB8G8R8) {
+		for (uint32 x = 0; x < width; x++, data += 3, row += 4) {
+			row[0] = data[0];
+			row[1] = data[1];
+			row[2] = data[2];
+			row[3] = 0xFF;
+		}
+
 	} else if (format == kPixelFormatR5G6B5) {
-		uint16 color = READ_LE_UINT16(data);
-		file.writeByte( color & 0x001F);
-		file.writeByte((color & 0x07E0) >>  5);
-		file.writeByte((color & 0xF800) >> 11);
-		file.writeByte(0xFF);
-		data += 2;
+		for (uint32 x = 0; x < width; x++, data += 2, row += 4) {
+			const uint16 color = READ_LE_UINT16(data);
+
+			row[0] =  color & 0x001F;
+			row[1] = (color & 0x07E0) >>  5;
+			row[2] = (color & 0xF800) >> 11;
+			row[3] = 0xFF;
+		}
+
 	} else if (format == kPixelFormatA1R5G5B5) {
-		uint16 color = READ_LE_UINT16(data);
-		file.writeByte( color & 0x001F);
-		file.writeByte((color & 0x03E0) >>  5);
-		file.writeByte((color & 0x7C00) >> 10);
-		file.writeByte((color & 0x8000) ? 0xFF : 0x00);
-		data += 2;
+		for (uint32 x = 0; x < width; x++, data += 2, row += 4) {
+			const uint16 color = READ_LE_UINT16(data);
+
+			row[0] =  color & 0x001F;
+			row[1] = (color & 0x03E0) >>  5;
+			row[2] = (color & 0x7C00) >> 10;
+			row[3] = (color & 0x8000) ? 0xFF : 0x00;
+		}
+
 	} else if (format == kPixelFormatDepth16) {
-		uint16 color = READ_LE_UINT16(data);
-		file.writeByte(color / 128);
-		file.writeByte(color / 128);
-		file.writeByte(color / 128);
-		file.writeByte((color >= 0x7FFF) ? 0x00 : 0xFF);
+		for (uint32 x = 0; x < width; x++, data += 2, row += 4) {
+			const uint16 color = READ_LE_UINT16(data);
+
+			row[0] = color / 128;
+			row[1] = color / 128;
+			row[2] = color / 128;
+			row[3] = (color >= 0x7FFF) ? 0x00 : 0xFF;
+		}
 
-		data += 2;
 	} else
 		throw Common::Exception("Unsupported pixel format: %d", (int) format);
+}
+
+static inline bool isSamePixel(const byte *row, uint32 a, uint32 b) {
+	return std::memcmp(row + a * 4, row + b * 4, 4) == 0;
+}
+
+/** Run-length encode one row of 32-bit pixels into TGA RLE packets.
+ *
+ *  Packets never cross a row boundary, as the TGA specification recommends.
+ *  The output buffer needs to hold at least getRLEBufferSize(width) bytes.
+ *
+ *  @return The number of bytes written into the output buffer.
+ */
+static uint32 encodeRLERow(byte *out, const byte *row, uint32 width) {
+	const byte *start = out;
+
+	uint32 x = 0;
+	while (x < width) {
+		// A run of at least two identical pixels becomes a run packet
+		uint32 run = 1;
+		while ((x + run < width) && (run < 128) && isSamePixel(row, x, x + run))
+			run++;
+
+		if (run >= 2) {
+			*out++ = 0x80 | (run - 1);
+			std::memcpy(out, row + x * 4, 4);
+
+			out += 4;
+			x   += run;
+			continue;
+		}
+
+		// Otherwise, collect raw pixels until the next run starts
+		uint32 raw = 1;
+		while ((x + raw < width) && (raw < 128) &&
+		       !((x + raw + 1 < width) && isSamePixel(row, x + raw, x + raw + 1)))
+			raw++;
+
+		*out++ = raw - 1;
+		std::memcpy(out, row + x * 4, raw * 4);
+
+		out += raw * 4;
+		x   += raw;
+	}
 
+	return out - start;
 }
 
-static Common::WriteStream *openTGA(const Common::UString &fileName, int width, int height) {
+/** Return the worst-case size of an RLE-encoded row: all raw packets. */
+static uint32 getRLEBufferSize(uint32 width) {
+	return width * 4 + (width + 127) / 128;
+}
+
+static Common::WriteStream *openTGA(const Common::UString &fileName, int width, int height, bool rle) {
 	Common::WriteFile *file = new Common::WriteFile(fileName);
 
-	file->writeByte(0);     // ID Length
-	file->writeByte(0);     // Palette size
-	file->writeByte(2);     // Unmapped RGB
-	file->writeUint32LE(0); // Color map
-	file->writeByte(0);     // Color map
-	file->writeUint16LE(0); // X
-	file->writeUint16LE(0); // Y
+	file->writeByte(0);            // ID Length
+	file->writeByte(0);            // Palette size
+	file->writeByte(rle ? 10 : 2); // Unmapped RGB, optionally RLE-compressed
+	file->writeUint32LE(0);        // Color map
+	file->writeByte(0);            // Color map
+	file->writeUint16LE(0);        // X
+	file->writeUint16LE(0);        // Y
 
 	file->writeUint16LE(width);
 	file->writeUint16LE(height);
@@ -106,18 +194,29 @@ static Common::WriteStream *openTGA(const Common::UString &fileName, int width,
 	return file;
 }
 
-static void writeMipMap(Common::WriteStream &stream, const Decoder::MipMap &mipMap, PixelFormat format) {
+static void writeMipMap(Common::WriteStream &stream, const Decoder::MipMap &mipMap, PixelFormat format,
+                        byte *row, byte *rleRow) {
+
+	const uint32 rowSize = getBytesPerPixel(format) * mipMap.width;
+
 	const byte *data = mipMap.data.get();
+	for (int y = 0; y < mipMap.height; y++, data += rowSize) {
+		convertRow(row, data, mipMap.width, format);
 
-	uint32 count = mipMap.width * mipMap.height;
-	while (count-- > 0)
-		writePixel(stream, data, format);
+		if (rleRow)
+			stream.write(rleRow, encodeRLERow(rleRow, row, mipMap.width));
+		else
+			stream.write(row, mipMap.width * 4);
+	}
 }
 
-void dumpTGA(const Common::UString &fileName, const Decoder &image) {
+void dumpTGA(const Common::UString &fileName, const Decoder &image, bool rle) {
 	if ((image.getLayerCount() < 1) || (image.getMipMapCount() < 1))
 		throw Common::Exception("No image");
 
+	if (getBytesPerPixel(image.getFormat()) == 0)
+		throw Common::Exception("Unsupported pixel format: %d", (int) image.getFormat());
+
 	int32 width  = image.getMipMap(0, 0).width;
 	int32 height = 0;
 
@@ -130,10 +229,13 @@ void dumpTGA(const Common::UString &fileName, const Decoder &image) {
 		height += mipMap.height;
 	}
 
-	Common::ScopedPtr<Common::WriteStream> file(openTGA(fileName, width, height));
+	Common::ScopedArray<byte> row(new byte[width * 4]);
+	Common::ScopedArray<byte> rleRow(rle ? new byte[getRLEBufferSize(width)] : 0);
+
+	Common::ScopedPtr<Common::WriteStream> file(openTGA(fileName, width, height, rle));
 
 	for (size_t i = 0; i < image.getLayerCount(); i++)
-		writeMipMap(*file, image.getMipMap(0, i), image.getFormat());
+		writeMipMap(*file, image.getMipMap(0, i), image.getFormat(), row.get(), rleRow.get());
 
 	file->flush();
 }
@@ -23,197 +23,194 @@
  */
 
 #include "src/common/util.h"
-#include "src/common/readstream.h"
+#include "src/common/error.h"
+#include "src/common/endianness.h"
 
 #include "src/images/s3tc.h"
 
 namespace Images {
 
-static uint32 convert565To8888(uint16 color) {
-	return ((color & 0x1F) << 11) | ((color & 0x7E0) << 13) | ((color & 0xF800) << 16) | 0xFF;
+/* The interpolated colors used to be calculated with floating point math,
+ * using the weights 0.333333f and 0.666666f. Since these are slightly smaller
+ * than the real 1/3 and 2/3, and the results were truncated, a result that
+ * should be exactly integer ended up one less whenever the second color
+ * channel value was the larger one. The integer math here reproduces those
+ * results exactly, for all possible pairs of values. */
+
+/** Interpolate between two color channel values, with weights of thirds. */
+static uint32 interpolateChannelThirds(uint32 c0, uint32 c1, uint32 w0, uint32 w1) {
+	return (w0 * c0 + w1 * c1 - ((c1 > c0) ? 1 : 0)) / 3;
 }
 
-static uint32 interpolate32(double weight, uint32 color_0, uint32 color_1) {
-	byte r[3], g[3], b[3], a[3];
-	r[0] = color_0 >> 24;
-	r[1] = color_1 >> 24;
-	r[2] = (byte)((1.0f - weight) * (double)r[0] + weight * (double)r[1]);
-	g[0] = (color_0 >> 16) & 0xFF;
-	g[1] = (color_1 >> 16) & 0xFF;
-	g[2] = (byte)((1.0f - weight) * (double)g[0] + weight * (double)g[1]);
-	b[0] = (color_0 >> 8) & 0xFF;
-	b[1] = (color_1 >> 8) & 0xFF;
-	b[2] = (byte)((1.0f - weight) * (double)b[0] + weight * (double)b[1]);
-	a[0] = color_0 & 0xFF;
-	a[1] = color_1 & 0xFF;
-	a[2] = (byte)((1.0f - weight) * (double)a[0] + weight * (double)a[1]);
-	return r[2] << 24 | g[2] << 16 | b[2] << 8 | a[2];
+/** Interpolate between two RGBA colors, with weights of thirds. */
+static uint32 interpolateThirds(uint32 color0, uint32 color1, uint32 w0, uint32 w1) {
+	uint32 color = 0;
+	for (uint32 shift = 0; shift < 32; shift += 8)
+		color |= interpolateChannelThirds((color0 >> shift) & 0xFF, (color1 >> shift) & 0xFF, w0, w1) << shift;
+
+	return color;
 }
 
-struct DXT1Texel {
-	uint16 color_0;
-	uint16 color_1;
-	uint32 pixels;
-};
-
-#define READ_DXT1_TEXEL(x) \
-	x.color_0 = src.readUint16LE(); \
-	x.color_1 = src.readUint16LE(); \
-	x.pixels = src.readUint32BE()
-
-void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch) {
-	for (int32 ty = height; ty > 0; ty -= 4) {
-		for (uint32 tx = 0; tx < width; tx += 4) {
-			DXT1Texel tex;
-			READ_DXT1_TEXEL(tex);
-			uint32 blended[4];
-
-			blended[0] = convert565To8888(tex.color_0);
-			blended[1] = convert565To8888(tex.color_1);
-
-			if (tex.color_0 > tex.color_1) {
-				blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-				blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-			} else {
-				blended[2] = interpolate32(0.5f, blended[0], blended[1]);
-				blended[3] = 0;
-			}
-
-			uint32 cpx = tex.pixels;
-			uint32 blockWidth = MIN<uint32>(width, 4);
-			uint32 blockHeight = MIN<uint32>(height, 4);
-
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					const uint32 destX = tx + x;
-					const uint32 destY = height - 1 - (ty - blockHeight + y);
-
-					const uint32 pixel =  blended[cpx & 3];
-
-					cpx >>= 2;
-
-					if ((destX < width) && (destY < height))
-						WRITE_BE_UINT32(dest + destY * pitch + destX * 4, pixel);
-				}
-			}
-		}
+/** Interpolate between two RGBA colors, halfway. */
+static uint32 interpolateHalf(uint32 color0, uint32 color1) {
+	uint32 color = 0;
+	for (uint32 shift = 0; shift < 32; shift += 8)
+		color |= ((((color0 >> shift) & 0xFF) + ((color1 >> shift) & 0xFF)) / 2) << shift;
+
+	return color;
+}
+
+static uint32 convert565To8888(uint16 color, uint32 alpha) {
+	return ((color & 0x1F) << 11) | ((color & 0x7E0) << 13) | ((color & 0xF800) << 16) | alpha;
+}
+
+/** Build the four colors of a color block.
+ *
+ *  @param colors The four colors, as RGBA.
+ *  @param block The color block data.
+ *  @param dxt1 Is this a DXT1 block, with opaque colors and an optional transparent color?
+ */
+static void getColors(uint32 (&colors)[4], const byte *block, bool dxt1) {
+	const uint16 color0 = READ_LE_UINT16(block + 0);
+	const uint16 color1 = READ_LE_UINT16(block + 2);
+
+	const uint32 alpha = dxt1 ? 0xFF : 0x00;
+
+	colors[0] = convert565To8888(color0, alpha);
+	colors[1] = convert565To8888(color1, alpha);
+
+	if (!dxt1 || (color0 > color1)) {
+		colors[2] = interpolateThirds(colors[0], colors[1], 2, 1);
+		colors[3] = interpolateThirds(colors[0], colors[1], 1, 2);
+	} else {
+		colors[2] = interpolateHalf(colors[0], colors[1]);
+		colors[3] = 0;
+	}
+}
+
+/** Build the eight alpha values of a DXT5 alpha block. */
+static void getAlphas(byte (&alphas)[8], byte alpha0, byte alpha1) {
+	alphas[0] = alpha0;
+	alphas[1] = alpha1;
+
+	if (alpha0 > alpha1) {
+		for (uint i = 1; i < 7; i++)
+			alphas[i + 1] = ((7 - i) * alpha0 + i * alpha1 + 3) / 7;
+	} else {
+		for (uint i = 1; i < 5; i++)
+			alphas[i + 1] = ((5 - i) * alpha0 + i * alpha1 + 2) / 5;
+
+		alphas[6] = 0;
+		alphas[7] = 255;
 	}
 }
 
-struct DXT23Texel : public DXT1Texel {
-	uint16 alpha[4];
-};
-
-#define READ_DXT3_TEXEL(x) \
-	x.alpha[0] = src.readUint16LE(); \
-	x.alpha[1] = src.readUint16LE(); \
-	x.alpha[2] = src.readUint16LE(); \
-	x.alpha[3] = src.readUint16LE(); \
-	READ_DXT1_TEXEL(x)
-
-void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch) {
-	for (int32 ty = height; ty > 0; ty -= 4) {
-		for (uint32 tx = 0; tx < width; tx += 4) {
-			DXT23Texel tex;
-			uint32 blended[4];
-			READ_DXT3_TEXEL(tex);
-
-			blended[0] = convert565To8888(tex.color_0) & 0xFFFFFF00;
-			blended[1] = convert565To8888(tex.color_1) & 0xFFFFFF00;
-			blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-			blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-
-			uint32 cpx = tex.pixels;
-			uint32 blockWidth = MIN<uint32>(width, 4);
-			uint32 blockHeight = MIN<uint32>(height, 4);
-
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					const uint32 destX = tx + x;
-					const uint32 destY = height - 1 - (ty - blockHeight + y);
-
-					const uint32 alpha = (tex.alpha[y] >> (x * 4)) & 0xF;
-					const uint32 pixel = blended[cpx & 3] | alpha << 4;
-
-					cpx >>= 2;
-
-					if ((destX < width) && (destY < height))
-						WRITE_BE_UINT32(dest + destY * pitch + destX * 4, pixel);
-				}
-			}
+/** Decode one block, writing the pixels within the image. */
+template<DXTFormat kFormat>
+static void decodeBlock(byte *dest, const byte *block,
+                        uint32 tx, int32 ty, uint32 width, uint32 height, uint32 pitch) {
+
+	static const size_t kColorOffset = (kFormat == kDXT1) ? 0 : 8;
+
+	/* The pixels are written as big endian RGBA. Since swapping the bytes of
+	 * the colors and the alpha values separately, then combining them, gives the
+	 * same result, we can do all the swapping before going through the pixels. */
+
+	uint32 colors[4];
+	getColors(colors, block + kColorOffset, kFormat == kDXT1);
+
+	for (size_t i = 0; i < 4; i++)
+		colors[i] = TO_BE_32(colors[i]);
+
+	uint32 alphas[8];
+	uint64 alphaBits = 0;
+	if (kFormat == kDXT5) {
+		byte alphaValues[8];
+		getAlphas(alphaValues, block[0], block[1]);
+
+		for (size_t i = 0; i < 8; i++)
+			alphas[i] = TO_BE_32((uint32) alphaValues[i]);
+
+		alphaBits = READ_LE_UINT32(block + 2) | ((uint64) READ_LE_UINT16(block + 6) << 32);
+	}
+
+	/* The color indices are read big endian. Blocks in images that are
+	 * narrower or shorter than 4 pixels only use their first pixels. */
+
+	uint32 indices = READ_BE_UINT32(block + kColorOffset + 4);
+
+	const uint32 blockWidth  = MIN<uint32>(width , 4);
+	const uint32 blockHeight = MIN<uint32>(height, 4);
+
+	const uint32 copyWidth = MIN<uint32>(blockWidth, width - tx);
+
+	for (uint32 y = 0; y < blockHeight; y++, indices >>= 2 * blockWidth) {
+		const uint32 destY = height - 1 - (ty - blockHeight + y);
+		if (destY >= height)
+			continue;
+
+		const uint16 alphaRow = (kFormat == kDXT3) ? READ_LE_UINT16(block + y * 2) : 0;
+
+		byte *destLine = dest + destY * pitch + tx * 4;
+		for (uint32 x = 0; x < copyWidth; x++) {
+			uint32 pixel = colors[(indices >> (x * 2)) & 3];
+
+			if (kFormat == kDXT3)
+				pixel |= TO_BE_32((uint32) (((alphaRow >> (x * 4)) & 0xF) << 4));
+			if (kFormat == kDXT5)
+				pixel |= alphas[(alphaBits >> (3 * (4 * (3 - y) + x))) & 7];
+
+			WRITE_UINT32(destLine + x * 4, pixel);
 		}
 	}
 }
 
-struct DXT45Texel : public DXT1Texel {
-	byte alpha_0;
-	byte alpha_1;
-	uint64 alphabl;
-};
+template<DXTFormat kFormat>
+static void decodeBlocks(byte *dest, const byte *src, size_t srcSize,
+                         uint32 width, uint32 height, uint32 pitch) {
+
+	static const size_t kBlockSize = (kFormat == kDXT1) ? 8 : 16;
 
-static uint64 readUint48LE(Common::SeekableReadStream &src) {
-	uint64 output = src.readUint32LE();
-	return output | ((uint64)src.readUint16LE() << 32);
+	const size_t blockCount = ((width + 3) / 4) * ((height + 3) / 4);
+	if ((blockCount * kBlockSize) > srcSize)
+		throw Common::Exception(Common::kReadError);
+
+	for (int32 ty = height; ty > 0; ty -= 4)
+		for (uint32 tx = 0; tx < width; tx += 4, src += kBlockSize)
+			decodeBlock<kFormat>(dest, src, tx, ty, width, height, pitch);
 }
 
-#define READ_DXT5_TEXEL(x) \
-	x.alpha_0 = src.readByte(); \
-	x.alpha_1 = src.readByte(); \
-	x.alphabl = readUint48LE(src); \
-	READ_DXT1_TEXEL(x)
-
-void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch) {
-	for (int32 ty = height; ty > 0; ty -= 4) {
-		for (uint32 tx = 0; tx < width; tx += 4) {
-			uint32 blended[4];
-			byte alphab[8];
-			DXT45Texel tex;
-			READ_DXT5_TEXEL(tex);
-
-			alphab[0] = tex.alpha_0;
-			alphab[1] = tex.alpha_1;
-
-			if (tex.alpha_0 > tex.alpha_1) {
-				alphab[2] = (byte)((6.0f * (double)alphab[0] + 1.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[3] = (byte)((5.0f * (double)alphab[0] + 2.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[4] = (byte)((4.0f * (double)alphab[0] + 3.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[5] = (byte)((3.0f * (double)alphab[0] + 4.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[6] = (byte)((2.0f * (double)alphab[0] + 5.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[7] = (byte)((1.0f * (double)alphab[0] + 6.0f * (double)alphab[1] + 3.0f) / 7.0f);
-			} else {
-				alphab[2] = (byte)((4.0f * (double)alphab[0] + 1.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[3] = (byte)((3.0f * (double)alphab[0] + 2.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[4] = (byte)((2.0f * (double)alphab[0] + 3.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[5] = (byte)((1.0f * (double)alphab[0] + 4.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[6] = 0;
-				alphab[7] = 255;
-			}
-
-			blended[0] = convert565To8888(tex.color_0) & 0xFFFFFF00;
-			blended[1] = convert565To8888(tex.color_1) & 0xFFFFFF00;
-			blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-			blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-
-			uint32 cpx = tex.pixels;
-			uint32 blockWidth = MIN<uint32>(width, 4);
-			uint32 blockHeight = MIN<uint32>(height, 4);
-
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					const uint32 destX = tx + x;
-					const uint32 destY = height - 1 - (ty - blockHeight + y);
-
-					const uint32 alpha = alphab[(tex.alphabl >> (3 * (4 * (3 - y) + x))) & 7];
-					const uint32 pixel = blended[cpx & 3] | alpha;
-
-					cpx >>= 2;
-
-					if ((destX < width) && (destY < height))
-						WRITE_BE_UINT32(dest + destY * pitch + destX * 4, pixel);
-				}
-			}
-		}
+void decompressDXT(byte *dest, const byte *src, size_t srcSize, DXTFormat format,
+                   uint32 width, uint32 height, uint32 pitch) {
+
+	switch (format) {
+		case kDXT1:
+			decodeBlocks<kDXT1>(dest, src, srcSize, width, height, pitch);
+			break;
+
+		case kDXT3:
+			decodeBlocks<kDXT3>(dest, src, srcSize, width, height, pitch);
+			break;
+
+		case kDXT5:
+			decodeBlocks<kDXT5>(dest, src, srcSize, width, height, pitch);
+			break;
+
+		default:
+			throw Common::Exception("Invalid DXT format %u", (uint) format);
 	}
 }
 
+void decompressDXT1(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch) {
+	decompressDXT(dest, src, srcSize, kDXT1, width, height, pitch);
+}
+
+void decompressDXT3(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch) {
+	decompressDXT(dest, src, srcSize, kDXT3, width, height, pitch);
+}
+
+void decompressDXT5(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch) {
+	decompressDXT(dest, src, srcSize, kDXT5, width, height, pitch);
+}
+
 } // End of namespace Images
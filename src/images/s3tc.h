@@ -27,15 +27,31 @@
 
 #include "src/common/types.h"
 
-namespace Common {
-	class SeekableReadStream;
-}
-
 namespace Images {
 
-void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
-void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
-void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
+enum DXTFormat {
+	kDXT1,
+	kDXT3,
+	kDXT5
+};
+
+/** Decompress DXTn compressed image data into RGBA8888.
+ *
+ *  @param dest The buffer to write the pixels into, at least height * pitch bytes.
+ *  @param src The compressed data, a sequence of 4x4 pixel blocks.
+ *  @param srcSize The size of the compressed data. If it's too small
+ *                 for the image, a kReadError exception is thrown.
+ *  @param format The DXTn variant the data is compressed with.
+ *  @param width The width of the image in pixels.
+ *  @param height The height of the image in pixels.
+ *  @param pitch The number of bytes per line in dest.
+ */
+void decompressDXT(byte *dest, const byte *src, size_t srcSize, DXTFormat format,
+                   uint32 width, uint32 height, uint32 pitch);
+
+void decompressDXT1(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch);
+void decompressDXT3(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch);
+void decompressDXT5(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch);
 
 } // End of namespace Images
 
@@ -39,14 +39,14 @@ static const byte kEncodingSwizzledBGRA = 0x0C;
 
 namespace Images {
 
-TPC::TPC(Common::SeekableReadStream &tpc) : _txiDataSize(0) {
-	load(tpc);
+TPC::TPC(Common::SeekableReadStream &tpc, size_t threadCount) : _txiDataSize(0) {
+	load(tpc, threadCount);
 }
 
 TPC::~TPC() {
 }
 
-void TPC::load(Common::SeekableReadStream &tpc) {
+void TPC::load(Common::SeekableReadStream &tpc, size_t threadCount) {
 	try {
 
 		byte encoding;
@@ -55,7 +55,7 @@ void TPC::load(Common::SeekableReadStream &tpc) {
 		readData   (tpc, encoding);
 		readTXIData(tpc);
 
-		fixupCubeMap();
+		fixupCubeMap(threadCount);
 
 	} catch (Common::Exception &e) {
 		e.add("Failed reading TPC file");
@@ -63,7 +63,7 @@ void TPC::load(Common::SeekableReadStream &tpc) {
 	}
 
 	// In xoreos-tools, we always want decompressed images
-	decompress();
+	decompress(threadCount);
 }
 
 Common::SeekableReadStream *TPC::getTXI() const {
@@ -311,7 +311,7 @@ void TPC::readTXIData(Common::SeekableReadStream &tpc) {
 		throw Common::Exception(Common::kReadError);
 }
 
-void TPC::fixupCubeMap() {
+void TPC::fixupCubeMap(size_t threadCount) {
 	/* Do various fixups to the cube maps. This includes rotating and swapping a
 	 * few sides around. This is done by the original games as well.
 	 */
@@ -341,7 +341,7 @@ void TPC::fixupCubeMap() {
 	}
 
 	// Since we need to rotate the individual cube sides, we need to decompress them all
-	decompress();
+	decompress(threadCount);
 
 	// Rotate the cube sides so that they're all oriented correctly
 	for (size_t i = 0; i < getLayerCount(); i++) {
@@ -43,7 +43,12 @@ namespace Images {
  */
 class TPC : public Decoder {
 public:
-	TPC(Common::SeekableReadStream &tpc);
+	/** Load a TPC image, decompressing it using threadCount threads.
+	 *
+	 *  @param tpc The stream to read the image from.
+	 *  @param threadCount The number of threads to use for decompression. 0 = one per CPU core.
+	 */
+	TPC(Common::SeekableReadStream &tpc, size_t threadCount = 1);
 	~TPC();
 
 	/** Return the enclosed TXI data. */
@@ -54,13 +59,13 @@ private:
 	size_t _txiDataSize;
 
 	// Loading helpers
-	void load(Common::SeekableReadStream &tpc);
+	void load(Common::SeekableReadStream &tpc, size_t threadCount);
 	void readHeader(Common::SeekableReadStream &tpc, byte &encoding);
 	void readData(Common::SeekableReadStream &tpc, byte encoding);
 	void readTXIData(Common::SeekableReadStream &tpc);
 
 	bool checkCubeMap(uint32 &width, uint32 &height);
-	void fixupCubeMap();
+	void fixupCubeMap(size_t threadCount);
 
 	static void deSwizzle(byte *dst, const byte *src, uint32 width, uint32 height);
 };
@@ -36,11 +36,11 @@ static const byte kEncodingDXT5 = 0x0C;
 
 namespace Images {
 
-TXB::TXB(Common::SeekableReadStream &txb) : _dataSize(0), _txiDataSize(0) {
+TXB::TXB(Common::SeekableReadStream &txb, size_t threadCount) : _dataSize(0), _txiDataSize(0) {
 	load(txb);
 
 	// In xoreos-tools, we always want decompressed images
-	decompress();
+	decompress(threadCount);
 }
 
 TXB::~TXB() {
@@ -45,7 +45,12 @@ namespace Images {
  */
 class TXB : public Decoder {
 public:
-	TXB(Common::SeekableReadStream &txb);
+	/** Load a TXB image, decompressing it using threadCount threads.
+	 *
+	 *  @param txb The stream to read the image from.
+	 *  @param threadCount The number of threads to use for decompression. 0 = one per CPU core.
+	 */
+	TXB(Common::SeekableReadStream &txb, size_t threadCount = 1);
 	~TXB();
 
 	/** Return the enclosed TXI data. */
@@ -24,6 +24,8 @@
 
 #include <cassert>
 
+#include <boost/noncopyable.hpp>
+
 #include "src/common/util.h"
 #include "src/common/error.h"
 
@@ -46,8 +48,51 @@ enum AnalyzeMode {
 	kAnalyzeStackSubRoutine
 };
 
+/** A path through the control flow whose analysis is still in progress.
+ *
+ *  Each path owns a copy of the stack as it looks when control reaches the
+ *  path's block. Once all the instructions of the block are analyzed, the
+ *  path spawns one new path for each child block it can continue into.
+ */
+struct AnalyzeStackPath {
+	Block *block; ///< The block this path is currently in.
+
+	Stack stack;     ///< The stack along this path.
+	size_t subStack; ///< The size of the current subroutine's stack frame.
+
+	bool started;       ///< Have we started analyzing the block?
+	size_t instruction; ///< Index of the next instruction to analyze.
+	size_t child;       ///< Index of the next child block to follow.
+
+
+	AnalyzeStackPath(Block &b, size_t s) : block(&b), subStack(s), started(false), instruction(0), child(0) {
+	}
+};
+
+/** A subroutine call whose analysis is still in progress.
+ *
+ *  This holds everything that's needed to return to the caller once all
+ *  paths through the called subroutine have been analyzed.
+ */
+struct AnalyzeStackCall {
+	SubRoutine *sub;          ///< The calling subroutine.
+	Instruction *instruction; ///< The calling instruction.
+
+	Stack *stack;    ///< The stack of the caller.
+	size_t subStack; ///< The size of the caller's stack frame.
+
+	bool subRETN;      ///< Did the caller already see a RETN?
+	Stack returnStack; ///< The caller's return stack.
+
+	size_t paths; ///< Number of paths in progress when the call was made.
+
+
+	AnalyzeStackCall() : sub(0), instruction(0), stack(0), subStack(0), subRETN(false), paths(0) {
+	}
+};
+
 /** The context during stack analysis. */
-struct AnalyzeStackContext {
+struct AnalyzeStackContext : boost::noncopyable {
 	AnalyzeMode mode;
 
 	SubRoutine *sub;
@@ -66,11 +111,20 @@ struct AnalyzeStackContext {
 
 	Stack returnStack;
 
+	/** A subroutine the current instruction wants to call. */
+	SubRoutine *callSub;
+	/** Ignore recursion into callSub? */
+	bool callIgnoreRecursion;
 
-	AnalyzeStackContext(AnalyzeMode m, SubRoutine &s, VariableSpace &vars,
-	                    Aurora::GameID g = Aurora::kGameIDUnknown) :
-		mode(m), sub(&s), block(0), instruction(0), variables(&vars), game(g),
-		stack(0), globals(0), subStack(0), subRETN(false) {
+	/** All paths whose analysis is still in progress. The back one is analyzed next. */
+	std::deque<AnalyzeStackPath> paths;
+	/** All subroutine calls whose analysis is still in progress. */
+	std::deque<AnalyzeStackCall> calls;
+
+
+	AnalyzeStackContext(AnalyzeMode m, VariableSpace &vars, Aurora::GameID g = Aurora::kGameIDUnknown) :
+		mode(m), sub(0), block(0), instruction(0), variables(&vars), game(g),
+		stack(0), globals(0), subStack(0), subRETN(false), callSub(0), callIgnoreRecursion(false) {
 
 	}
 
@@ -103,11 +157,36 @@ struct AnalyzeStackContext {
 		return (*stack)[offset].variable->type;
 	}
 
+	void changeVariableType(Variable &var, VariableType type) {
+		/* A variable and all its duplicates hold the same value, so they always share
+		 * the same type. Types change rarely, so whenever they do, we directly walk the
+		 * links between the duplicates and update all of them. */
+
+		if (var.type == type)
+			return;
+
+		std::vector<Variable *> change(1, &var);
+		var.type = type;
+
+		while (!change.empty()) {
+			const Variable &v = *change.back();
+			change.pop_back();
+
+			for (std::set<const Variable *>::const_iterator d = v.duplicates.begin(); d != v.duplicates.end(); ++d) {
+				if ((*d)->type == type)
+					continue;
+
+				change.push_back(const_cast<Variable *>(*d));
+				change.back()->type = type;
+			}
+		}
+	}
+
 	void setVariableType(Variable &var, VariableType type) {
 		if ((type == kTypeAny) || ((var.type == kTypeResource) && (type == kTypeString)))
 			return;
 
-		var.type = type;
+		changeVariableType(var, type);
 		var.typeInference.push_back(TypeInference(type, instruction));
 	}
 
@@ -176,7 +255,8 @@ struct AnalyzeStackContext {
 
 		Variable *var2 = stack->front().variable;
 
-		connectSets(var1, var2, var1->duplicates, var2->duplicates);
+		var1->duplicates.insert(var2);
+		var2->duplicates.insert(var1);
 	}
 
 	bool checkVariableType(size_t offset, VariableType type) {
@@ -348,38 +428,20 @@ static const AnalyzeStackFunc kAnalyzeStackFunc[kOpcodeMAX] = {
 };
 
 
-static void fixupDuplicateTypes(VariableSpace &variables) {
-	for (VariableSpace::iterator v = variables.begin(); v != variables.end(); ++v) {
-		VariableType type = v->type;
-
-		for (std::set<const Variable *>::iterator d = v->duplicates.begin(); d != v->duplicates.end(); ++d)
-			if ((*d)->type != kTypeAny)
-				type = (*d)->type;
-
-		v->type = type;
-		for (std::set<const Variable *>::iterator d = v->duplicates.begin(); d != v->duplicates.end(); ++d)
-			const_cast<Variable *>(*d)->type = type;
-	}
-}
-
-
-static void analyzeStackBlock      (AnalyzeStackContext &ctx);
 static void analyzeStackInstruction(AnalyzeStackContext &ctx);
 
-static void analyzeStackSubRoutine(AnalyzeStackContext &ctx, bool ignoreRecursion = false) {
-	assert(ctx.sub);
-
-	if (ctx.sub->stackAnalyzeState == kStackAnalyzeStateFinished) {
+static bool enterSubRoutine(AnalyzeStackContext &ctx, SubRoutine &sub, bool ignoreRecursion = false) {
+	if (sub.stackAnalyzeState == kStackAnalyzeStateFinished) {
 		/* If we already analyzed this subroutine previously, don't do it again.
 		 *
 		 * Instead, we make sure the types of the parameters and return values
 		 * are congruent between each other. */
 
-		if (ctx.getSubStackSize() < ctx.sub->params.size())
+		if (ctx.getSubStackSize() < sub.params.size())
 			throw Common::Exception("analyzeStackSubRoutine(): @%08X: Stack underrun", ctx.instruction->address);
 
-		for (size_t i = 0; i < ctx.sub->params.size(); i++) {
-			Variable *var1 = const_cast<Variable *>(ctx.sub->params[i]);
+		for (size_t i = 0; i < sub.params.size(); i++) {
+			Variable *var1 = const_cast<Variable *>(sub.params[i]);
 			Variable *var2 = const_cast<Variable *>(ctx.stack->front().variable);
 
 			var2->use = kVariableUseParameter;
@@ -388,8 +450,8 @@ static void analyzeStackSubRoutine(AnalyzeStackContext &ctx, bool ignoreRecursio
 			ctx.popVariable(false);
 		}
 
-		for (size_t i = 0; i < ctx.sub->returns.size(); i++) {
-			Variable *var1 = const_cast<Variable *>(ctx.sub->returns[i]);
+		for (size_t i = 0; i < sub.returns.size(); i++) {
+			Variable *var1 = const_cast<Variable *>(sub.returns[i]);
 			Variable *var2 = const_cast<Variable *>((*ctx.stack)[i].variable);
 
 			var2->use = kVariableUseReturn;
@@ -397,11 +459,10 @@ static void analyzeStackSubRoutine(AnalyzeStackContext &ctx, bool ignoreRecursio
 			ctx.sameVariableType(var1, var2);
 		}
 
-		return;
+		return false;
 	}
 
-	// Are we currently already in the process of analyzing this very same subroutine?
-	if (ctx.sub->stackAnalyzeState == kStackAnalyzeStateStart) {
+	if (sub.stackAnalyzeState == kStackAnalyzeStateStart) {
 		/* Are we currently already in the process of analyzing this very same
 		 * subroutine?  Then we've walked into a recursing subroutine. Yay.
 		 *
@@ -418,137 +479,231 @@ static void analyzeStackSubRoutine(AnalyzeStackContext &ctx, bool ignoreRecursio
 		 */
 
 		if (ignoreRecursion)
-			return;
+			return false;
 
-		throw Common::Exception("Recursion detected in subroutine %08X", ctx.sub->address);
+		throw Common::Exception("Recursion detected in subroutine %08X", sub.address);
 	}
 
-	ctx.sub->stackAnalyzeState = kStackAnalyzeStateStart;
+	sub.stackAnalyzeState = kStackAnalyzeStateStart;
 
-	if (!ctx.sub->blocks.empty()) {
-		/* Start analyzing the control flow of this subroutine with its
-		 * first block. The following blocks and their subroutine calls
-		 * will be recursively followed. */
+	if (sub.blocks.empty()) {
+		sub.stackAnalyzeState = kStackAnalyzeStateFinished;
+		return false;
+	}
 
-		assert(ctx.sub->blocks.front());
+	/* Remember where the caller left off and start a path at the first block of
+	 * this subroutine. The subroutine continues on the stack of the caller, so
+	 * the path takes it over. The caller gets it back in leaveSubRoutine(). */
 
-		AnalyzeStackContext oldCtx(ctx);
+	assert(sub.blocks.front() && ctx.stack);
 
-		ctx.block    = const_cast<Block *>(ctx.sub->blocks.front());
-		ctx.subStack = 0;
-		ctx.subRETN  = false;
-		ctx.returnStack.clear();
+	ctx.calls.push_back(AnalyzeStackCall());
+	AnalyzeStackCall &call = ctx.calls.back();
 
-		analyzeStackBlock(ctx);
+	call.sub         = ctx.sub;
+	call.instruction = ctx.instruction;
+	call.stack       = ctx.stack;
+	call.subStack    = ctx.subStack;
+	call.subRETN     = ctx.subRETN;
+	call.paths       = ctx.paths.size();
 
-		*oldCtx.stack = ctx.returnStack;
+	call.returnStack.swap(ctx.returnStack);
 
-		ctx = oldCtx;
+	ctx.sub     = &sub;
+	ctx.subRETN = false;
 
-		ctx.subStack -= ctx.sub->params.size();
-	}
+	ctx.paths.push_back(AnalyzeStackPath(*const_cast<Block *>(sub.blocks.front()), 0));
+	ctx.paths.back().stack.swap(*ctx.stack);
+
+	return true;
+}
+
+static SubRoutine &leaveSubRoutine(AnalyzeStackContext &ctx) {
+	/* All paths through the current subroutine have been analyzed. Return to
+	 * the caller, whose stack now looks like the stack the subroutine returned
+	 * with. */
+
+	assert(!ctx.calls.empty() && ctx.sub);
+
+	AnalyzeStackCall &call = ctx.calls.back();
+	SubRoutine &sub = *ctx.sub;
+
+	call.stack->swap(ctx.returnStack);
 
-	ctx.sub->stackAnalyzeState = kStackAnalyzeStateFinished;
+	ctx.sub         = call.sub;
+	ctx.instruction = call.instruction;
+	ctx.stack       = call.stack;
+	ctx.subStack    = call.subStack - sub.params.size();
+	ctx.subRETN     = call.subRETN;
 
-	// Now make sure the types of all variables that have been duplicated are the same
-	fixupDuplicateTypes(*ctx.variables);
+	ctx.returnStack.swap(call.returnStack);
+
+	ctx.calls.pop_back();
+
+	sub.stackAnalyzeState = kStackAnalyzeStateFinished;
+
+	return sub;
 }
 
-static void analyzeStackBlock(AnalyzeStackContext &ctx) {
-	assert(ctx.block);
+static void finishStackJSR(AnalyzeStackContext &ctx, const SubRoutine &sub) {
+	/* The subroutine called by a JSR instruction has been analyzed. */
+
+	if ((sub.params.size() + sub.returns.size()) > ctx.stack->size())
+		throw Common::Exception("analyzeStackJSR(): @%08X: Stack underrun", ctx.instruction->address);
+
+	for (size_t i = 0; i < (sub.params.size() + sub.returns.size()); i++)
+		ctx.modifiesVariable(i);
+}
+
+static size_t findStackChild(const Block &block, size_t child) {
+	/* Find the next child block to follow, but not into subroutines or STORESTATEs.
+	 * Don't follow logically dead edges either. */
+
+	assert(block.children.size() == block.childrenTypes.size());
+
+	for ( ; child < block.children.size(); child++)
+		if ((block.childrenTypes[child] != kBlockEdgeTypeSubRoutineCall ) &&
+		    (block.childrenTypes[child] != kBlockEdgeTypeSubRoutineStore) &&
+		    (block.childrenTypes[child] != kBlockEdgeTypeDead           ))
+			break;
+
+	return child;
+}
 
-	if (ctx.block->stackAnalyzeState == kStackAnalyzeStateFinished) {
-		/* If we already analyzed this block previously, don't do it again.
-		 * However, we're going to connect the variables on the stack now
-		 * with the variables on the stack then. Different variables on
-		 * the same stack space are obviously "siblings", essentially the
-		 * same logical variable. */
+static void analyzeStackPath(AnalyzeStackContext &ctx) {
+	/* Continue analyzing the path at the back of the path list, until it either
+	 * calls a subroutine, forks into a child block or ends. */
 
-		if (!ctx.block->instructions.empty() && ctx.block->instructions.front()) {
-			const Instruction &instr = *ctx.block->instructions.front();
+	assert(!ctx.paths.empty());
 
-			// Make sure the stack is balanced between the two merging nodes
-			if (ctx.subStack != instr.stack.size())
-				throw Common::Exception("Unbalanced stack in block fork merge @%08X: %u != %u",
-				                        instr.address, (uint)ctx.subStack, (uint)instr.stack.size());
+	AnalyzeStackPath &path = ctx.paths.back();
+	assert(path.block);
 
-			// Now connect the siblings, until we reached a point where the stack is identical again
-			for (size_t i = 0; i < ctx.subStack; i++) {
-				Variable *var1 = instr.stack[i].variable;
-				Variable *var2 = (*ctx.stack)[i].variable;
+	ctx.block    = path.block;
+	ctx.stack    = &path.stack;
+	ctx.subStack = path.subStack;
 
-				if (!var1 || !var2 || (var1 == var2) || (var1->id == var2->id))
-					break;
+	if (!path.started) {
+		path.started = true;
 
-				ctx.connectSiblings(*var1, *var2);
+		if (path.block->stackAnalyzeState == kStackAnalyzeStateFinished) {
+			/* If we already analyzed this block previously, don't do it again.
+			 * However, we're going to connect the variables on the stack now
+			 * with the variables on the stack then. Different variables on
+			 * the same stack space are obviously "siblings", essentially the
+			 * same logical variable. */
+
+			if (!path.block->instructions.empty() && path.block->instructions.front()) {
+				const Instruction &instr = *path.block->instructions.front();
+
+				// Make sure the stack is balanced between the two merging nodes
+				if (ctx.subStack != instr.stack.size())
+					throw Common::Exception("Unbalanced stack in block fork merge @%08X: %u != %u",
+					                        instr.address, (uint)ctx.subStack, (uint)instr.stack.size());
+
+				// Now connect the siblings, until we reached a point where the stack is identical again
+				for (size_t i = 0; i < ctx.subStack; i++) {
+					Variable *var1 = instr.stack[i].variable;
+					Variable *var2 = (*ctx.stack)[i].variable;
+
+					if (!var1 || !var2 || (var1 == var2) || (var1->id == var2->id))
+						break;
+
+					ctx.connectSiblings(*var1, *var2);
+				}
 			}
+
+			ctx.paths.pop_back();
+			return;
 		}
 
-		return;
+		// Are we currently already in the process of analyzing this very same block?
+		if (path.block->stackAnalyzeState == kStackAnalyzeStateStart)
+			throw Common::Exception("Recursion detected in block %08X", path.block->address);
+
+		path.block->stackAnalyzeState = kStackAnalyzeStateStart;
 	}
 
-	// Are we currently already in the process of analyzing this very same block?
-	if (ctx.block->stackAnalyzeState == kStackAnalyzeStateStart)
-		throw Common::Exception("Recursion detected in block %08X", ctx.block->address);
+	const std::vector<const Instruction *> &instructions = path.block->instructions;
+	while (path.instruction < instructions.size()) {
+		/* Analyze all the instructions in this block. When an instruction calls
+		 * a subroutine, that subroutine is analyzed first, and we come back here
+		 * once it's done. */
 
-	ctx.block->stackAnalyzeState = kStackAnalyzeStateStart;
+		assert(instructions[path.instruction]);
 
-	for (std::vector<const Instruction *>::const_iterator i = ctx.block->instructions.begin();
-	     i != ctx.block->instructions.end(); ++i) {
+		ctx.instruction = const_cast<Instruction *>(instructions[path.instruction++]);
 
-		/* Analyze all the instructions in this block.
-		 * Subroutine calls will be followed recursively. */
+		analyzeStackInstruction(ctx);
 
-		assert(*i);
+		if (ctx.callSub) {
+			SubRoutine &sub = *ctx.callSub;
+			ctx.callSub = 0;
 
-		ctx.instruction = const_cast<Instruction *>(*i);
+			if (enterSubRoutine(ctx, sub, ctx.callIgnoreRecursion))
+				return;
 
-		analyzeStackInstruction(ctx);
+			finishStackJSR(ctx, sub);
+		}
 
 		ctx.instruction = 0;
 	}
 
-	ctx.block->stackAnalyzeState = kStackAnalyzeStateFinished;
+	path.block->stackAnalyzeState = kStackAnalyzeStateFinished;
+	path.subStack = ctx.subStack;
 
-	assert(ctx.block->children.size() == ctx.block->childrenTypes.size());
+	/* Fork a new path for the next child block. Each child block continues with
+	 * its own copy of the stack, except for the last one, which can simply take
+	 * it over. */
 
-	for (size_t i = 0; i < ctx.block->children.size(); i++) {
-		/* Recurse into the child blocks, but not into subroutines or STORESTATEs.
-		 * Don't follow logically dead edges either. */
+	path.child = findStackChild(*path.block, path.child);
+	if (path.child >= path.block->children.size()) {
+		ctx.paths.pop_back();
+		return;
+	}
 
-		if ((ctx.block->childrenTypes[i] == kBlockEdgeTypeSubRoutineCall ) ||
-		    (ctx.block->childrenTypes[i] == kBlockEdgeTypeSubRoutineStore) ||
-		    (ctx.block->childrenTypes[i] == kBlockEdgeTypeDead           ))
-			continue;
+	assert(path.block->children[path.child]);
+	Block &child = *const_cast<Block *>(path.block->children[path.child]);
 
-		assert(ctx.block->children[i]);
+	path.child = findStackChild(*path.block, path.child + 1);
 
-		AnalyzeStackContext oldCtx(ctx);
-		Stack cStack(*ctx.stack);
+	ctx.paths.push_back(AnalyzeStackPath(child, path.subStack));
 
-		ctx.block = const_cast<Block *>(ctx.block->children[i]);
-		ctx.stack = &cStack;
+	if (path.child >= path.block->children.size())
+		ctx.paths.back().stack.swap(path.stack);
+	else
+		ctx.paths.back().stack = path.stack;
+}
 
-		analyzeStackBlock(ctx);
-		if (ctx.subRETN)
-			oldCtx.subRETN = true;
+static void analyzeStack(AnalyzeStackContext &ctx, SubRoutine &sub) {
+	/* Instead of recursing into child blocks and called subroutines, we keep the
+	 * paths and calls we're in the middle of analyzing in explicit lists. The
+	 * depth of the native stack therefore doesn't grow with the script. */
 
-		if (!ctx.returnStack.empty())
-			oldCtx.returnStack = ctx.returnStack;
+	if (!enterSubRoutine(ctx, sub))
+		return;
 
-		ctx = oldCtx;
+	while (!ctx.calls.empty()) {
+		if (ctx.paths.size() > ctx.calls.back().paths) {
+			analyzeStackPath(ctx);
+			continue;
+		}
+
+		const SubRoutine &callee = leaveSubRoutine(ctx);
+
+		// Continue with the path that called the subroutine
+		if (!ctx.paths.empty()) {
+			finishStackJSR(ctx, callee);
+
+			ctx.instruction = 0;
+			ctx.paths.back().subStack = ctx.subStack;
+		}
 	}
 }
 
 static void analyzeStackInstruction(AnalyzeStackContext &ctx) {
-	ctx.instruction->stack = *ctx.stack;
-
 	// For the instruction stack, only keep the stack frame of the current subroutine
-	if (ctx.instruction->stack.size() > ctx.subStack) {
-		const size_t outsideSize = ctx.instruction->stack.size() - ctx.subStack;
-
-		ctx.instruction->stack.erase(ctx.instruction->stack.end() - outsideSize, ctx.instruction->stack.end());
-	}
+	ctx.instruction->stack.assign(ctx.stack->begin(), ctx.stack->begin() + ctx.getSubStackSize());
 
 	// Call the specific stack analyze function for this opcode
 
@@ -619,23 +774,11 @@ static void analyzeStackJSR(AnalyzeStackContext &ctx) {
 	                       (ctx.instruction->opcode == kOpcodeJSR) &&
 	                       (ctx.instruction->follower->opcode == kOpcodeRETN);
 
-	AnalyzeStackContext oldCtx(ctx);
-
-	ctx.sub = sub;
-
-	analyzeStackSubRoutine(ctx, isStoreStateTail);
-
-	if ((sub->params.size() + sub->returns.size()) > oldCtx.stack->size())
-		throw Common::Exception("analyzeStackJSR(): @%08X: Stack underrun", ctx.instruction->address);
-
-	for (size_t i = 0; i < (sub->params.size() + sub->returns.size()); i++)
-		oldCtx.modifiesVariable(i);
+	/* The subroutine is analyzed before the next instruction, and the analysis of the
+	 * JSR itself is then finished in finishStackJSR(). */
 
-	oldCtx.subStack = ctx.subStack;
-
-	ctx = oldCtx;
-
-	assert(ctx.stack);
+	ctx.callSub             = sub;
+	ctx.callIgnoreRecursion = isStoreStateTail;
 }
 
 static void analyzeStackRETN(AnalyzeStackContext &ctx) {
@@ -735,8 +878,10 @@ static void analyzeStackCPDOWNSP(AnalyzeStackContext &ctx) {
 
 		VariableType type = ctx.readVariable(pos);
 
-		if (type == kTypeAny)
-			type = (*ctx.stack)[pos].variable->type = (*ctx.stack)[offset].variable->type;
+		if (type == kTypeAny) {
+			type = (*ctx.stack)[offset].variable->type;
+			ctx.changeVariableType(*(*ctx.stack)[pos].variable, type);
+		}
 
 		ctx.writeVariable(offset, type);
 
@@ -822,12 +967,14 @@ static void analyzeStackCPDOWNBP(AnalyzeStackContext &ctx) {
 		const size_t pos = size - 1;
 
 		VariableType type = ctx.readVariable(pos);
-		if (type == kTypeAny)
-			type = (*ctx.stack)[pos].variable->type = (*ctx.globals)[offset].variable->type;
+		if (type == kTypeAny) {
+			type = (*ctx.globals)[offset].variable->type;
+			ctx.changeVariableType(*(*ctx.stack)[pos].variable, type);
+		}
 
 		(*ctx.globals)[offset].variable->writers.push_back(ctx.instruction);
 
-		(*ctx.globals)[offset].variable->type = type;
+		ctx.changeVariableType(*(*ctx.globals)[offset].variable, type);
 
 		ctx.modifiesVariable(pos);
 		ctx.modifiesVariable(*(*ctx.globals)[offset].variable);
@@ -1354,7 +1501,7 @@ static void analyzeStackGETREFARRAY(AnalyzeStackContext &ctx) {
 
 
 void analyzeStackGlobals(SubRoutine &sub, VariableSpace &variables, Aurora::GameID game, Stack &globals) {
-	AnalyzeStackContext ctx(kAnalyzeStackGlobal, sub, variables, game);
+	AnalyzeStackContext ctx(kAnalyzeStackGlobal, variables, game);
 
 	ctx.globals = &globals;
 
@@ -1364,11 +1511,11 @@ void analyzeStackGlobals(SubRoutine &sub, VariableSpace &variables, Aurora::Game
 	for (size_t i = 0; i < kDummyStackFrameSize; i++)
 		ctx.pushVariable(kTypeAny);
 
-	analyzeStackSubRoutine(ctx);
+	analyzeStack(ctx, sub);
 }
 
 void analyzeStackSubRoutine(SubRoutine &sub, VariableSpace &variables, Aurora::GameID game, Stack *globals) {
-	AnalyzeStackContext ctx(kAnalyzeStackSubRoutine, sub, variables, game);
+	AnalyzeStackContext ctx(kAnalyzeStackSubRoutine, variables, game);
 
 	ctx.globals = globals;
 
@@ -1378,7 +1525,7 @@ void analyzeStackSubRoutine(SubRoutine &sub, VariableSpace &variables, Aurora::G
 	for (size_t i = 0; i < kDummyStackFrameSize; i++)
 		ctx.pushVariable(kTypeAny);
 
-	analyzeStackSubRoutine(ctx);
+	analyzeStack(ctx, sub);
 }
 
 } // End of namespace NWScript
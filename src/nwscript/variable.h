@@ -152,7 +152,12 @@ struct Variable {
 	/** Instructions that write this variable. */
 	std::vector<const Instruction *> writers;
 
-	/** Variables that were created by duplicating this variable. */
+	/** Variables that were created by duplicating this variable, or the one
+	 *  this variable is itself a duplicate of.
+	 *
+	 *  Following these links finds all copies of the same value, which
+	 *  always share the same type.
+	 */
 	std::set<const Variable *> duplicates;
 
 	/** Variables that are logically the very same variable as this one.
@@ -58,14 +58,17 @@ enum Command {
 const char *kCommandChar[kCommandMAX] = { "i", "l", "v", "e", "x" };
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Command &command, Common::UString &archive, std::set<Common::UString> &files,
-                      Aurora::GameID &game, std::vector<byte> &password);
+                      Command &command, Common::UString &archive, std::vector<Common::UString> &files,
+                      Aurora::GameID &game, std::vector<byte> &password, uint32 &jobs, bool &batch);
 
 bool parsePassword(const Common::UString &arg, std::vector<byte> &password);
 bool readNWMMD5   (const Common::UString &arg, std::vector<byte> &password);
 
 void displayInfo(Aurora::ERFFile &erf);
 
+void processArchive(const Common::UString &archive, Command command, const std::set<Common::UString> &files,
+                    Aurora::GameID game, const std::vector<byte> &password, uint32 jobs);
+
 int main(int argc, char **argv) {
 	initPlatform();
 
@@ -78,25 +81,34 @@ int main(int argc, char **argv) {
 		int returnValue = 1;
 		Command command = kCommandNone;
 		Common::UString archive;
-		std::set<Common::UString> files;
+		std::vector<Common::UString> files;
 		std::vector<byte> password;
+		uint32 jobs = 1;
+		bool batch = false;
 
-		if (!parseCommandLine(args, returnValue, command, archive, files, game, password))
+		if (!parseCommandLine(args, returnValue, command, archive, files, game, password, jobs, batch))
 			return returnValue;
 
-		Aurora::ERFFile erf(new Common::ReadFile(archive), password);
-		files = Archives::fixPathSeparator(files);
+		if (!batch) {
+			const std::set<Common::UString> fileSet(files.begin(), files.end());
+
+			processArchive(archive, command, Archives::fixPathSeparator(fileSet), game, password, jobs);
+			return 0;
+		}
+
+		/* In batch mode, all arguments are archives, and we process each of them
+		 * as a whole, in the order they were given. The HAKs of a Neverwinter
+		 * Nights premium module all share the same key. Each HAK still probes
+		 * all the premium keys, but each of those is only expanded once. */
+
+		std::vector<Common::UString> archives(1, archive);
+		archives.insert(archives.end(), files.begin(), files.end());
 
-		if      (command == kCommandInfo)
-			displayInfo(erf);
-		else if (command == kCommandList)
-			Archives::listFiles(erf, game, false);
-		else if (command == kCommandListVerbose)
-			Archives::listFiles(erf, game, true);
-		else if (command == kCommandExtract)
-			Archives::extractFiles(erf, game, false, files);
-		else if (command == kCommandExtractDir)
-			Archives::extractFiles(erf, game, true, files);
+		for (std::vector<Common::UString>::const_iterator a = archives.begin(); a != archives.end(); ++a) {
+			std::printf("%s%s:\n", (a == archives.begin()) ? "" : "\n", a->c_str());
+
+			processArchive(*a, command, std::set<Common::UString>(), game, password, jobs);
+		}
 
 	} catch (...) {
 		Common::exceptionDispatcherError();
@@ -161,8 +173,8 @@ int ValGetter<Command &>::get(const std::vector<Common::UString> &args, int i, i
 }
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Command &command, Common::UString &archive, std::set<Common::UString> &files,
-                      Aurora::GameID &game, std::vector<byte> &password) {
+                      Command &command, Common::UString &archive, std::vector<Common::UString> &files,
+                      Aurora::GameID &game, std::vector<byte> &password, uint32 &jobs, bool &batch) {
 
 	using Common::CLI::NoOption;
 	using Common::CLI::kContinueParsing;
@@ -176,7 +188,7 @@ bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue
 
 	NoOption cmdOpt(false, new ValGetter<Command &>(command, "command"));
 	NoOption archiveOpt(false, new ValGetter<Common::UString &>(archive, "archive"));
-	NoOption filesOpt(true, new ValGetter<std::set<Common::UString> &>(files, "files[...]"));
+	NoOption filesOpt(true, new ValGetter<std::vector<Common::UString> &>(files, "files[...]"));
 	Parser parser(argv[0], "BioWare ERF (.erf, .mod, .nwm, .sav) archive extractor",
 	              "Commands:\n"
 	              "  i          Display meta-information\n"
@@ -202,10 +214,33 @@ bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue
 	                 "Neverwinter Nights premium module file(for decrypting their HAK file)",
 	                 kContinueParsing,
 	                 new Callback<std::vector<byte> &>("file", readNWMMD5, password));
+	parser.addSpace();
+	parser.addOption("jobs", 'j', "Number of threads to extract with (0 = one per CPU core; default: 1)",
+	                 kContinueParsing, new ValGetter<uint32 &>(jobs, "n"));
+	parser.addOption("batch", "Treat all further arguments as archives, and process each as a whole",
+	                 kContinueParsing,
+	                 makeAssigners(new ValAssigner<bool>(true, batch)));
 
 	return parser.process(argv);
 }
 
+void processArchive(const Common::UString &archive, Command command, const std::set<Common::UString> &files,
+                    Aurora::GameID game, const std::vector<byte> &password, uint32 jobs) {
+
+	Aurora::ERFFile erf(openFileMapped(archive), password);
+
+	if      (command == kCommandInfo)
+		displayInfo(erf);
+	else if (command == kCommandList)
+		Archives::listFiles(erf, game, false);
+	else if (command == kCommandListVerbose)
+		Archives::listFiles(erf, game, true);
+	else if (command == kCommandExtract)
+		Archives::extractFiles(erf, game, false, files, jobs);
+	else if (command == kCommandExtractDir)
+		Archives::extractFiles(erf, game, true, files, jobs);
+}
+
 void displayInfo(Aurora::ERFFile &erf) {
 	std::printf("Version: %s\n", Common::debugTag(erf.getVersion()).c_str());
 	std::printf("Build Year: %d\n", erf.getBuildYear());
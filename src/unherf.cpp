@@ -31,7 +31,6 @@
 #include "src/common/ustring.h"
 #include "src/common/error.h"
 #include "src/common/platform.h"
-#include "src/common/readfile.h"
 #include "src/common/cli.h"
 
 #include "src/aurora/util.h"
@@ -51,7 +50,8 @@ enum Command {
 const char *kCommandChar[kCommandMAX] = { "l", "e" };
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Command &command, Common::UString &archive, std::set<Common::UString> &files);
+                      Command &command, Common::UString &archive, std::set<Common::UString> &files,
+                      uint32 &jobs);
 
 int main(int argc, char **argv) {
 	initPlatform();
@@ -64,17 +64,18 @@ int main(int argc, char **argv) {
 		Command command = kCommandNone;
 		Common::UString archive;
 		std::set<Common::UString> files;
+		uint32 jobs = 1;
 
-		if (!parseCommandLine(args, returnValue, command, archive, files))
+		if (!parseCommandLine(args, returnValue, command, archive, files, jobs))
 			return returnValue;
 
-		Aurora::HERFFile herf(new Common::ReadFile(archive));
+		Aurora::HERFFile herf(openFileMapped(archive));
 		files = Archives::fixPathSeparator(files);
 
 		if      (command == kCommandList)
 			Archives::listFiles(herf, Aurora::kGameIDUnknown, false);
 		else if (command == kCommandExtract)
-			Archives::extractFiles(herf, Aurora::kGameIDUnknown, false, files);
+			Archives::extractFiles(herf, Aurora::kGameIDUnknown, false, files, jobs);
 
 	} catch (...) {
 		Common::exceptionDispatcherError();
@@ -100,9 +101,11 @@ int ValGetter<Command &>::get(const std::vector<Common::UString> &args, int i, i
 }
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Command &command, Common::UString &archive, std::set<Common::UString> &files) {
+                      Command &command, Common::UString &archive, std::set<Common::UString> &files,
+                      uint32 &jobs) {
 
 	using Common::CLI::NoOption;
+	using Common::CLI::kContinueParsing;
 	using Common::CLI::Parser;
 	using Common::CLI::ValGetter;
 	using Common::CLI::makeEndArgs;
@@ -117,5 +120,8 @@ bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue
 	              returnValue,
 	              makeEndArgs(&cmdOpt, &archiveOpt, &filesOpt));
 
+	parser.addOption("jobs", 'j', "Number of threads to extract with (0 = one per CPU core; default: 1)",
+	                 kContinueParsing, new ValGetter<uint32 &>(jobs, "n"));
+
 	return parser.process(argv);
 }
@@ -26,6 +26,7 @@
 #include <cstdio>
 
 #include <list>
+#include <map>
 #include <vector>
 
 #include "src/version/version.h"
@@ -60,7 +61,8 @@ enum Command {
 const char *kCommandChar[kCommandMAX] = { "l", "e" };
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Command &command, std::list<Common::UString> &files, Aurora::GameID &game);
+                      Command &command, std::list<Common::UString> &files, Aurora::GameID &game,
+                      uint32 &jobs);
 
 uint32 getFileID(const Common::UString &fileName);
 void identifyFiles(const std::list<Common::UString> &files, std::vector<Common::UString> &keyFiles,
@@ -73,7 +75,8 @@ void mergeKEYDataFiles(Common::PtrVector<Aurora::KEYFile> &keys, Common::PtrVect
                        const std::vector<Common::UString> &dataFiles);
 
 void listFiles(const Common::PtrVector<Aurora::KEYFile> &keys, const std::vector<Common::UString> &keyFiles, Aurora::GameID game);
-void extractFiles(const Common::PtrVector<Aurora::KEYDataFile> &keyData, const std::vector<Common::UString> &dataFiles, Aurora::GameID game);
+void extractFiles(const Common::PtrVector<Aurora::KEYDataFile> &keyData, const std::vector<Common::UString> &dataFiles,
+                  Aurora::GameID game, uint32 jobs);
 
 int main(int argc, char **argv) {
 	initPlatform();
@@ -87,8 +90,9 @@ int main(int argc, char **argv) {
 		int returnValue = 1;
 		Command command = kCommandNone;
 		std::list<Common::UString> files;
+		uint32 jobs = 1;
 
-		if (!parseCommandLine(args, returnValue, command, files, game))
+		if (!parseCommandLine(args, returnValue, command, files, game, jobs))
 			return returnValue;
 
 		std::vector<Common::UString> keyFiles, dataFiles;
@@ -105,7 +109,7 @@ int main(int argc, char **argv) {
 		if      (command == kCommandList)
 			listFiles(keys, keyFiles, game);
 		else if (command == kCommandExtract)
-			extractFiles(keyData, dataFiles, game);
+			extractFiles(keyData, dataFiles, game, jobs);
 
 	} catch (...) {
 		Common::exceptionDispatcherError();
@@ -131,9 +135,11 @@ int ValGetter<Command &>::get(const std::vector<Common::UString> &args, int i, i
 }
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Command &command, std::list<Common::UString> &files, Aurora::GameID &game) {
+                      Command &command, std::list<Common::UString> &files, Aurora::GameID &game,
+                      uint32 &jobs) {
 
 	using Common::CLI::NoOption;
+	using Common::CLI::kContinueParsing;
 	using Common::CLI::Parser;
 	using Common::CLI::ValGetter;
 	using Common::CLI::makeEndArgs;
@@ -161,6 +167,9 @@ bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue
 	parser.addOption("jade", "Alias file types according to Jade Empire rules",
 	                 Common::CLI::kContinueParsing,
 	                 makeAssigners(new ValAssigner<Aurora::GameID>(Aurora::kGameIDJade, game)));
+	parser.addSpace();
+	parser.addOption("jobs", 'j', "Number of threads to extract with (0 = one per CPU core; default: 1)",
+	                 kContinueParsing, new ValGetter<uint32 &>(jobs, "n"));
 
 	return parser.process(argv);
 }
@@ -204,15 +213,22 @@ void openKEYDataFiles(const std::vector<Common::UString> &dataFiles, Common::Ptr
 
 	for (std::vector<Common::UString>::const_iterator f = dataFiles.begin(); f != dataFiles.end(); ++f) {
 		if (Common::FilePath::getExtension(*f).equalsIgnoreCase(".bzf"))
-			keyData.push_back(new Aurora::BZFFile(new Common::ReadFile(*f)));
+			keyData.push_back(new Aurora::BZFFile(openFileMapped(*f)));
 		else
-			keyData.push_back(new Aurora::BIFFile(new Common::ReadFile(*f)));
+			keyData.push_back(new Aurora::BIFFile(openFileMapped(*f)));
 	}
 }
 
 void mergeKEYDataFiles(Common::PtrVector<Aurora::KEYFile> &keys, Common::PtrVector<Aurora::KEYDataFile> &keyData,
                        const std::vector<Common::UString> &dataFiles) {
 
+	// Index the BIFs/BZFs by their stem, to avoid comparing every KEY BIF with every data file
+	typedef std::multimap<Common::UString, size_t, Common::UString::iless> DataFileMap;
+
+	DataFileMap dataFileMap;
+	for (size_t b = 0; b < dataFiles.size(); b++)
+		dataFileMap.insert(std::make_pair(Common::FilePath::getStem(dataFiles[b]), b));
+
 	// Go over all KEYs
 	for (Common::PtrVector<Aurora::KEYFile>::iterator k = keys.begin(); k != keys.end(); ++k) {
 
@@ -220,14 +236,12 @@ void mergeKEYDataFiles(Common::PtrVector<Aurora::KEYFile> &keys, Common::PtrVect
 		const Aurora::KEYFile::BIFList &keyBifs = (*k)->getBIFs();
 		for (size_t kb = 0; kb < keyBifs.size(); kb++) {
 
-			// Go over all BIFs
-			for (size_t b = 0; b < dataFiles.size(); b++) {
+			// Merge all BIFs with a matching name
+			std::pair<DataFileMap::const_iterator, DataFileMap::const_iterator> matches =
+				dataFileMap.equal_range(Common::FilePath::getStem(keyBifs[kb]));
 
-				// If they match, merge
-				if (Common::FilePath::getStem(keyBifs[kb]).equalsIgnoreCase(Common::FilePath::getStem(dataFiles[b])))
-					keyData[b]->mergeKEY(**k, kb);
-
-			}
+			for (DataFileMap::const_iterator b = matches.first; b != matches.second; ++b)
+				keyData[b->second]->mergeKEY(**k, kb);
 
 		}
 
@@ -247,16 +261,21 @@ void listFiles(const Common::PtrVector<Aurora::KEYFile> &keys,
 }
 
 void extractFiles(const Common::PtrVector<Aurora::KEYDataFile> &keyData,
-                  const std::vector<Common::UString> &dataFiles, Aurora::GameID game) {
+                  const std::vector<Common::UString> &dataFiles, Aurora::GameID game, uint32 jobs) {
 
-	for (size_t i = 0; i < keyData.size(); i++) {
-		std::printf("%s: %s indexed files (of %u)\n\n", dataFiles[i].c_str(),
-		            Common::composeString(keyData[i]->getResources().size()).c_str(),
-                keyData[i]->getInternalResourceCount());
+	std::vector<const Aurora::Archive *> archives;
+	std::vector<Common::UString> headers;
 
-		Archives::extractFiles(*keyData[i], game, false, std::set<Common::UString>());
+	archives.reserve(keyData.size());
+	headers.reserve(keyData.size());
 
-		if (i < (keyData.size() - 1))
-			std::printf("\n");
+	for (size_t i = 0; i < keyData.size(); i++) {
+		archives.push_back(keyData[i]);
+
+		headers.push_back(Common::UString::format("%s: %s indexed files (of %u)\n\n", dataFiles[i].c_str(),
+		                  Common::composeString(keyData[i]->getResources().size()).c_str(),
+		                  keyData[i]->getInternalResourceCount()));
 	}
+
+	Archives::extractFiles(archives, headers, game, false, std::set<Common::UString>(), jobs);
 }
@@ -32,7 +32,6 @@
 #include "src/common/ustring.h"
 #include "src/common/error.h"
 #include "src/common/platform.h"
-#include "src/common/readfile.h"
 #include "src/common/cli.h"
 
 #include "src/aurora/util.h"
@@ -53,7 +52,8 @@ enum Command {
 const char *kCommandChar[kCommandMAX] = { "i", "l", "e" };
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Command &command, Common::UString &archive, std::set<Common::UString> &files);
+                      Command &command, Common::UString &archive, std::set<Common::UString> &files,
+                      uint32 &jobs);
 
 void displayInfo(Aurora::NDSFile &nds);
 
@@ -68,11 +68,12 @@ int main(int argc, char **argv) {
 		Command command = kCommandNone;
 		Common::UString archive;
 		std::set<Common::UString> files;
+		uint32 jobs = 1;
 
-		if (!parseCommandLine(args, returnValue, command, archive, files))
+		if (!parseCommandLine(args, returnValue, command, archive, files, jobs))
 			return returnValue;
 
-		Aurora::NDSFile nds(new Common::ReadFile(archive));
+		Aurora::NDSFile nds(openFileMapped(archive));
 		files = Archives::fixPathSeparator(files);
 
 		if      (command == kCommandInfo)
@@ -80,7 +81,7 @@ int main(int argc, char **argv) {
 		else if (command == kCommandList)
 			Archives::listFiles(nds, Aurora::kGameIDUnknown, false);
 		else if (command == kCommandExtract)
-			Archives::extractFiles(nds, Aurora::kGameIDUnknown, false, files);
+			Archives::extractFiles(nds, Aurora::kGameIDUnknown, false, files, jobs);
 
 	} catch (...) {
 		Common::exceptionDispatcherError();
@@ -106,9 +107,11 @@ int ValGetter<Command &>::get(const std::vector<Common::UString> &args, int i, i
 }
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Command &command, Common::UString &archive, std::set<Common::UString> &files) {
+                      Command &command, Common::UString &archive, std::set<Common::UString> &files,
+                      uint32 &jobs) {
 
 	using Common::CLI::NoOption;
+	using Common::CLI::kContinueParsing;
 	using Common::CLI::Parser;
 	using Common::CLI::ValGetter;
 	using Common::CLI::makeEndArgs;
@@ -124,6 +127,9 @@ bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue
 	              returnValue,
 	              makeEndArgs(&cmdOpt, &archiveOpt, &filesOpt));
 
+	parser.addOption("jobs", 'j', "Number of threads to extract with (0 = one per CPU core; default: 1)",
+	                 kContinueParsing, new ValGetter<uint32 &>(jobs, "n"));
+
 	return parser.process(argv);
 }
 
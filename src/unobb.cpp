@@ -32,7 +32,6 @@
 #include "src/common/error.h"
 #include "src/common/platform.h"
 #include "src/common/cli.h"
-#include "src/common/readfile.h"
 #include "src/common/scopedptr.h"
 
 #include "src/aurora/obbfile.h"
@@ -54,7 +53,8 @@ enum Command {
 const char *kCommandChar[kCommandMAX] = { "l", "v", "e", "x" };
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Command &command, Common::UString &archive, std::set<Common::UString> &files);
+                      Command &command, Common::UString &archive, std::set<Common::UString> &files,
+                      uint32 &jobs);
 
 bool isPKZIP(Common::SeekableReadStream &stream);
 
@@ -69,11 +69,12 @@ int main(int argc, char **argv) {
 		Command command = kCommandNone;
 		Common::UString archive;
 		std::set<Common::UString> files;
+		uint32 jobs = 1;
 
-		if (!parseCommandLine(args, returnValue, command, archive, files))
+		if (!parseCommandLine(args, returnValue, command, archive, files, jobs))
 			return returnValue;
 
-		Common::ScopedPtr<Common::SeekableReadStream> stream(new Common::ReadFile(archive));
+		Common::ScopedPtr<Common::SeekableReadStream> stream(openFileMapped(archive));
 
 		Common::ScopedPtr<Aurora::Archive> arc;
 		if (isPKZIP(*stream))
@@ -88,9 +89,9 @@ int main(int argc, char **argv) {
 		else if (command == kCommandListVerbose)
 			Archives::listFiles(*arc, Aurora::kGameIDUnknown, true);
 		else if (command == kCommandExtract)
-			Archives::extractFiles(*arc, Aurora::kGameIDUnknown, false, files);
+			Archives::extractFiles(*arc, Aurora::kGameIDUnknown, false, files, jobs);
 		else if (command == kCommandExtractDir)
-			Archives::extractFiles(*arc, Aurora::kGameIDUnknown, true, files);
+			Archives::extractFiles(*arc, Aurora::kGameIDUnknown, true, files, jobs);
 
 	} catch (...) {
 		Common::exceptionDispatcherError();
@@ -116,9 +117,11 @@ int ValGetter<Command &>::get(const std::vector<Common::UString> &args, int i, i
 }
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
-                      Command &command, Common::UString &archive, std::set<Common::UString> &files) {
+                      Command &command, Common::UString &archive, std::set<Common::UString> &files,
+                      uint32 &jobs) {
 
 	using Common::CLI::NoOption;
+	using Common::CLI::kContinueParsing;
 	using Common::CLI::Parser;
 	using Common::CLI::ValGetter;
 	using Common::CLI::makeEndArgs;
@@ -135,6 +138,9 @@ bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue
 	              returnValue,
 	              makeEndArgs(&cmdOpt, &archiveOpt, &filesOpt));
 
+	parser.addOption("jobs", 'j', "Number of threads to extract with (0 = one per CPU core; default: 1)",
+	                 kContinueParsing, new ValGetter<uint32 &>(jobs, "n"));
+
 	return parser.process(argv);
 }
 
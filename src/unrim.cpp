@@ -29,7 +29,6 @@
 #include "src/common/ustring.h"
 #include "src/common/error.h"
 #include "src/common/platform.h"
-#include "src/common/readfile.h"
 #include "src/common/cli.h"
 
 #include "src/aurora/util.h"
@@ -50,7 +49,7 @@ const char *kCommandChar[kCommandMAX] = { "l", "e" };
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
                       Command &command, Common::UString &archive,
-                      Aurora::GameID &game, std::set<Common::UString> &files);
+                      Aurora::GameID &game, std::set<Common::UString> &files, uint32 &jobs);
 
 int main(int argc, char **argv) {
 	initPlatform();
@@ -65,17 +64,18 @@ int main(int argc, char **argv) {
 		Command command = kCommandNone;
 		Common::UString archive;
 		std::set<Common::UString> files;
+		uint32 jobs = 1;
 
-		if (!parseCommandLine(args, returnValue, command, archive, game, files))
+		if (!parseCommandLine(args, returnValue, command, archive, game, files, jobs))
 			return returnValue;
 
-		Aurora::RIMFile rim(new Common::ReadFile(archive));
+		Aurora::RIMFile rim(openFileMapped(archive));
 		files = Archives::fixPathSeparator(files);
 
 		if      (command == kCommandList)
 			Archives::listFiles(rim, game, false);
 		else if (command == kCommandExtract)
-			Archives::extractFiles(rim, game, false, files);
+			Archives::extractFiles(rim, game, false, files, jobs);
 
 	} catch (...) {
 		Common::exceptionDispatcherError();
@@ -102,7 +102,7 @@ int ValGetter<Command &>::get(const std::vector<Common::UString> &args, int i, i
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
                       Command &command, Common::UString &archive,
-                      Aurora::GameID &game, std::set<Common::UString> &files) {
+                      Aurora::GameID &game, std::set<Common::UString> &files, uint32 &jobs) {
 
 	using Common::CLI::NoOption;
 	using Common::CLI::kContinueParsing;
@@ -129,6 +129,9 @@ bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue
 	parser.addOption("jade", "Alias file types according to Jade Empire rules",
 	                 kContinueParsing,
 	                 makeAssigners(new ValAssigner<Aurora::GameID>(Aurora::kGameIDJade, game)));
+	parser.addSpace();
+	parser.addOption("jobs", 'j', "Number of threads to extract with (0 = one per CPU core; default: 1)",
+	                 kContinueParsing, new ValGetter<uint32 &>(jobs, "n"));
 
 	return parser.process(argv);
 }
@@ -22,11 +22,13 @@
  *  General tool utility functions.
  */
 
+#include "src/common/scopedptr.h"
 #include "src/common/error.h"
 #include "src/common/ustring.h"
 #include "src/common/platform.h"
 #include "src/common/readstream.h"
 #include "src/common/readfile.h"
+#include "src/common/mappedreadfile.h"
 #include "src/common/writefile.h"
 #include "src/common/stdinstream.h"
 #include "src/common/stdoutstream.h"
@@ -65,3 +67,11 @@ Common::ReadStream *openFileOrStdIn(const Common::UString &file) {
 
 	return new Common::StdInStream;
 }
+
+Common::SeekableReadStream *openFileMapped(const Common::UString &file) {
+	Common::ScopedPtr<Common::MappedReadFile> mapped(new Common::MappedReadFile);
+	if (mapped->open(file))
+		return mapped.release();
+
+	return new Common::ReadFile(file);
+}
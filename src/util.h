@@ -39,4 +39,10 @@ void dumpStream(Common::SeekableReadStream &stream, const Common::UString &fileN
 Common::WriteStream *openFileOrStdOut(const Common::UString &file);
 Common::ReadStream  *openFileOrStdIn (const Common::UString &file);
 
+/** Open a file for random access, memory-mapping it if possible.
+ *
+ *  If the file can't be mapped, it is opened as a normal ReadFile instead.
+ */
+Common::SeekableReadStream *openFileMapped(const Common::UString &file);
+
 #endif // UTIL_H
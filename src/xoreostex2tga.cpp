@@ -51,10 +51,11 @@
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
                       Common::UString &inFile, Common::UString &outFile,
-                      Aurora::FileType &type, bool &flip, bool &deswizzle);
+                      Aurora::FileType &type, bool &flip, bool &deswizzle, bool &rle,
+                      uint32 &jobs);
 
 void convert(const Common::UString &inFile, const Common::UString &outFile,
-             Aurora::FileType type, bool flip, bool deswizzle);
+             Aurora::FileType type, bool flip, bool deswizzle, bool rle, uint32 jobs);
 
 int main(int argc, char **argv) {
 	initPlatform();
@@ -66,12 +67,13 @@ int main(int argc, char **argv) {
 		int returnValue = 1;
 		Common::UString inFile, outFile;
 		Aurora::FileType type = Aurora::kFileTypeNone;
-		bool flip = false, deswizzle = false;
+		bool flip = false, deswizzle = false, rle = false;
+		uint32 jobs = 1;
 
-		if (!parseCommandLine(args, returnValue, inFile, outFile, type, flip, deswizzle))
+		if (!parseCommandLine(args, returnValue, inFile, outFile, type, flip, deswizzle, rle, jobs))
 			return returnValue;
 
-		convert(inFile, outFile, type, flip, deswizzle);
+		convert(inFile, outFile, type, flip, deswizzle, rle, jobs);
 	} catch (...) {
 		Common::exceptionDispatcherError();
 	}
@@ -81,7 +83,8 @@ int main(int argc, char **argv) {
 
 bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue,
                       Common::UString &inFile, Common::UString &outFile,
-                      Aurora::FileType &type, bool &flip, bool &deswizzle) {
+                      Aurora::FileType &type, bool &flip, bool &deswizzle, bool &rle,
+                      uint32 &jobs) {
 
 	using Common::CLI::NoOption;
 	using Common::CLI::kContinueParsing;
@@ -118,6 +121,12 @@ bool parseCommandLine(const std::vector<Common::UString> &argv, int &returnValue
 	parser.addSpace();
 	parser.addOption("deswizzle", 'd', "Input file is an Xbox SBM that needs deswizzling",
 	                 kContinueParsing, makeAssigners(new ValAssigner<bool>(true, deswizzle)));
+	parser.addSpace();
+	parser.addOption("rle", 'r', "Write a run-length encoded TGA", kContinueParsing,
+	                 makeAssigners(new ValAssigner<bool>(true, rle)));
+	parser.addSpace();
+	parser.addOption("jobs", 'j', "Number of threads to decompress with (0 = one per CPU core; default: 1)",
+	                 kContinueParsing, new ValGetter<uint32 &>(jobs, "n"));
 	return parser.process(argv);
 }
 
@@ -152,16 +161,17 @@ static Aurora::FileType detectType(const Common::UString &file) {
 	return Aurora::kFileTypeNone;
 }
 
-static Images::Decoder *openImage(Common::SeekableReadStream &stream, Aurora::FileType type, bool deswizzle) {
+static Images::Decoder *openImage(Common::SeekableReadStream &stream, Aurora::FileType type,
+                                  bool deswizzle, uint32 jobs) {
 	switch (type) {
 		case Aurora::kFileTypeDDS:
-			return new Images::DDS(stream);
+			return new Images::DDS(stream, jobs);
 		case Aurora::kFileTypeSBM:
 			return new Images::SBM(stream, deswizzle);
 		case Aurora::kFileTypeTPC:
-			return new Images::TPC(stream);
+			return new Images::TPC(stream, jobs);
 		case Aurora::kFileTypeTXB:
-			return new Images::TXB(stream);
+			return new Images::TXB(stream, jobs);
 		case Aurora::kFileTypeTGA:
 			return new Images::TGA(stream);
 
@@ -171,7 +181,7 @@ static Images::Decoder *openImage(Common::SeekableReadStream &stream, Aurora::Fi
 }
 
 void convert(const Common::UString &inFile, const Common::UString &outFile,
-             Aurora::FileType type, bool flip, bool deswizzle) {
+             Aurora::FileType type, bool flip, bool deswizzle, bool rle, uint32 jobs) {
 
 	Common::ReadFile in(inFile);
 
@@ -188,9 +198,9 @@ void convert(const Common::UString &inFile, const Common::UString &outFile,
 		}
 	}
 
-	Common::ScopedPtr<Images::Decoder> image(openImage(in, type, deswizzle));
+	Common::ScopedPtr<Images::Decoder> image(openImage(in, type, deswizzle, jobs));
 	if (flip)
 		image->flipVertically();
 
-	image->dumpTGA(outFile);
+	image->dumpTGA(outFile, rle);
 }
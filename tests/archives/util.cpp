@@ -0,0 +1,147 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the archive tools utility functions.
+ */
+
+#include <string>
+#include <iterator>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/strutil.h"
+#include "src/common/platform.h"
+#include "src/common/hash.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/archive.h"
+
+#include "src/archives/util.h"
+
+/** A simple archive holding text resources in memory. */
+class TestArchive : public Aurora::Archive {
+public:
+	const Aurora::Archive::ResourceList &getResources() const {
+		return _resources;
+	}
+
+	Common::SeekableReadStream *getResource(uint32 index, bool UNUSED(tryNoCopy)) const {
+		return new Common::MemoryReadStream(_data[index].c_str());
+	}
+
+	Common::HashAlgo getNameHashAlgo() const {
+		return Common::kHashFNV64;
+	}
+
+	void addResource(const Common::UString &name, const char *data) {
+		Aurora::Archive::Resource res;
+
+		res.name  = name;
+		res.hash  = Common::hashString(name, Common::kHashFNV64);
+		res.type  = Aurora::kFileTypeTXT;
+		res.index = _data.size();
+
+		_resources.push_back(res);
+		_data.push_back(data);
+	}
+
+private:
+	Aurora::Archive::ResourceList _resources;
+	std::vector<std::string> _data;
+};
+
+/** Extracts into a fresh temporary directory, which is removed again afterwards. */
+class ExtractFiles : public ::testing::Test {
+protected:
+	boost::filesystem::path _oldPath;
+	boost::filesystem::path _tmpPath;
+
+	void SetUp() {
+		Common::Platform::init();
+
+		_oldPath = boost::filesystem::current_path();
+		_tmpPath = boost::filesystem::temp_directory_path() /
+		           boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		boost::filesystem::create_directory(_tmpPath);
+		boost::filesystem::current_path(_tmpPath);
+	}
+
+	void TearDown() {
+		boost::filesystem::current_path(_oldPath);
+		boost::filesystem::remove_all(_tmpPath);
+	}
+
+	static std::string readFile(const char *fileName) {
+		boost::filesystem::ifstream file(fileName, std::ifstream::binary);
+
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+};
+
+GTEST_TEST_F(ExtractFiles, sameNameStrippedDirectories) {
+	TestArchive archive;
+
+	for (size_t i = 0; i < 16; i++)
+		archive.addResource("a/other" + Common::composeString(i), "other");
+
+	archive.addResource("a/same", "first");
+	archive.addResource("b/same", "second");
+	archive.addResource("c/same", "third");
+
+	Archives::extractFiles(archive, Aurora::kGameIDUnknown, false, std::set<Common::UString>(), 4);
+
+	// Like when extracting with a single thread, the last file of the same name wins
+	EXPECT_EQ(readFile("same.txt"), "third");
+	EXPECT_EQ(readFile("other0.txt"), "other");
+	EXPECT_EQ(readFile("other15.txt"), "other");
+}
+
+GTEST_TEST_F(ExtractFiles, sameNameMultipleArchives) {
+	TestArchive archive1, archive2;
+
+	for (size_t i = 0; i < 16; i++) {
+		archive1.addResource("first" + Common::composeString(i), "first");
+		archive2.addResource("second" + Common::composeString(i), "second");
+	}
+
+	archive1.addResource("same", "first");
+	archive2.addResource("same", "second");
+
+	std::vector<const Aurora::Archive *> archives;
+	archives.push_back(&archive1);
+	archives.push_back(&archive2);
+
+	std::vector<Common::UString> headers;
+	headers.push_back("first");
+	headers.push_back("second");
+
+	Archives::extractFiles(archives, headers, Aurora::kGameIDUnknown, false, std::set<Common::UString>(), 4);
+
+	// Like when extracting the archives one after the other, the last archive wins
+	EXPECT_EQ(readFile("same.txt"), "second");
+	EXPECT_EQ(readFile("first0.txt"), "first");
+	EXPECT_EQ(readFile("second15.txt"), "second");
+}
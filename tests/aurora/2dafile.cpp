@@ -155,6 +155,122 @@ GTEST_TEST(TwoDAFileASCII, getRow) {
 	EXPECT_EQ(&twoda.getRow("ID"  , "Nope"), &twoda.getRow(Aurora::kFieldIDInvalid));
 }
 
+GTEST_TEST(TwoDAFileASCII, findRow) {
+	Common::MemoryReadStream stream(k2DAASCII);
+	const Aurora::TwoDAFile twoda(stream);
+
+	for (size_t i = 0; i < ARRAYSIZE(kDataString); i++) {
+		for (size_t j = 0; j < ARRAYSIZE(kDataString[i]); j++) {
+			if (kDataString[i][j][0] == '\0')
+				continue;
+
+			EXPECT_EQ(twoda.findRow(kHeaders[i], kDataString[i][j]), j) << "At index " << j << "." << i;
+		}
+	}
+
+	// Case-insensitive, on both the header and the value
+	EXPECT_EQ(twoda.findRow("stringvalue", "QUUX"), 2);
+
+	// Empty cells all match the (empty) default string. The first one wins
+	EXPECT_EQ(twoda.findRow("FloatValue", ""), 3);
+
+	EXPECT_EQ(twoda.findRow("Nope", "0"   ), Aurora::kFieldIDInvalid);
+	EXPECT_EQ(twoda.findRow("ID"  , "Nope"), Aurora::kFieldIDInvalid);
+}
+
+GTEST_TEST(TwoDAFileASCII, findRows) {
+	Common::MemoryReadStream stream(k2DAASCII);
+	const Aurora::TwoDAFile twoda(stream);
+
+	std::vector<Common::UString> values;
+	values.push_back("Test3");
+	values.push_back("Nope");
+	values.push_back("foobar");
+	values.push_back("Test3");
+
+	std::vector<size_t> rows;
+	twoda.findRows("StringValue", values, rows);
+
+	ASSERT_EQ(rows.size(), 4);
+	EXPECT_EQ(rows[0], 8);
+	EXPECT_EQ(rows[1], Aurora::kFieldIDInvalid);
+	EXPECT_EQ(rows[2], 0);
+	EXPECT_EQ(rows[3], 8);
+
+	twoda.findRows("Nope", values, rows);
+
+	ASSERT_EQ(rows.size(), 4);
+	for (size_t i = 0; i < rows.size(); i++)
+		EXPECT_EQ(rows[i], Aurora::kFieldIDInvalid) << "At index " << i;
+}
+
+GTEST_TEST(TwoDAFileASCII, sharedCells) {
+	static const char *k2DAShared =
+		"2DA V2.0\n"
+		"\n"
+		"  A    B\n"
+		"0 1    1.5\n"
+		"1 1.5  1\n"
+		"2 1    ****\n";
+
+	Common::MemoryReadStream stream(k2DAShared);
+	const Aurora::TwoDAFile twoda(stream);
+
+	ASSERT_EQ(twoda.getRowCount(), 3);
+
+	// Cells with the same content share the same string
+	EXPECT_EQ(&twoda.getRow(0).getString("A"), &twoda.getRow(1).getString("B"));
+	EXPECT_EQ(&twoda.getRow(0).getString("A"), &twoda.getRow(2).getString("A"));
+	EXPECT_EQ(&twoda.getRow(0).getString("B"), &twoda.getRow(1).getString("A"));
+
+	// The parsed values are still parsed per cell
+	EXPECT_EQ(twoda.getRow(0).getInt("A"), 1);
+	EXPECT_EQ(twoda.getRow(1).getInt("B"), 1);
+	EXPECT_EQ(twoda.getRow(2).getInt("B"), 0);
+	EXPECT_FLOAT_EQ(twoda.getRow(1).getFloat("A"), 1.5f);
+	EXPECT_FLOAT_EQ(twoda.getRow(0).getFloat("B"), 1.5f);
+	EXPECT_FLOAT_EQ(twoda.getRow(2).getFloat("B"), 0.0f);
+
+	EXPECT_TRUE(twoda.getRow(2).empty("B"));
+	EXPECT_TRUE(twoda.getRow(3).empty("A"));
+}
+
+GTEST_TEST(TwoDAFileASCII, tokenize) {
+	static const char *k2DATokens =
+		"2DA V2.0\r\n"
+		"DEFAULT: \"x y\"\r\n"
+		"\r\n"
+		"  A\tB    C\r\n"
+		"0 1  \"two words\"\t3\r\n"
+		"  1\t\"a\"\"b\"  \"\"  q  r  extra\r\n"
+		"\r\n"
+		"2 \"multi\nline\" x\r\n"
+		"3 \xE4\r\n";
+
+	Common::MemoryReadStream stream(k2DATokens);
+	const Aurora::TwoDAFile twoda(stream);
+
+	ASSERT_EQ(twoda.getColumnCount(), 3);
+	ASSERT_EQ(twoda.getRowCount(), 4);
+
+	EXPECT_STREQ(twoda.getRow(0).getString("B").c_str(), "two words");
+	EXPECT_STREQ(twoda.getRow(0).getString("C").c_str(), "3");
+
+	// Quotes glue tokens together. Empty tokens are dropped, superfluous tokens ignored
+	EXPECT_STREQ(twoda.getRow(1).getString("A").c_str(), "ab");
+	EXPECT_STREQ(twoda.getRow(1).getString("B").c_str(), "q");
+	EXPECT_STREQ(twoda.getRow(1).getString("C").c_str(), "r");
+
+	// Quotes can even span lines
+	EXPECT_STREQ(twoda.getRow(2).getString("A").c_str(), "multi\nline");
+	EXPECT_STREQ(twoda.getRow(2).getString("B").c_str(), "x");
+
+	// Bytes are read as Latin-1
+	EXPECT_STREQ(twoda.getRow(3).getString("A").c_str(), "\xC3\xA4");
+	EXPECT_TRUE(twoda.getRow(3).empty("B"));
+	EXPECT_STREQ(twoda.getRow(3).getString("B").c_str(), "x y");
+}
+
 GTEST_TEST(TwoDAFileASCII, writeBinary) {
 	Common::MemoryReadStream stream(k2DAASCII);
 	const Aurora::TwoDAFile twoda(stream);
@@ -0,0 +1,134 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the archive base class.
+ */
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/strutil.h"
+#include "src/common/hash.h"
+#include "src/common/readstream.h"
+
+#include "src/aurora/archive.h"
+
+/** A simple archive without contents, with a resource list we can freely modify. */
+class TestArchive : public Aurora::Archive {
+public:
+	Aurora::Archive::ResourceList resources;
+
+	const Aurora::Archive::ResourceList &getResources() const {
+		return resources;
+	}
+
+	Common::SeekableReadStream *getResource(uint32 UNUSED(index), bool UNUSED(tryNoCopy)) const {
+		return 0;
+	}
+
+	Common::HashAlgo getNameHashAlgo() const {
+		return Common::kHashFNV64;
+	}
+
+	void addResource(const Common::UString &name, Aurora::FileType type, uint32 index) {
+		Aurora::Archive::Resource res;
+
+		res.name  = name;
+		res.hash  = Common::hashString(name, Common::kHashFNV64);
+		res.type  = type;
+		res.index = index;
+
+		resources.push_back(res);
+	}
+
+	void resourcesChanged() {
+		invalidateResourceIndex();
+	}
+};
+
+static void fillArchive(TestArchive &archive, uint32 count) {
+	for (uint32 i = 0; i < count; i++)
+		archive.addResource("res" + Common::composeString(i), (i & 1) ? Aurora::kFileTypeTXT : Aurora::kFileTypeBMP, i);
+}
+
+GTEST_TEST(Archive, findResourceName) {
+	TestArchive archive;
+	fillArchive(archive, 5000);
+
+	for (uint32 i = 0; i < 5000; i++) {
+		const Common::UString name = "res" + Common::composeString(i);
+
+		const Aurora::FileType type  = (i & 1) ? Aurora::kFileTypeTXT : Aurora::kFileTypeBMP;
+		const Aurora::FileType other = (i & 1) ? Aurora::kFileTypeBMP : Aurora::kFileTypeTXT;
+
+		EXPECT_EQ(archive.findResource(name, type), i) << "At index " << i;
+		EXPECT_EQ(archive.findResource(name, other), 0xFFFFFFFF) << "At index " << i;
+	}
+
+	EXPECT_EQ(archive.findResource("nope", Aurora::kFileTypeTXT), 0xFFFFFFFF);
+	EXPECT_EQ(archive.findResource("RES1", Aurora::kFileTypeTXT), 0xFFFFFFFF);
+}
+
+GTEST_TEST(Archive, findResourceHash) {
+	TestArchive archive;
+	fillArchive(archive, 5000);
+
+	for (uint32 i = 0; i < 5000; i++) {
+		const uint64 hash = Common::hashString("res" + Common::composeString(i), Common::kHashFNV64);
+
+		EXPECT_EQ(archive.findResource(hash), i) << "At index " << i;
+	}
+
+	EXPECT_EQ(archive.findResource(Common::hashString("nope", Common::kHashFNV64)), 0xFFFFFFFF);
+}
+
+GTEST_TEST(Archive, findResourceDuplicate) {
+	TestArchive archive;
+
+	archive.addResource("foo", Aurora::kFileTypeTXT, 23);
+	archive.addResource("bar", Aurora::kFileTypeTXT, 42);
+	archive.addResource("foo", Aurora::kFileTypeTXT, 5);
+
+	// Like a linear search, the first matching resource wins
+	EXPECT_EQ(archive.findResource("foo", Aurora::kFileTypeTXT), 23);
+	EXPECT_EQ(archive.findResource(Common::hashString("foo", Common::kHashFNV64)), 23);
+}
+
+GTEST_TEST(Archive, findResourceEmpty) {
+	TestArchive archive;
+
+	EXPECT_EQ(archive.findResource("foo", Aurora::kFileTypeTXT), 0xFFFFFFFF);
+	EXPECT_EQ(archive.findResource(Common::hashString("foo", Common::kHashFNV64)), 0xFFFFFFFF);
+}
+
+GTEST_TEST(Archive, invalidateResourceIndex) {
+	TestArchive archive;
+	fillArchive(archive, 10);
+
+	EXPECT_EQ(archive.findResource("res3", Aurora::kFileTypeTXT), 3);
+	EXPECT_EQ(archive.findResource("new", Aurora::kFileTypeTXT), 0xFFFFFFFF);
+
+	archive.addResource("new", Aurora::kFileTypeTXT, 100);
+	archive.resourcesChanged();
+
+	EXPECT_EQ(archive.findResource("res3", Aurora::kFileTypeTXT), 3);
+	EXPECT_EQ(archive.findResource("new", Aurora::kFileTypeTXT), 100);
+}
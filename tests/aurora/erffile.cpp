@@ -26,6 +26,7 @@
 
 #include "src/common/error.h"
 #include "src/common/hash.h"
+#include "src/common/scopedptr.h"
 #include "src/common/memreadstream.h"
 
 #include "src/aurora/locstring.h"
@@ -513,6 +514,31 @@ GTEST_TEST(ERFFile11NWN, typeSAV) {
 	EXPECT_EQ(erf.getResources().size(), 0);
 }
 
+GTEST_TEST(ERFFile11NWN, wrongPassword) {
+	std::vector<byte> password(kERF11NWNPassword, kERF11NWNPassword + sizeof(kERF11NWNPassword));
+	password[0] ^= 0xFF;
+
+	EXPECT_THROW(Aurora::ERFFile(new Common::MemoryReadStream(kERFFile11NWN), password), Common::Exception);
+}
+
+GTEST_TEST(ERFFile11NWN, openTwice) {
+	// The second archive reuses the expanded keys of the first
+	PasswordStore password(kERF11NWNPassword);
+	const Aurora::ERFFile erf1(new Common::MemoryReadStream(kERFFile11NWN), password);
+	const Aurora::ERFFile erf2(new Common::MemoryReadStream(kERFFile11NWN), password);
+
+	Common::ScopedPtr<Common::SeekableReadStream> file1(erf1.getResource(0));
+	Common::ScopedPtr<Common::SeekableReadStream> file2(erf2.getResource(0));
+
+	ASSERT_EQ(file1->size(), strlen(kFileData));
+	ASSERT_EQ(file2->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++) {
+		EXPECT_EQ(file1->readByte(), kFileData[i]) << "At index " << i;
+		EXPECT_EQ(file2->readByte(), kFileData[i]) << "At index " << i;
+	}
+}
+
 // --- ERF V1.1 (NWN2) ---
 
 // Percy Bysshe Shelley's "Ozymandias", within an ERF V1.1 (NWN2) file
@@ -22,6 +22,10 @@
  *  Unit tests for our ERF file archive writer class.
  */
 
+#include <cstring>
+
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "src/common/memwritestream.h"
@@ -538,3 +542,217 @@ GTEST_TEST(ERFWriter, WriteMultipleFiles) {
 	delete readStream2;
 	delete readStream3;
 }
+
+/** Write the text, the logo and an empty file into an ERF and read them back. */
+static void testRoundTrip(Aurora::ERFWriter::Version version, Aurora::ERFWriter::Compression compression,
+                          uint32 expectedVersion) {
+
+	Common::MemoryReadStream dataStream1(kFileData, true);
+	const size_t kFileDataSize = dataStream1.size();
+
+	const size_t kLogoDataSize = sizeof(kLogoData);
+	Common::MemoryReadStream dataStream2(kLogoData, kLogoDataSize);
+
+	Common::MemoryReadStream dataStream3(kLogoData, (size_t) 0);
+
+	std::vector<Common::UString> names;
+	names.push_back("ozymandias.txt");
+	names.push_back("logo.bmp");
+	names.push_back("empty.txt");
+
+	Common::MemoryWriteStreamDynamic writeStream;
+	{
+		Aurora::ERFWriter erfWriter(MKTAG('E', 'R', 'F', ' '), 3, writeStream, version,
+		                            Aurora::LocString(), compression, 1, names);
+
+		erfWriter.add("ozymandias", Aurora::kFileTypeTXT, dataStream1);
+		erfWriter.add("logo", Aurora::kFileTypeBMP, dataStream2);
+		erfWriter.add("empty", Aurora::kFileTypeTXT, dataStream3);
+	}
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(writeStream.getData(), writeStream.size(), true));
+
+	EXPECT_EQ(erf.getID(), MKTAG('E', 'R', 'F', ' '));
+	EXPECT_EQ(erf.getVersion(), expectedVersion);
+	ASSERT_EQ(erf.getResources().size(), 3);
+
+	EXPECT_EQ(erf.findResource("ozymandias", Aurora::kFileTypeTXT), 0);
+	EXPECT_EQ(erf.findResource("logo", Aurora::kFileTypeBMP), 1);
+	EXPECT_EQ(erf.findResource("empty", Aurora::kFileTypeTXT), 2);
+	EXPECT_EQ(erf.findResource("logo", Aurora::kFileTypeTXT), 0xFFFFFFFF);
+
+	EXPECT_EQ(erf.getResourceSize(0), kFileDataSize);
+	EXPECT_EQ(erf.getResourceSize(1), kLogoDataSize);
+	EXPECT_EQ(erf.getResourceSize(2), 0);
+
+	Common::ScopedPtr<Common::SeekableReadStream> readStream1(erf.getResource(0));
+	ASSERT_EQ(readStream1->size(), kFileDataSize);
+
+	Common::ScopedPtr<Common::SeekableReadStream> readStream2(erf.getResource(1));
+	ASSERT_EQ(readStream2->size(), kLogoDataSize);
+
+	Common::ScopedPtr<Common::SeekableReadStream> readStream3(erf.getResource(2));
+	EXPECT_EQ(readStream3->size(), 0);
+
+	for (size_t i = 0; i < kFileDataSize; ++i)
+		EXPECT_EQ(readStream1->readByte(), (byte) kFileData[i]) << "At index " << i;
+
+	for (size_t i = 0; i < kLogoDataSize; ++i)
+		EXPECT_EQ(readStream2->readByte(), kLogoData[i]) << "At index " << i;
+}
+
+GTEST_TEST(ERFWriter, WriteV20) {
+	testRoundTrip(Aurora::ERFWriter::kERFVersion20, Aurora::ERFWriter::kCompressionNone, MKTAG('V', '2', '.', '0'));
+}
+
+GTEST_TEST(ERFWriter, WriteV22) {
+	testRoundTrip(Aurora::ERFWriter::kERFVersion22, Aurora::ERFWriter::kCompressionNone, MKTAG('V', '2', '.', '2'));
+}
+
+GTEST_TEST(ERFWriter, WriteV22BioWareZlib) {
+	testRoundTrip(Aurora::ERFWriter::kERFVersion22, Aurora::ERFWriter::kCompressionBioWareZlib,
+	              MKTAG('V', '2', '.', '2'));
+}
+
+GTEST_TEST(ERFWriter, WriteV22HeaderlessZlib) {
+	testRoundTrip(Aurora::ERFWriter::kERFVersion22, Aurora::ERFWriter::kCompressionHeaderlessZlib,
+	              MKTAG('V', '2', '.', '2'));
+}
+
+GTEST_TEST(ERFWriter, WriteV30) {
+	testRoundTrip(Aurora::ERFWriter::kERFVersion30, Aurora::ERFWriter::kCompressionNone, MKTAG('V', '3', '.', '0'));
+}
+
+GTEST_TEST(ERFWriter, WriteV30BioWareZlib) {
+	testRoundTrip(Aurora::ERFWriter::kERFVersion30, Aurora::ERFWriter::kCompressionBioWareZlib,
+	              MKTAG('V', '3', '.', '0'));
+}
+
+GTEST_TEST(ERFWriter, WriteV30HeaderlessZlib) {
+	testRoundTrip(Aurora::ERFWriter::kERFVersion30, Aurora::ERFWriter::kCompressionHeaderlessZlib,
+	              MKTAG('V', '3', '.', '0'));
+}
+
+GTEST_TEST(ERFWriter, WriteV30LongNames) {
+	// Names far longer than the 64 bytes per file an average archive might need
+	std::vector<Common::UString> resRefs, names;
+	for (size_t i = 0; i < 3; i++) {
+		Common::UString resRef = Common::UString::format("file_%u_", (uint) i);
+		while (resRef.size() < 200)
+			resRef += "very_long_name_";
+
+		resRefs.push_back(resRef);
+		names.push_back(resRef + ".txt");
+	}
+
+	Common::MemoryWriteStreamDynamic writeStream;
+	{
+		Aurora::ERFWriter erfWriter(MKTAG('E', 'R', 'F', ' '), 3, writeStream, Aurora::ERFWriter::kERFVersion30,
+		                            Aurora::LocString(), Aurora::ERFWriter::kCompressionNone, 1, names);
+
+		for (size_t i = 0; i < 3; i++) {
+			Common::MemoryReadStream dataStream(kFileData, true);
+			erfWriter.add(resRefs[i], Aurora::kFileTypeTXT, dataStream);
+		}
+	}
+
+	// The string table holds exactly the names, without any padding
+	size_t stringTableSize = 0;
+	for (size_t i = 0; i < 3; i++)
+		stringTableSize += names[i].size() + 1;
+
+	// Including the terminating 0
+	const size_t kFileDataSize = std::strlen(kFileData) + 1;
+	EXPECT_EQ(writeStream.size(), 0x30 + stringTableSize + 3 * 28 + 3 * kFileDataSize);
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(writeStream.getData(), writeStream.size(), true));
+	ASSERT_EQ(erf.getResources().size(), 3);
+
+	for (uint32 i = 0; i < 3; i++) {
+		EXPECT_EQ(erf.findResource(resRefs[i], Aurora::kFileTypeTXT), i);
+
+		Common::ScopedPtr<Common::SeekableReadStream> readStream(erf.getResource(i));
+		ASSERT_EQ(readStream->size(), kFileDataSize);
+
+		for (size_t j = 0; j < kFileDataSize; ++j)
+			EXPECT_EQ(readStream->readByte(), (byte) kFileData[j]) << "In file " << i << ", at index " << j;
+	}
+}
+
+GTEST_TEST(ERFWriter, WriteV30MissingNames) {
+	Common::MemoryWriteStreamDynamic writeStream;
+
+	// Without the names, the size of the string table is unknown
+	EXPECT_THROW(Aurora::ERFWriter(MKTAG('E', 'R', 'F', ' '), 1, writeStream, Aurora::ERFWriter::kERFVersion30),
+	             Common::Exception);
+
+	std::vector<Common::UString> names;
+	names.push_back("ozymandias.txt");
+
+	Common::MemoryReadStream dataStream(kFileData, true);
+
+	// A name that's longer than the one given up front doesn't fit
+	Aurora::ERFWriter erfWriter(MKTAG('E', 'R', 'F', ' '), 1, writeStream, Aurora::ERFWriter::kERFVersion30,
+	                            Aurora::LocString(), Aurora::ERFWriter::kCompressionNone, 1, names);
+	EXPECT_THROW(erfWriter.add("ozymandias_long", Aurora::kFileTypeTXT, dataStream), Common::Exception);
+}
+
+GTEST_TEST(ERFWriter, WriteCompressedThreaded) {
+	// Large enough to be compressed in several chunks
+	const size_t kBigDataSize = 1000 * 1000;
+
+	Common::ScopedArray<byte> bigData(new byte[kBigDataSize]);
+	for (size_t i = 0; i < kBigDataSize; i++)
+		bigData[i] = kFileData[(i * 7 + i / 1000) % std::strlen(kFileData)];
+
+	Common::MemoryWriteStreamDynamic writeStream;
+	{
+		Aurora::ERFWriter erfWriter(MKTAG('E', 'R', 'F', ' '), 4, writeStream, Aurora::ERFWriter::kERFVersion22,
+		                            Aurora::LocString(), Aurora::ERFWriter::kCompressionBioWareZlib, 3);
+
+		for (size_t i = 0; i < 4; i++) {
+			Common::MemoryReadStream dataStream(bigData.get(), kBigDataSize);
+			erfWriter.add(Common::UString::format("big_%u", (uint) i), Aurora::kFileTypeTXT, dataStream);
+		}
+	}
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(writeStream.getData(), writeStream.size(), true));
+	ASSERT_EQ(erf.getResources().size(), 4);
+
+	for (uint32 i = 0; i < 4; i++) {
+		EXPECT_EQ(erf.findResource(Common::UString::format("big_%u", (uint) i), Aurora::kFileTypeTXT), i);
+
+		Common::ScopedPtr<Common::SeekableReadStream> readStream(erf.getResource(i));
+		ASSERT_EQ(readStream->size(), kBigDataSize);
+
+		Common::ScopedArray<byte> fileData(new byte[kBigDataSize]);
+		ASSERT_EQ(readStream->read(fileData.get(), kBigDataSize), kBigDataSize);
+
+		EXPECT_EQ(std::memcmp(fileData.get(), bigData.get(), kBigDataSize), 0) << "In file " << i;
+	}
+}
+
+GTEST_TEST(ERFWriter, CompressionUnsupported) {
+	Common::MemoryWriteStreamDynamic writeStream;
+
+	EXPECT_THROW(Aurora::ERFWriter(MKTAG('E', 'R', 'F', ' '), 0, writeStream, Aurora::ERFWriter::kERFVersion10,
+	                               Aurora::LocString(), Aurora::ERFWriter::kCompressionBioWareZlib),
+	             Common::Exception);
+	EXPECT_THROW(Aurora::ERFWriter(MKTAG('E', 'R', 'F', ' '), 0, writeStream, Aurora::ERFWriter::kERFVersion20,
+	                               Aurora::LocString(), Aurora::ERFWriter::kCompressionHeaderlessZlib),
+	             Common::Exception);
+}
+
+GTEST_TEST(ERFWriter, TooManyFiles) {
+	Common::MemoryReadStream dataStream(kFileData, true);
+
+	std::vector<Common::UString> names;
+	names.push_back("ozymandias.txt");
+
+	Common::MemoryWriteStreamDynamic writeStream;
+	Aurora::ERFWriter erfWriter(MKTAG('E', 'R', 'F', ' '), 1, writeStream, Aurora::ERFWriter::kERFVersion30,
+	                            Aurora::LocString(), Aurora::ERFWriter::kCompressionNone, 1, names);
+
+	erfWriter.add("ozymandias", Aurora::kFileTypeTXT, dataStream);
+	EXPECT_THROW(erfWriter.add("ozymandias_2", Aurora::kFileTypeTXT, dataStream), Common::Exception);
+}
@@ -22,6 +22,9 @@
  *  Unit tests for our GDA file reader class.
  */
 
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
 #include "gtest/gtest.h"
 
 #include "src/common/util.h"
@@ -29,6 +32,7 @@
 #include "src/common/encoding.h"
 #include "src/common/hash.h"
 #include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
 #include "src/aurora/gff4file.h"
 #include "src/aurora/gff4fields.h"
 
@@ -362,10 +366,39 @@ GTEST_TEST(GDAFile, add) {
 	EXPECT_EQ(gda.getColumnCount(), 2);
 	EXPECT_EQ(gda.getRowCount(), ARRAYSIZE(kIDs));
 
+	// The rows are in the order the GDAs were added
+	static const size_t kIndices[9] = { 0, 1, 2, 6, 7, 8, 3, 4, 5 };
+
 	for (size_t i = 0; i < ARRAYSIZE(kIDs); i++) {
 		const size_t index = gda.findRow(kIDs[i]);
 		ASSERT_NE(index, Aurora::GDAFile::kInvalidRow);
 
+		EXPECT_EQ(index, kIndices[i]);
 		EXPECT_EQ(gda.getInt(index, "Value"), kIDs[i]);
 	}
+
+	EXPECT_EQ(gda.findRow(3), Aurora::GDAFile::kInvalidRow);
+	EXPECT_FALSE(gda.hasRow(ARRAYSIZE(kIDs)));
+}
+
+static void findRowsAndColumns(const Aurora::GDAFile &gda) {
+	for (size_t n = 0; n < 1000; n++) {
+		for (size_t i = 0; i < ARRAYSIZE(kDataID); i++)
+			if (gda.findRow(kDataID[i]) != i)
+				throw Common::Exception("Row with ID %d not found", (int) kDataID[i]);
+
+		for (size_t i = 0; i < ARRAYSIZE(kHeaders); i++)
+			if (gda.findColumn(kHeaders[i]) != kFields[i])
+				throw Common::Exception("Column \"%s\" not found", kHeaders[i]);
+	}
+}
+
+GTEST_TEST(GDAFile, findConcurrent) {
+	const Aurora::GDAFile gda(new Common::MemoryReadStream(kGDAFile));
+
+	Common::ThreadPool pool(4);
+	for (size_t i = 0; i < 8; i++)
+		pool.addJob(boost::bind(&findRowsAndColumns, boost::cref(gda)));
+
+	EXPECT_NO_THROW(pool.wait());
 }
@@ -65,6 +65,18 @@ GTEST_TEST(KEYFile10, getResources) {
 	EXPECT_EQ(res[0].resIndex, 1);
 }
 
+GTEST_TEST(KEYFile10, getBIFResources) {
+	Common::MemoryReadStream stream(kKEY10File);
+	Aurora::KEYFile key(stream);
+
+	const Aurora::KEYFile::ResourceIndexList &res = key.getBIFResources(0);
+	ASSERT_EQ(res.size(), 1);
+
+	EXPECT_EQ(res[0], 0);
+
+	EXPECT_TRUE(key.getBIFResources(1).empty());
+}
+
 // --- KEY V1.1 ---
 
 static const byte kKEY11File[] = {
@@ -100,3 +112,15 @@ GTEST_TEST(KEYFile11, getResources) {
 	EXPECT_EQ(res[0].bifIndex, 0);
 	EXPECT_EQ(res[0].resIndex, 1);
 }
+
+GTEST_TEST(KEYFile11, getBIFResources) {
+	Common::MemoryReadStream stream(kKEY11File);
+	Aurora::KEYFile key(stream);
+
+	const Aurora::KEYFile::ResourceIndexList &res = key.getBIFResources(0);
+	ASSERT_EQ(res.size(), 1);
+
+	EXPECT_EQ(res[0], 0);
+
+	EXPECT_TRUE(key.getBIFResources(1).empty());
+}
@@ -0,0 +1,406 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our OBB virtual filesystem archive class.
+ */
+
+#include <cstring>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+#include "src/common/scopedptr.h"
+
+#include "src/aurora/obbfile.h"
+
+// Percy Bysshe Shelley's "Ozymandias"
+static const char *kFileData =
+	"I met a traveller from an antique land\n"
+	"Who said: Two vast and trunkless legs of stone\n"
+	"Stand in the desert. Near them, on the sand,\n"
+	"Half sunk, a shattered visage lies, whose frown,\n"
+	"And wrinkled lip, and sneer of cold command,\n"
+	"Tell that its sculptor well those passions read\n"
+	"Which yet survive, stamped on these lifeless things,\n"
+	"The hand that mocked them and the heart that fed:\n"
+	"And on the pedestal these words appear:\n"
+	"'My name is Ozymandias, king of kings:\n"
+	"Look on my works, ye Mighty, and despair!'\n"
+	"Nothing beside remains. Round the decay\n"
+	"Of that colossal wreck, boundless and bare\n"
+	"The lone and level sands stretch far away.";
+
+static const char *kSmallData = "Nothing beside remains.";
+
+/* An OBB file with four entries:
+ * - data/ozymandias.txt: 16 numbered copies of "Ozymandias", in 3 chunks
+ * - data: a directory
+ * - data/small.txt: kSmallData, in 1 chunk
+ * - data/letters.txt: 39 chunks of 4096 copies of one letter each,
+ *                     'A' to 'Z' and again from 'A', plus 1000 'Z' */
+static const byte kOBBFile[] = {
+	0x78,0x9C,0xED,0x92,0xBB,0x8E,0xDC,0x30,0x0C,0x45,0x7B,0x7D,0x05,0x53,0x4D,0x63,
+	0x0C,0x66,0x37,0x8F,0xC2,0x5D,0xBA,0x5D,0x60,0x1F,0x40,0xB2,0x40,0x6A,0x8E,0x45,
+	0x8F,0x05,0xEB,0xE1,0x15,0x65,0x1B,0xCE,0xD7,0x87,0x92,0xE7,0x13,0x02,0x57,0x02,
+	0x06,0x1E,0x40,0x14,0x79,0xEF,0xA5,0xCE,0xE5,0xD2,0xC2,0x33,0x38,0x4A,0x80,0x90,
+	0x22,0x2E,0x64,0x2D,0x45,0xE8,0x63,0x70,0x80,0x5E,0x7E,0xC9,0x7C,0xCE,0x04,0x16,
+	0xBD,0x56,0x7F,0x86,0x00,0x8C,0x46,0xB7,0xF0,0xB1,0x06,0x58,0x90,0xA5,0xC7,0x6B,
+	0xE9,0x9A,0xFD,0x68,0x89,0x19,0x2C,0xDD,0x18,0x42,0x0F,0x9C,0x82,0x27,0xF5,0x3B,
+	0xE5,0xAA,0xF1,0x90,0x06,0x02,0x4D,0x4C,0x31,0x9D,0xE1,0x8D,0x30,0xE6,0x03,0xD7,
+	0x40,0xD8,0x2B,0x2C,0xB7,0x1A,0xF5,0x84,0x56,0xFA,0x64,0x50,0x23,0x3E,0x78,0xC0,
+	0x94,0x28,0x92,0x86,0xC5,0x30,0xDE,0x44,0xDE,0x10,0x37,0xB0,0x0E,0x81,0x29,0x5B,
+	0x5B,0x7D,0xA3,0x7E,0xCA,0xEC,0x35,0x9A,0xAC,0xAC,0xA5,0x3E,0x35,0xC5,0x0B,0x7B,
+	0x12,0xF7,0x62,0xA1,0x0B,0x56,0xCB,0xC7,0xB9,0x32,0xFD,0x43,0x52,0x89,0x18,0x26,
+	0x30,0x89,0x81,0xBB,0xD9,0x4E,0x29,0x44,0x58,0xF7,0xE3,0x3C,0x75,0x42,0x66,0x13,
+	0x3C,0x43,0x24,0xCC,0x49,0x4D,0x37,0xC0,0x26,0x4B,0xE1,0x39,0x2E,0x66,0xA1,0x46,
+	0x32,0xA1,0x9B,0x44,0x6A,0x77,0xCD,0xD9,0x53,0x4F,0x25,0x75,0x1A,0x8C,0xBF,0xB1,
+	0x88,0x48,0x98,0xA1,0x2C,0x24,0x0B,0xB9,0xD0,0x8D,0xA4,0x4B,0xD4,0x7D,0x4B,0xB9,
+	0x2A,0xE1,0xD3,0x5E,0xEE,0x49,0xB7,0x25,0xC3,0x7D,0x0B,0x32,0x9A,0x44,0xC2,0xDE,
+	0x87,0xAF,0x21,0x6A,0x06,0x9C,0x26,0xE9,0x68,0xD5,0xE9,0x75,0x03,0x8F,0x8E,0xC0,
+	0x30,0xBC,0xFF,0xDD,0x72,0x26,0x83,0xB2,0x90,0x51,0x84,0x73,0xD8,0xFC,0xCF,0xAD,
+	0x7A,0x09,0x61,0xCC,0xF3,0xDC,0x96,0xFB,0x47,0xB9,0xB0,0x11,0xBC,0x9A,0xDB,0x90,
+	0xB6,0x7D,0x3B,0x22,0x31,0xA1,0x89,0x5F,0x4E,0xEA,0x2D,0x14,0xD7,0x70,0x25,0x36,
+	0x9A,0x24,0xB4,0x43,0xE3,0xF9,0x0C,0xBF,0xC2,0x7C,0xF7,0xAA,0xA9,0xC3,0x4D,0xBD,
+	0xF7,0xBB,0x5D,0x59,0x67,0x60,0x16,0x7B,0x6B,0xA4,0x4E,0xDE,0xE8,0x9A,0xEF,0x95,
+	0xF4,0x79,0xEE,0x15,0x23,0x95,0xF8,0x56,0xDE,0xBD,0x9C,0x58,0x12,0x90,0xCA,0xD3,
+	0xCA,0xBA,0x53,0xA4,0x24,0xEB,0xEC,0xE5,0xE5,0x71,0xC5,0xED,0xAC,0x2E,0x0F,0x95,
+	0xB9,0xCA,0xDC,0xC1,0xCC,0x3D,0x56,0xE6,0x2A,0x73,0x07,0x33,0xF7,0xB5,0x32,0x57,
+	0x99,0x3B,0x98,0xB9,0x6F,0x95,0xB9,0xCA,0xDC,0xC1,0xCC,0x7D,0xAF,0xCC,0x55,0xE6,
+	0x0E,0x66,0xEE,0x47,0x65,0xEE,0x7F,0x30,0xF7,0x0F,0x0C,0x52,0xA3,0x3F,0x78,0x9C,
+	0xED,0x92,0x3D,0x6F,0xDC,0x30,0x0C,0x86,0x77,0xFD,0x0A,0x76,0xCA,0x22,0x1C,0x92,
+	0x76,0x48,0xEB,0xAD,0x5B,0x02,0xE4,0x03,0x68,0x0E,0xE8,0xCC,0xB3,0xE9,0xB3,0x60,
+	0x7D,0xB8,0xA2,0x6C,0xC3,0xFD,0xF5,0xA5,0xE4,0xEB,0x58,0xA0,0x93,0x27,0x01,0x86,
+	0x2D,0x4B,0x22,0xF9,0xF2,0xE5,0xA3,0xD5,0x79,0x20,0x18,0xD0,0x77,0x90,0x06,0x4C,
+	0xE0,0x42,0x3B,0x52,0x5E,0x93,0x83,0x7D,0x53,0x4E,0x09,0x63,0xDA,0x8F,0x7B,0xEA,
+	0x1A,0xF5,0x5D,0xF6,0x83,0x2F,0x47,0x13,0x75,0xC4,0x09,0x6D,0xFE,0x61,0x82,0x35,
+	0xC4,0x8E,0x01,0xA7,0x49,0x22,0x1A,0x75,0xF7,0xBA,0x81,0x47,0x47,0x60,0x18,0xDE,
+	0x7F,0x6F,0x4E,0xF2,0x19,0x64,0x0D,0xA3,0xF1,0x57,0x08,0x7D,0xF9,0x72,0xA3,0x5E,
+	0x42,0x18,0x73,0x3E,0xB7,0xE5,0xF8,0x51,0x2E,0x6C,0x04,0xAF,0xE6,0x3A,0xA4,0x4D,
+	0x17,0x0D,0x52,0x62,0x42,0x13,0x3F,0xDD,0xA9,0xB7,0x90,0x86,0x1C,0x7C,0x21,0x36,
+	0x1D,0x41,0x24,0x87,0xC6,0xF3,0x09,0x7E,0x84,0xF9,0xA6,0xB5,0xA3,0x16,0x37,0xF5,
+	0xDE,0xEF,0x72,0xDB,0x60,0x03,0xB3,0xC8,0x5B,0x23,0xB5,0xA3,0x86,0x4B,0xBE,0x67,
+	0x89,0xB9,0xE4,0xBD,0x60,0xA4,0xD2,0xBE,0x0D,0x9E,0xCA,0x8E,0xA5,0x85,0x2C,0xB0,
+	0x2C,0x19,0x38,0x45,0x4A,0xED,0x00,0x3D,0x46,0xC0,0x15,0xB7,0x93,0xBA,0x7F,0x6C,
+	0xE0,0x19,0x1C,0x25,0x40,0x48,0x11,0xE5,0xAA,0xA5,0x08,0x7D,0x0C,0xD9,0x2A,0x79,
+	0x92,0xF9,0x35,0x4B,0x32,0x89,0x56,0x3F,0x87,0x20,0x69,0x4C,0xD7,0xC0,0x79,0x0D,
+	0xB0,0x20,0xA7,0xDD,0xCD,0x38,0xFB,0xB1,0xD4,0xB7,0x74,0xE5,0xEC,0x01,0x27,0xA9,
+	0xAD,0x3E,0x52,0x3E,0x35,0xFE,0xD6,0x02,0x53,0x4C,0x27,0x78,0x13,0x13,0xCB,0x20,
+	0xF4,0x5F,0xB7,0xB3,0x30,0xAD,0x9E,0xD0,0x4A,0x9C,0x24,0x12,0x77,0x80,0xA5,0xCD,
+	0x44,0x51,0x46,0xB6,0x18,0xC6,0xAB,0x94,0x37,0x24,0x0E,0xAE,0x43,0x90,0x71,0x88,
+	0xB4,0xD5,0xEB,0x32,0xAF,0x35,0x9A,0x5C,0x59,0x5A,0x34,0xD3,0xEE,0x2A,0x7B,0x12,
+	0xF5,0x22,0x41,0x4C,0xEA,0xE4,0xE5,0x5C,0xC9,0x7E,0x96,0xAE,0x76,0xF3,0x4C,0x12,
+	0x13,0xDA,0xD9,0x4E,0x29,0x44,0x58,0xF7,0xED,0x9C,0x75,0x42,0x66,0x13,0x3C,0x8B,
+	0xFD,0x98,0x3B,0x35,0x62,0xD2,0x26,0xA6,0xF0,0x1C,0x17,0xB3,0x90,0x96,0x9E,0xD0,
+	0x09,0x18,0x37,0xD5,0x9C,0x35,0xF5,0x54,0xBA,0x2E,0xD3,0x63,0x5D,0x99,0xFB,0x7F,
+	0xE6,0xBE,0x56,0xE6,0x2A,0x73,0x07,0x33,0xF7,0xAD,0x32,0x57,0x99,0x3B,0x96,0xB9,
+	0x87,0xFB,0xCA,0x5C,0x65,0xEE,0x60,0xE6,0x1E,0x2A,0x73,0x95,0xB9,0x83,0x99,0xFB,
+	0x5C,0x99,0xAB,0xCC,0x1D,0xCC,0xDC,0x97,0x7F,0x33,0xF7,0x07,0xBB,0xD7,0xA0,0xC4,
+	0x78,0x9C,0xED,0x52,0xB9,0x6E,0xDC,0x40,0x0C,0xED,0xE7,0x2B,0x98,0xCA,0x8D,0xB0,
+	0x40,0x80,0xA4,0x51,0xE7,0xCE,0x06,0x7C,0x00,0x89,0x81,0xD4,0x5C,0x0D,0xB5,0x22,
+	0x34,0x87,0x32,0xE4,0x4A,0x90,0xBF,0xDE,0x9C,0xD1,0xFE,0x42,0x52,0x6D,0x23,0x01,
+	0x43,0xF2,0x5D,0x64,0x02,0x4C,0xCA,0x7F,0xAF,0x04,0x01,0x93,0x77,0x7F,0xA6,0x0C,
+	0x82,0xEC,0x7B,0xF8,0xD8,0x32,0xAC,0x28,0x6A,0x75,0x0F,0x5A,0xAE,0x69,0x0E,0x24,
+	0x02,0x81,0x2E,0x02,0x79,0x04,0xD1,0x9C,0xC8,0xFD,0xD6,0x5A,0xE5,0x04,0x3A,0x11,
+	0x78,0x12,0x2A,0x7A,0x82,0x37,0xC2,0x52,0x1F,0x62,0x07,0xF9,0xA8,0x88,0x75,0x75,
+	0xEE,0x09,0x83,0xCD,0x19,0x50,0x07,0x08,0x32,0xA1,0x2A,0x15,0xF2,0xB0,0xB2,0xE0,
+	0xC5,0xE8,0x99,0xA4,0x83,0x6D,0xCA,0x42,0x30,0x96,0xBC,0xA5,0xCE,0x3D,0x1A,0xF6,
+	0x56,0xB8,0x32,0x7B,0xAB,0x2F,0x5D,0xD3,0x22,0x89,0xA8,0x54,0x09,0x43,0x0E,0xDE,
+	0x3E,0x31,0x36,0xF4,0x0F,0x0A,0xC1,0xC8,0x50,0x81,0x55,0x40,0x86,0x6B,0x58,0x34,
+	0x17,0xD8,0x8E,0xE7,0x8A,0xBA,0xA0,0x08,0xE7,0x24,0x50,0x08,0xAB,0x53,0x1E,0x26,
+	0xD8,0x49,0x4D,0x52,0x59,0x79,0xA5,0xCE,0x3C,0x61,0x5C,0x8C,0xEA,0x50,0x2D,0x55,
+	0xD3,0x48,0xCD,0xB5,0x4E,0x9C,0x2E,0x62,0x24,0x66,0x66,0x6A,0x81,0x54,0xA2,0x98,
+	0x87,0x99,0x7C,0xB3,0x7A,0xA4,0x54,0xAB,0x66,0x5E,0x8F,0xF2,0x48,0xBE,0x6F,0x1E,
+	0x6E,0x29,0x18,0x34,0x19,0x45,0xB8,0x81,0x6F,0xB9,0x78,0x01,0x5C,0x16,0x9B,0xE8,
+	0xDD,0xC3,0xEB,0x0E,0x09,0x23,0x01,0x0B,0xBC,0x7F,0xEE,0xD5,0x13,0xA3,0x05,0x32,
+	0x1B,0x71,0x35,0x5B,0xFF,0xD2,0xBB,0x97,0x9C,0xE7,0x8A,0x17,0xF7,0x3A,0x3F,0x5B,
+	0xC3,0x4E,0xF0,0xCA,0x97,0x49,0xF7,0x23,0x1D,0xA3,0x58,0x90,0xCB,0xB7,0x07,0xF7,
+	0x96,0x9B,0x6A,0x38,0x93,0xB0,0x27,0x33,0x1D,0x91,0x93,0x9C,0xE0,0x57,0xBE,0xDE,
+	0xB4,0x7A,0x1A,0x70,0x77,0xEF,0xE3,0x21,0xD7,0xE2,0xCC,0x22,0x26,0x6F,0x2B,0x34,
+	0xD8,0x8E,0xCE,0xB5,0xAF,0xB9,0xAF,0xB8,0x67,0x2C,0xD4,0xEC,0x07,0xDB,0x7B,0x7B,
+	0x09,0xB4,0x52,0x68,0xAB,0xB5,0xB8,0xB5,0x90,0x5A,0x9C,0xA3,0x6D,0x1E,0x37,0xDC,
+	0x4F,0xEE,0xFB,0x8F,0x1E,0x9E,0x21,0x5A,0xBC,0x68,0xD7,0x83,0xD6,0x1A,0x6C,0x6B,
+	0xB6,0xD8,0x1A,0xD5,0xFD,0xE6,0xEE,0x37,0xF7,0x2F,0x6E,0xEE,0xE7,0xFD,0xE6,0xEE,
+	0x37,0xF7,0x7F,0x6F,0xEE,0x0B,0x98,0xAE,0x8E,0x36,0x40,0x27,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x2A,0x05,0x00,0x00,0x00,0x00,0x00,0x00,0x78,0x9C,0xF3,0xCB,0x2F,0xC9,
+	0xC8,0xCC,0x4B,0x57,0x48,0x4A,0x2D,0xCE,0x4C,0x49,0x55,0x28,0x4A,0xCD,0x4D,0xCC,
+	0xCC,0x2B,0xD6,0x03,0x00,0x68,0xD2,0x08,0xA1,0x17,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x2F,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,
+	0x00,0x00,0xC2,0xA0,0x6C,0xEF,0x5F,0xCA,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,
+	0x00,0xFF,0xAD,0x10,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,
+	0x6E,0xEF,0x1F,0xCA,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x0F,0x3C,0x20,
+	0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x70,0xEF,0xDF,0xC9,
+	0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x1E,0xBC,0x30,0x3D,0x78,0x9C,0xED,
+	0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x72,0xEF,0x9F,0xC9,0x1E,0x0E,0x28,0x00,
+	0x00,0x00,0xE0,0xDD,0x00,0x2E,0x3C,0x40,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,
+	0x00,0x00,0xC2,0xA0,0x74,0xEF,0x5F,0xC9,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,
+	0x00,0x3D,0xBC,0x50,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,
+	0x76,0xEF,0x1F,0xC9,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x4D,0x3C,0x60,
+	0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x78,0xEF,0xDF,0xC8,
+	0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x5C,0xBC,0x70,0x3D,0x78,0x9C,0xED,
+	0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x7A,0xEF,0x9F,0xC8,0x1E,0x0E,0x28,0x00,
+	0x00,0x00,0xE0,0xDD,0x00,0x6C,0x3C,0x80,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,
+	0x00,0x00,0xC2,0xA0,0x7C,0xEF,0x5F,0xC8,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,
+	0x00,0x7B,0xBC,0x90,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,
+	0x7E,0xEF,0x1F,0xC8,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x8B,0x3C,0xA0,
+	0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x80,0xEF,0xDF,0xC7,
+	0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x9A,0xBC,0xB0,0x3D,0x78,0x9C,0xED,
+	0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x82,0xEF,0x9F,0xC7,0x1E,0x0E,0x28,0x00,
+	0x00,0x00,0xE0,0xDD,0x00,0xAA,0x3C,0xC0,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,
+	0x00,0x00,0xC2,0xA0,0x84,0xEF,0x5F,0xC7,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,
+	0x00,0xB9,0xBC,0xD0,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,
+	0x86,0xEF,0x1F,0xC7,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0xC9,0x3C,0xE0,
+	0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x88,0xEF,0xDF,0xC6,
+	0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0xD8,0xBC,0xF0,0x3D,0x78,0x9C,0xED,
+	0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x8A,0xEF,0x9F,0xC6,0x1E,0x0E,0x28,0x00,
+	0x00,0x00,0xE0,0xDD,0x00,0xE8,0x3C,0x00,0x4C,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,
+	0x00,0x00,0xC2,0xA0,0x8C,0xEF,0x5F,0xC6,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,
+	0x00,0xF7,0xBC,0x10,0x4C,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,
+	0x8E,0xEF,0x1F,0xC6,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x07,0x4B,0x20,
+	0x4C,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x90,0xEF,0xDF,0xC5,
+	0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x16,0xCB,0x30,0x4C,0x78,0x9C,0xED,
+	0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x92,0xEF,0x9F,0xC5,0x1E,0x0E,0x28,0x00,
+	0x00,0x00,0xE0,0xDD,0x00,0x26,0x4B,0x40,0x4C,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,
+	0x00,0x00,0xC2,0xA0,0x94,0xEF,0x5F,0xC5,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,
+	0x00,0x35,0xCB,0x50,0x4C,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,
+	0x96,0xEF,0x1F,0xC5,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x45,0x4B,0x60,
+	0x4C,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x98,0xEF,0xDF,0xC4,
+	0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x54,0xCB,0x70,0x4C,0x78,0x9C,0xED,
+	0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x9A,0xEF,0x9F,0xC4,0x1E,0x0E,0x28,0x00,
+	0x00,0x00,0xE0,0xDD,0x00,0x64,0x4B,0x80,0x4C,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,
+	0x00,0x00,0xC2,0xA0,0x9C,0xEF,0x5F,0xC4,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,
+	0x00,0x73,0xCB,0x90,0x4C,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,
+	0x9E,0xEF,0x1F,0xC4,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x83,0x4B,0xA0,
+	0x4C,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x6C,0xEF,0x5F,0xCA,
+	0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0xFF,0xAD,0x10,0x3D,0x78,0x9C,0xED,
+	0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x6E,0xEF,0x1F,0xCA,0x1E,0x0E,0x28,0x00,
+	0x00,0x00,0xE0,0xDD,0x00,0x0F,0x3C,0x20,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,
+	0x00,0x00,0xC2,0xA0,0x70,0xEF,0xDF,0xC9,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,
+	0x00,0x1E,0xBC,0x30,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,
+	0x72,0xEF,0x9F,0xC9,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x2E,0x3C,0x40,
+	0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x74,0xEF,0x5F,0xC9,
+	0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x3D,0xBC,0x50,0x3D,0x78,0x9C,0xED,
+	0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x76,0xEF,0x1F,0xC9,0x1E,0x0E,0x28,0x00,
+	0x00,0x00,0xE0,0xDD,0x00,0x4D,0x3C,0x60,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,
+	0x00,0x00,0xC2,0xA0,0x78,0xEF,0xDF,0xC8,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,
+	0x00,0x5C,0xBC,0x70,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,
+	0x7A,0xEF,0x9F,0xC8,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x6C,0x3C,0x80,
+	0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x7C,0xEF,0x5F,0xC8,
+	0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0x7B,0xBC,0x90,0x3D,0x78,0x9C,0xED,
+	0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x7E,0xEF,0x1F,0xC8,0x1E,0x0E,0x28,0x00,
+	0x00,0x00,0xE0,0xDD,0x00,0x8B,0x3C,0xA0,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,
+	0x00,0x00,0xC2,0xA0,0x80,0xEF,0xDF,0xC7,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,
+	0x00,0x9A,0xBC,0xB0,0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,
+	0x82,0xEF,0x9F,0xC7,0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0xAA,0x3C,0xC0,
+	0x3D,0x78,0x9C,0xED,0xC1,0x01,0x0D,0x00,0x00,0x00,0xC2,0xA0,0x84,0xEF,0x5F,0xC7,
+	0x1E,0x0E,0x28,0x00,0x00,0x00,0xE0,0xDD,0x00,0xB9,0xBC,0xD0,0x3D,0x78,0x9C,0x8B,
+	0x8A,0x1A,0x05,0xA3,0x60,0x14,0x0C,0x77,0x00,0x00,0x81,0x31,0x5F,0xA0,0xE8,0x73,
+	0x02,0x00,0x00,0x00,0x00,0x00,0x65,0x04,0x00,0x00,0x00,0x00,0x00,0x00,0x78,0x9C,
+	0x63,0x61,0x80,0x00,0x61,0x28,0x9D,0x92,0x58,0x92,0xA8,0x9F,0x5F,0x55,0x99,0x9B,
+	0x98,0x97,0x92,0x99,0x58,0xAC,0x57,0x52,0x51,0x02,0x95,0x61,0x70,0x50,0x87,0xD0,
+	0x5A,0xAC,0x10,0x9A,0x05,0x49,0x0B,0x03,0x0E,0xC0,0x87,0x6C,0x6C,0x71,0x6E,0x62,
+	0x4E,0x0E,0xC8,0x44,0x98,0x09,0xE2,0x50,0x59,0x7D,0x28,0x2D,0x80,0xAC,0x3A,0x27,
+	0xB5,0xA4,0x24,0xB5,0x08,0xEC,0x82,0x48,0xA8,0xFA,0x17,0xC5,0x4C,0x60,0x3A,0x15,
+	0x6A,0x35,0x00,0xC7,0x5D,0x18,0x63,0xBE,0x09,0x00,0x00,0x00,0x00,0x00,0x00,0x59,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00
+};
+
+static const size_t kLettersSize = 39 * 4096 + 1000;
+
+static std::vector<byte> getOzymandiasData() {
+	std::vector<byte> data;
+
+	for (size_t i = 0; i < 16; i++) {
+		const byte number[] = { (byte)('0' + i / 10), (byte)('0' + i % 10), ':', ' ' };
+
+		data.insert(data.end(), number, number + sizeof(number));
+		data.insert(data.end(), kFileData, kFileData + strlen(kFileData));
+		data.push_back('\n');
+	}
+
+	return data;
+}
+
+static byte getLetter(size_t offset) {
+	if (offset >= 39 * 4096)
+		return 'Z';
+
+	return 'A' + ((offset / 4096) % 26);
+}
+
+GTEST_TEST(OBBFile, getResources) {
+	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kOBBFile);
+	const Aurora::OBBFile obb(stream);
+
+	const Aurora::OBBFile::ResourceList &resources = obb.getResources();
+	ASSERT_EQ(resources.size(), 3);
+
+	Aurora::OBBFile::ResourceList::const_iterator it = resources.begin();
+
+	EXPECT_STREQ(it->name.c_str(), "data/ozymandias");
+	EXPECT_EQ(it->type, Aurora::kFileTypeTXT);
+	EXPECT_EQ(it->index, 0);
+
+	++it;
+
+	EXPECT_STREQ(it->name.c_str(), "data/small");
+	EXPECT_EQ(it->type, Aurora::kFileTypeTXT);
+	EXPECT_EQ(it->index, 1);
+
+	++it;
+
+	EXPECT_STREQ(it->name.c_str(), "data/letters");
+	EXPECT_EQ(it->type, Aurora::kFileTypeTXT);
+	EXPECT_EQ(it->index, 2);
+}
+
+GTEST_TEST(OBBFile, getResourceSize) {
+	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kOBBFile);
+	const Aurora::OBBFile obb(stream);
+
+	EXPECT_EQ(obb.getResourceSize(0), getOzymandiasData().size());
+	EXPECT_EQ(obb.getResourceSize(1), strlen(kSmallData));
+	EXPECT_EQ(obb.getResourceSize(2), kLettersSize);
+
+	EXPECT_THROW(obb.getResourceSize(3), Common::Exception);
+}
+
+GTEST_TEST(OBBFile, getResource) {
+	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kOBBFile);
+	const Aurora::OBBFile obb(stream);
+
+	const std::vector<byte> ozymandias = getOzymandiasData();
+
+	// The second time around, the chunks are decompressed using the chunk index
+	for (size_t n = 0; n < 2; n++) {
+		Common::ScopedPtr<Common::SeekableReadStream> file(obb.getResource(0));
+		ASSERT_EQ(file->size(), ozymandias.size());
+
+		for (size_t i = 0; i < ozymandias.size(); i++)
+			EXPECT_EQ(file->readByte(), ozymandias[i]) << "At pass " << n << ", index " << i;
+	}
+
+	Common::ScopedPtr<Common::SeekableReadStream> file(obb.getResource(1));
+	ASSERT_EQ(file->size(), strlen(kSmallData));
+
+	for (size_t i = 0; i < strlen(kSmallData); i++)
+		EXPECT_EQ(file->readByte(), kSmallData[i]) << "At index " << i;
+
+	EXPECT_THROW(obb.getResource(3), Common::Exception);
+}
+
+GTEST_TEST(OBBFile, getResourceThreads) {
+	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kOBBFile);
+	const Aurora::OBBFile obb(stream, 4);
+
+	// The second time around, the chunks are decompressed in parallel
+	for (size_t n = 0; n < 2; n++) {
+		Common::ScopedPtr<Common::SeekableReadStream> file(obb.getResource(2));
+		ASSERT_EQ(file->size(), kLettersSize);
+
+		for (size_t i = 0; i < kLettersSize; i++)
+			ASSERT_EQ(file->readByte(), getLetter(i)) << "At pass " << n << ", index " << i;
+	}
+}
+
+GTEST_TEST(OBBFile, getResourceNoCopy) {
+	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kOBBFile);
+	const Aurora::OBBFile obb(stream);
+
+	const std::vector<byte> ozymandias = getOzymandiasData();
+
+	Common::ScopedPtr<Common::SeekableReadStream> file(obb.getResource(0, true));
+	ASSERT_EQ(file->size(), ozymandias.size());
+
+	for (size_t i = 0; i < ozymandias.size(); i++)
+		EXPECT_EQ(file->readByte(), ozymandias[i]) << "At index " << i;
+
+	EXPECT_FALSE(file->eos());
+
+	byte data;
+	EXPECT_EQ(file->read(&data, 1), 0);
+	EXPECT_TRUE(file->eos());
+}
+
+GTEST_TEST(OBBFile, getResourceNoCopySeek) {
+	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kOBBFile);
+	const Aurora::OBBFile obb(stream);
+
+	const std::vector<byte> ozymandias = getOzymandiasData();
+
+	// Jump straight into the last chunk, then back into the first two, across the chunk border
+	static const size_t kOffsets[] = { 9000, 10, 4000 };
+	static const size_t kReadSize  = 200;
+
+	for (size_t n = 0; n < 2; n++) {
+		Common::ScopedPtr<Common::SeekableReadStream> file(obb.getResource(0, true));
+
+		for (size_t i = 0; i < ARRAYSIZE(kOffsets); i++) {
+			byte data[kReadSize];
+
+			file->seek(kOffsets[i]);
+			ASSERT_EQ(file->read(data, kReadSize), kReadSize);
+
+			for (size_t j = 0; j < kReadSize; j++)
+				EXPECT_EQ(data[j], ozymandias[kOffsets[i] + j]) << "At pass " << n << ", offset " << kOffsets[i] + j;
+		}
+
+		file->seek(-10, Common::SeekableReadStream::kOriginEnd);
+
+		byte data[kReadSize];
+		ASSERT_EQ(file->read(data, kReadSize), 10);
+		EXPECT_TRUE(file->eos());
+
+		for (size_t j = 0; j < 10; j++)
+			EXPECT_EQ(data[j], ozymandias[ozymandias.size() - 10 + j]) << "At pass " << n << ", end index " << j;
+	}
+}
+
+GTEST_TEST(OBBFile, getResourceNoCopyLarge) {
+	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kOBBFile);
+	const Aurora::OBBFile obb(stream, 4);
+
+	Common::ScopedPtr<Common::SeekableReadStream> file(obb.getResource(2, true));
+	ASSERT_EQ(file->size(), kLettersSize);
+
+	// Read the start of every other chunk, backwards
+	for (size_t i = 0; i < 40; i += 2) {
+		const size_t chunk = 39 - i;
+
+		file->seek(chunk * 4096);
+		EXPECT_EQ(file->readByte(), getLetter(chunk * 4096)) << "At chunk " << chunk;
+	}
+
+	// Reading the whole resource again now uses the chunk index found by the stream
+	Common::ScopedPtr<Common::SeekableReadStream> full(obb.getResource(2));
+	ASSERT_EQ(full->size(), kLettersSize);
+
+	for (size_t i = 0; i < kLettersSize; i++)
+		ASSERT_EQ(full->readByte(), getLetter(i)) << "At index " << i;
+}
+
+GTEST_TEST(OBBFile, brokenOBB) {
+	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kOBBFile + 1, sizeof(kOBBFile) - 1);
+
+	EXPECT_THROW(Aurora::OBBFile obb(stream), Common::Exception);
+}
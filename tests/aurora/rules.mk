@@ -41,11 +41,21 @@ tests_aurora_test_locstring_SOURCES  = tests/aurora/locstring.cpp
 tests_aurora_test_locstring_LDADD    = $(aurora_LIBS)
 tests_aurora_test_locstring_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                    += tests/aurora/test_archive
+tests_aurora_test_archive_SOURCES  = tests/aurora/archive.cpp
+tests_aurora_test_archive_LDADD    = $(aurora_LIBS)
+tests_aurora_test_archive_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                    += tests/aurora/test_zipfile
 tests_aurora_test_zipfile_SOURCES  = tests/aurora/zipfile.cpp
 tests_aurora_test_zipfile_LDADD    = $(aurora_LIBS)
 tests_aurora_test_zipfile_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                    += tests/aurora/test_obbfile
+tests_aurora_test_obbfile_SOURCES  = tests/aurora/obbfile.cpp
+tests_aurora_test_obbfile_LDADD    = $(aurora_LIBS)
+tests_aurora_test_obbfile_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                    += tests/aurora/test_ssffile
 tests_aurora_test_ssffile_SOURCES  = tests/aurora/ssffile.cpp
 tests_aurora_test_ssffile_LDADD    = $(aurora_LIBS)
@@ -241,9 +241,54 @@ GTEST_TEST(Small0x10, compress) {
 	Common::MemoryReadStream uncompressed(kDataUncompressed);
 
 	Aurora::Small::compress10(uncompressed, compressed);
-	ASSERT_EQ(compressed.size(), sizeof(kDataCompressed10));
 
-	compareData(compressed.getData(), kDataCompressed10, sizeof(kDataCompressed10));
+	// The exact output depends on the matches found, but it shouldn't be worse than the reference
+	ASSERT_GE(compressed.size(), 4);
+	EXPECT_LE(compressed.size(), sizeof(kDataCompressed10));
+
+	compareData(compressed.getData(), kDataCompressed10, 4);
+}
+
+static size_t compressRoundTrip(const byte *data, size_t size, Aurora::Small::Level level) {
+	Common::MemoryWriteStreamDynamic compressedWrite(true);
+	Common::MemoryReadStream uncompressedRead(data, size);
+
+	Aurora::Small::compress10(uncompressedRead, compressedWrite, level);
+
+
+	Common::MemoryWriteStreamDynamic uncompressedWrite(true);
+	Common::MemoryReadStream compressedRead(compressedWrite.getData(), compressedWrite.size());
+
+	Aurora::Small::decompress(compressedRead, uncompressedWrite);
+
+
+	EXPECT_EQ(uncompressedWrite.size(), size);
+	if (uncompressedWrite.size() == size)
+		compareData(uncompressedWrite.getData(), data, size);
+
+	return compressedWrite.size();
+}
+
+GTEST_TEST(Small0x10, compressLevels) {
+	const byte  *data = reinterpret_cast<const byte *>(kDataUncompressed);
+	const size_t size = strlen(kDataUncompressed);
+
+	const size_t sizeFast   = compressRoundTrip(data, size, Aurora::Small::kLevelFast);
+	const size_t sizeNormal = compressRoundTrip(data, size, Aurora::Small::kLevelNormal);
+	const size_t sizeBest   = compressRoundTrip(data, size, Aurora::Small::kLevelBest);
+
+	EXPECT_LE(sizeNormal, sizeFast);
+	EXPECT_LE(sizeBest  , sizeNormal);
+}
+
+GTEST_TEST(Small0x10, compressRepetitive) {
+	// Long runs and repetitions farther back than the window, overlapping copies
+	byte data[20000];
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = ((i % 5000) < 1000) ? 0x00 : (byte)((i * i) >> 7);
+
+	EXPECT_LT(compressRoundTrip(data, sizeof(data), Aurora::Small::kLevelFast), sizeof(data));
+	EXPECT_LT(compressRoundTrip(data, sizeof(data), Aurora::Small::kLevelBest), sizeof(data));
 }
 
 GTEST_TEST(Small0x10, compressRoundTrip) {
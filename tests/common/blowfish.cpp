@@ -22,12 +22,15 @@
  *  Unit tests for our Blowfish implementation.
  */
 
+#include <cstring>
+
 #include <vector>
 
 #include "gtest/gtest.h"
 
 #include "src/common/util.h"
 #include "src/common/error.h"
+#include "src/common/scopedptr.h"
 #include "src/common/memreadstream.h"
 #include "src/common/blowfish.h"
 
@@ -81,3 +84,133 @@ GTEST_TEST(Blowfish, misalign) {
 
 	EXPECT_THROW(Common::decryptBlowfishEBC(cipherText, key), Common::Exception);
 }
+
+GTEST_TEST(Blowfish, decryptStream) {
+	Common::MemoryReadStream cipherText(kCypherText);
+
+	std::vector<byte> key;
+	createKey(key);
+
+	Common::BlowfishEBCDecryptStream clearText(&cipherText, key);
+	ASSERT_EQ(clearText.size(), ARRAYSIZE(kCypherText));
+
+	for (size_t i = 0; i < ARRAYSIZE(kClearText); i++)
+		EXPECT_EQ(clearText.readByte(), kClearText[i]) << "At index " << i;
+}
+
+GTEST_TEST(Blowfish, decryptStreamReadAt) {
+	Common::MemoryReadStream cipherText(kCypherText);
+
+	std::vector<byte> key;
+	createKey(key);
+
+	Common::BlowfishEBCDecryptStream clearText(&cipherText, key);
+
+	// Read across the block boundary
+	byte readData[6] = { 0 };
+	ASSERT_EQ(clearText.readAt(5, readData, ARRAYSIZE(readData)), ARRAYSIZE(readData));
+
+	for (size_t i = 0; i < ARRAYSIZE(readData); i++)
+		EXPECT_EQ(readData[i], kClearText[5 + i]) << "At index " << i;
+
+	EXPECT_EQ(clearText.pos(), 0);
+}
+
+GTEST_TEST(Blowfish, decryptStreamMisalign) {
+	Common::MemoryReadStream cipherText(kCypherText, 7);
+
+	std::vector<byte> key;
+	createKey(key);
+
+	EXPECT_THROW(Common::BlowfishEBCDecryptStream(&cipherText, key), Common::Exception);
+}
+
+GTEST_TEST(Blowfish, encryptInPlace) {
+	std::vector<byte> data(ARRAYSIZE(kCypherText), 0);
+	std::memcpy(&data[0], kClearText, ARRAYSIZE(kClearText));
+
+	std::vector<byte> key;
+	createKey(key);
+
+	Common::encryptBlowfishEBC(&data[0], data.size(), key);
+
+	for (size_t i = 0; i < ARRAYSIZE(kCypherText); i++)
+		EXPECT_EQ(data[i], kCypherText[i]) << "At index " << i;
+}
+
+GTEST_TEST(Blowfish, decryptInPlace) {
+	std::vector<byte> data(kCypherText, kCypherText + ARRAYSIZE(kCypherText));
+
+	std::vector<byte> key;
+	createKey(key);
+
+	Common::decryptBlowfishEBC(&data[0], data.size(), key);
+
+	for (size_t i = 0; i < ARRAYSIZE(kClearText); i++)
+		EXPECT_EQ(data[i], kClearText[i]) << "At index " << i;
+}
+
+GTEST_TEST(Blowfish, decryptInPlaceMisalign) {
+	std::vector<byte> data(kCypherText, kCypherText + 7);
+
+	std::vector<byte> key;
+	createKey(key);
+
+	EXPECT_THROW(Common::decryptBlowfishEBC(&data[0], data.size(), key), Common::Exception);
+}
+
+/** Create a buffer large enough to be split across threads, made from the example cypher text. */
+static void createLargeData(std::vector<byte> &data) {
+	data.resize(256 * 1024 + ARRAYSIZE(kCypherText));
+
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = kCypherText[i % ARRAYSIZE(kCypherText)] ^ (i / ARRAYSIZE(kCypherText));
+}
+
+GTEST_TEST(Blowfish, inPlaceThreads) {
+	std::vector<byte> clearText;
+	createLargeData(clearText);
+
+	std::vector<byte> key;
+	createKey(key);
+
+	std::vector<byte> serial(clearText), parallel(clearText);
+
+	Common::encryptBlowfishEBC(&serial[0]  , serial.size()  , key, 1);
+	Common::encryptBlowfishEBC(&parallel[0], parallel.size(), key, 4);
+
+	ASSERT_TRUE(serial == parallel);
+
+	// Compare against the stream version, which encrypts one block at a time
+	Common::MemoryReadStream clearTextStream(&clearText[0], clearText.size());
+	Common::ScopedPtr<Common::MemoryReadStream> cipherText(Common::encryptBlowfishEBC(clearTextStream, key));
+
+	ASSERT_EQ(cipherText->size(), serial.size());
+	EXPECT_EQ(std::memcmp(cipherText->getData(), &serial[0], serial.size()), 0);
+
+	Common::decryptBlowfishEBC(&parallel[0], parallel.size(), key, 4);
+
+	EXPECT_TRUE(parallel == clearText);
+}
+
+GTEST_TEST(Blowfish, decryptStreamLarge) {
+	std::vector<byte> cipherData;
+	createLargeData(cipherData);
+
+	std::vector<byte> key;
+	createKey(key);
+
+	std::vector<byte> clearText(cipherData);
+	Common::decryptBlowfishEBC(&clearText[0], clearText.size(), key);
+
+	Common::MemoryReadStream cipherText(&cipherData[0], cipherData.size());
+	Common::BlowfishEBCDecryptStream clearTextStream(&cipherText, key);
+
+	// Read a long range that starts and ends in the middle of a block
+	const size_t offset = 1234, size = 100003;
+
+	std::vector<byte> readData(size);
+	ASSERT_EQ(clearTextStream.readAt(offset, &readData[0], size), size);
+
+	EXPECT_EQ(std::memcmp(&readData[0], &clearText[offset], size), 0);
+}
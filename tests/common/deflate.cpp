@@ -22,8 +22,13 @@
  *  Unit tests for our DEFLATE decompressor (which uses zlib).
  */
 
+#include <cstring>
+
+#include <vector>
+
 #include "gtest/gtest.h"
 
+#include "src/common/util.h"
 #include "src/common/deflate.h"
 #include "src/common/memreadstream.h"
 #include "src/common/error.h"
@@ -266,3 +271,122 @@ GTEST_TEST(DEFLATE, decompressChunked) {
 
 	delete[] output;
 }
+
+GTEST_TEST(DEFLATE, decompressOnDemand) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::MemoryReadStream compressed(kDataCompressed);
+
+	Common::DeflateReadStream decompressed(&compressed, kSizeDecompressed, Common::kWindowBitsMaxRaw);
+	ASSERT_EQ(decompressed.size(), kSizeDecompressed);
+
+	for (size_t i = 0; i < kSizeDecompressed; i++)
+		EXPECT_EQ(decompressed.readByte(), kDataUncompressed[i]) << "At index " << i;
+
+	EXPECT_FALSE(decompressed.eos());
+	EXPECT_THROW(decompressed.readByte(), Common::Exception);
+	EXPECT_TRUE(decompressed.eos());
+}
+
+GTEST_TEST(DEFLATE, decompressOnDemandSeek) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::MemoryReadStream compressed(kDataCompressed);
+
+	Common::DeflateReadStream decompressed(&compressed, kSizeDecompressed, Common::kWindowBitsMaxRaw);
+
+	decompressed.seek(100);
+	EXPECT_EQ(decompressed.pos(), 100);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[100]);
+
+	decompressed.seek(10);
+	EXPECT_EQ(decompressed.pos(), 10);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[10]);
+
+	decompressed.seek(-1, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[kSizeDecompressed - 1]);
+
+	EXPECT_THROW(decompressed.seek(kSizeDecompressed + 1), Common::Exception);
+}
+
+GTEST_TEST(DEFLATE, decompressOnDemandFailInputCut) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::MemoryReadStream compressed(kDataCompressed, sizeof(kDataCompressed) / 2);
+
+	Common::DeflateReadStream decompressed(&compressed, kSizeDecompressed, Common::kWindowBitsMaxRaw);
+
+	byte buffer[1024];
+	EXPECT_THROW(decompressed.read(buffer, kSizeDecompressed), Common::Exception);
+}
+
+/** Create a large amount of compressible data, and compress it. */
+static void createLargeData(std::vector<byte> &data, std::vector<byte> &compressed) {
+	static const size_t kSize = 9 * 1024 * 1024 + 1234;
+
+	const size_t length = strlen(kDataUncompressed);
+
+	data.resize(kSize);
+	for (size_t i = 0; i < kSize; i++)
+		data[i] = kDataUncompressed[(i * 7 + i / 1000) % length];
+
+	Common::compressDeflateChunk(&data[0], data.size(), 0, 0, true, compressed);
+}
+
+GTEST_TEST(DEFLATE, decompressOnDemandSeekBackShort) {
+	std::vector<byte> data, compressedData;
+	createLargeData(data, compressedData);
+
+	Common::MemoryReadStream compressed(&compressedData[0], compressedData.size());
+
+	Common::DeflateReadStream decompressed(&compressed, data.size(), Common::kWindowBitsMaxRaw);
+
+	byte buffer[256];
+	for (size_t pos = 1000; pos < 200000; pos += 5000) {
+		decompressed.seek(pos);
+		ASSERT_EQ(decompressed.read(buffer, sizeof(buffer)), sizeof(buffer));
+
+		const size_t inputPos = compressed.pos();
+
+		// Going back a bit re-uses the data we already decompressed
+		decompressed.seek(-100, Common::SeekableReadStream::kOriginCurrent);
+		ASSERT_EQ(decompressed.read(buffer, sizeof(buffer)), sizeof(buffer));
+
+		EXPECT_EQ(compressed.pos(), inputPos) << "At position " << pos;
+		EXPECT_EQ(memcmp(buffer, &data[pos + sizeof(buffer) - 100], sizeof(buffer)), 0) << "At position " << pos;
+	}
+}
+
+GTEST_TEST(DEFLATE, decompressOnDemandSeekBackLong) {
+	std::vector<byte> data, compressedData;
+	createLargeData(data, compressedData);
+
+	Common::MemoryReadStream compressed(&compressedData[0], compressedData.size());
+
+	Common::DeflateReadStream decompressed(&compressed, data.size(), Common::kWindowBitsMaxRaw);
+
+	static const size_t kPositions[] = { 9 * 1024 * 1024, 5 * 1024 * 1024 + 100, 8 * 1024 * 1024 - 10, 10, 4 * 1024 * 1024 };
+
+	byte buffer[1024];
+	for (size_t i = 0; i < ARRAYSIZE(kPositions); i++) {
+		decompressed.seek(kPositions[i]);
+		ASSERT_EQ(decompressed.read(buffer, sizeof(buffer)), sizeof(buffer));
+
+		EXPECT_EQ(memcmp(buffer, &data[kPositions[i]], sizeof(buffer)), 0) << "At position " << kPositions[i];
+	}
+
+	// Going back far past the start of the data restarts from a checkpoint, not from the start
+	decompressed.seek(8 * 1024 * 1024 + 100);
+	ASSERT_EQ(decompressed.read(buffer, sizeof(buffer)), sizeof(buffer));
+
+	decompressed.seek(5 * 1024 * 1024);
+	EXPECT_GT(compressed.pos(), 0);
+
+	ASSERT_EQ(decompressed.read(buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(memcmp(buffer, &data[5 * 1024 * 1024], sizeof(buffer)), 0);
+
+	decompressed.seek(-10, Common::SeekableReadStream::kOriginEnd);
+	ASSERT_EQ(decompressed.read(buffer, sizeof(buffer)), 10);
+	EXPECT_TRUE(decompressed.eos());
+	EXPECT_EQ(memcmp(buffer, &data[data.size() - 10], 10), 0);
+}
@@ -28,6 +28,8 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include <vector>
+
 #include "tests/skip.h"
 
 #include "src/common/encoding.h"
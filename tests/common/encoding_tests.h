@@ -36,6 +36,34 @@ GTEST_TEST(XOREOS_ENCODINGNAME, readString) {
 	EXPECT_STREQ(string.c_str(), stringUString.c_str());
 }
 
+GTEST_TEST(XOREOS_ENCODINGNAME, readStringLong) {
+	testSupport(kEncoding);
+
+	// A string repeated often enough to span several read chunks, terminated and with garbage following
+	static const size_t kRepeat = 100;
+
+	std::vector<byte> data;
+	for (size_t i = 0; i < kRepeat; i++)
+		data.insert(data.end(), stringData0, stringData0 + stringBytes);
+
+	data.insert(data.end(), stringData0 + stringBytes, stringData0 + sizeof(stringData0));
+	const size_t stringEnd = data.size();
+
+	data.insert(data.end(), stringData0X + sizeof(stringData0), stringData0X + sizeof(stringData0X));
+
+	Common::MemoryReadStream stream(&data[0], data.size());
+
+	const Common::UString string = Common::readString(stream, kEncoding);
+
+	Common::UString expected;
+	for (size_t i = 0; i < kRepeat; i++)
+		expected += stringUString;
+
+	EXPECT_EQ(string.size(), kRepeat * stringChars);
+	EXPECT_STREQ(string.c_str(), expected.c_str());
+	EXPECT_EQ(stream.pos(), stringEnd);
+}
+
 GTEST_TEST(XOREOS_ENCODINGNAME, readStringFixed) {
 	testSupport(kEncoding);
 
@@ -0,0 +1,111 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Stress tests for converting strings from several threads at once.
+ */
+
+#include <cstring>
+
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/ustring.h"
+#include "src/common/encoding.h"
+#include "src/common/memreadstream.h"
+#include "src/common/scopedptr.h"
+#include "src/common/threadpool.h"
+
+#include "tests/common/encoding.h"
+
+struct StringCase {
+	Common::Encoding encoding;
+
+	const byte *data;
+	size_t size;
+
+	const char *utf8;
+};
+
+// The same example strings as in the individual encoding tests
+
+static const byte stringCP932[] = { 0x8B, 0x5F, 0x89, 0x80, 0x90, 0xB8, 0x8E, 0xC9, 0x82, 0xCC, 0x8F, 0xE0, 0x82, 0xCC, 0xE3, 0xDF, 0x81, 0x41 };
+static const byte stringCP936[] = { 0xD0, 0xB4, 0xCD, 0xAC, 0xCE, 0xF7, 0xCE, 0xAC, 0xB9, 0xB9, 0xB6, 0xCE, 0xCF, 0xB8, 0xBF, 0xB4, 0xA3, 0xAC };
+static const byte stringCP1251[] = { 0xD4, 0xEE, 0xEE, 0xE1, 0xE0, 0xF0 };
+static const byte stringUTF16LE[] = { 'F', 0x00, 0xF6, 0x00, 0xF6, 0x00, 'b', 0x00, 0xE4, 0x00, 'r', 0x00 };
+
+static const StringCase kStringCases[] = {
+	{ Common::kEncodingCP932  , stringCP932  , sizeof(stringCP932)  ,
+	  "\xe7\xa5\x87\xe5\x9c\x92\xe7\xb2\xbe\xe8\x88\x8e\xe3\x81\xae\xe9\x90\x98\xe3\x81\xae\xe8\x81\xb2\xe3\x80\x81" },
+	{ Common::kEncodingCP936  , stringCP936  , sizeof(stringCP936)  ,
+	  "\xe5\x86\x99\xe5\x90\x8c\xe8\xa5\xbf\xe7\xbb\xb4\xe6\x9e\x84\xe6\xae\xb5\xe7\xbb\x86\xe7\x9c\x8b\xef\xbc\x8c" },
+	{ Common::kEncodingCP1251 , stringCP1251 , sizeof(stringCP1251) ,
+	  "\xd0\xa4\xd0\xbe\xd0\xbe\xd0\xb1\xd0\xb0\xd1\x80" },
+	{ Common::kEncodingUTF16LE, stringUTF16LE, sizeof(stringUTF16LE),
+	  "F\xc3\xb6\xc3\xb6" "b\xc3\xa4r" }
+};
+
+static const size_t kIterations = 500;
+
+/** Convert all example strings back and forth a few times, counting the failures. */
+static void convertStrings(std::vector<size_t> &failures, size_t index) {
+	for (size_t i = 0; i < kIterations; i++) {
+		for (size_t j = 0; j < ARRAYSIZE(kStringCases); j++) {
+			const StringCase &stringCase = kStringCases[j];
+
+			const Common::UString string = Common::readString(stringCase.data, stringCase.size, stringCase.encoding);
+			if (string != stringCase.utf8)
+				failures[index]++;
+
+			Common::ScopedPtr<Common::MemoryReadStream> data(Common::convertString(string, stringCase.encoding, false));
+			if (!data || (data->size() != stringCase.size) ||
+			    std::memcmp(data->getData(), stringCase.data, stringCase.size))
+				failures[index]++;
+		}
+	}
+}
+
+static void testThreads(size_t threadCount) {
+	for (size_t i = 0; i < ARRAYSIZE(kStringCases); i++)
+		testSupport(kStringCases[i].encoding);
+
+	std::vector<size_t> failures(64, 0);
+
+	Common::ThreadPool pool(threadCount);
+	for (size_t i = 0; i < failures.size(); i++)
+		pool.addJob(boost::bind(&convertStrings, boost::ref(failures), i));
+
+	pool.wait();
+
+	for (size_t i = 0; i < failures.size(); i++)
+		EXPECT_EQ(failures[i], 0U) << "In job " << i;
+}
+
+GTEST_TEST(EncodingThreads, singleThread) {
+	testThreads(1);
+}
+
+GTEST_TEST(EncodingThreads, multipleThreads) {
+	testThreads(8);
+}
@@ -132,3 +132,51 @@ GTEST_TEST(LZMA1, decompressFailInputCut) {
 	EXPECT_THROW(Common::decompressLZMA1(kDataCompressed, kSizeCompressed, kSizeDecompressed),
 	             Common::Exception);
 }
+
+GTEST_TEST(LZMA1, decompressOnDemand) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::MemoryReadStream compressed(kDataCompressed);
+
+	Common::LZMA1ReadStream decompressed(&compressed, kSizeDecompressed);
+	ASSERT_EQ(decompressed.size(), kSizeDecompressed);
+
+	for (size_t i = 0; i < kSizeDecompressed; i++)
+		EXPECT_EQ(decompressed.readByte(), kDataUncompressed[i]) << "At index " << i;
+
+	EXPECT_FALSE(decompressed.eos());
+	EXPECT_THROW(decompressed.readByte(), Common::Exception);
+	EXPECT_TRUE(decompressed.eos());
+}
+
+GTEST_TEST(LZMA1, decompressOnDemandSeek) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::MemoryReadStream compressed(kDataCompressed);
+
+	Common::LZMA1ReadStream decompressed(&compressed, kSizeDecompressed);
+
+	decompressed.seek(100);
+	EXPECT_EQ(decompressed.pos(), 100);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[100]);
+
+	decompressed.seek(10);
+	EXPECT_EQ(decompressed.pos(), 10);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[10]);
+
+	decompressed.seek(-1, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[kSizeDecompressed - 1]);
+
+	EXPECT_THROW(decompressed.seek(kSizeDecompressed + 1), Common::Exception);
+}
+
+GTEST_TEST(LZMA1, decompressOnDemandFailInputCut) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::MemoryReadStream compressed(kDataCompressed, sizeof(kDataCompressed) / 2);
+
+	Common::LZMA1ReadStream decompressed(&compressed, kSizeDecompressed);
+
+	byte buffer[1024];
+	EXPECT_THROW(decompressed.read(buffer, kSizeDecompressed), Common::Exception);
+}
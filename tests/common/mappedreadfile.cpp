@@ -0,0 +1,136 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our memory-mapped file read stream.
+ */
+
+#include <string>
+#include <iostream>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/scopedptr.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+#include "src/common/memreadstream.h"
+#include "src/common/mappedreadfile.h"
+
+boost::filesystem::path kFilePath;
+
+static const byte kData[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+
+class MappedReadFile : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		boost::filesystem::path tmpPath    = boost::filesystem::temp_directory_path();
+		boost::filesystem::path uniquePath = boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		kFilePath = tmpPath / uniquePath;
+
+		boost::filesystem::ofstream testFile(kFilePath, std::ofstream::binary);
+
+		testFile.write(reinterpret_cast<const char *>(kData), ARRAYSIZE(kData));
+		testFile.close();
+	}
+
+	static void TearDownTestCase() {
+		if (!kFilePath.empty())
+			boost::filesystem::remove(kFilePath);
+	}
+};
+
+GTEST_TEST_F(MappedReadFile, read) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MappedReadFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	EXPECT_EQ(file.size(), ARRAYSIZE(kData));
+
+	byte readData[ARRAYSIZE(kData) + 1];
+	const size_t readCount = file.read(readData, sizeof(readData));
+	EXPECT_EQ(readCount, ARRAYSIZE(kData));
+	EXPECT_TRUE(file.eos());
+
+	for (size_t i = 0; i < ARRAYSIZE(kData); i++)
+		EXPECT_EQ(readData[i], kData[i]) << "At index " << i;
+
+	file.seek(-2, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_FALSE(file.eos());
+	EXPECT_EQ(file.readByte(), kData[3]);
+
+	file.close();
+	ASSERT_FALSE(file.isOpen());
+}
+
+GTEST_TEST_F(MappedReadFile, readAt) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MappedReadFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	file.seek(1);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(file.readAt(2, readData, 4), 3);
+
+	EXPECT_EQ(readData[0], kData[2]);
+	EXPECT_EQ(readData[1], kData[3]);
+	EXPECT_EQ(readData[2], kData[4]);
+
+	EXPECT_EQ(file.readAt(5, readData, 1), 0);
+
+	EXPECT_EQ(file.pos(), 1);
+}
+
+GTEST_TEST_F(MappedReadFile, subStreamAt) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MappedReadFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	Common::ScopedPtr<Common::SeekableReadStream> subStream(file.subStreamAt(1, 3));
+
+	// The substream needs to point directly into the mapping
+	Common::MemoryReadStream *memStream = dynamic_cast<Common::MemoryReadStream *>(subStream.get());
+	ASSERT_NE(memStream, static_cast<Common::MemoryReadStream *>(0));
+	EXPECT_EQ(memStream->getData(), file.getData() + 1);
+
+	EXPECT_EQ(subStream->size(), 3);
+	EXPECT_EQ(subStream->readByte(), kData[1]);
+	EXPECT_EQ(subStream->readByte(), kData[2]);
+	EXPECT_EQ(subStream->readByte(), kData[3]);
+
+	EXPECT_THROW(file.subStreamAt(3, 3), Common::Exception);
+}
+
+GTEST_TEST_F(MappedReadFile, openFail) {
+	Common::MappedReadFile file;
+
+	EXPECT_FALSE(file.open((kFilePath / "nonexistent").generic_string()));
+	EXPECT_FALSE(file.isOpen());
+}
@@ -105,6 +105,59 @@ GTEST_TEST(MemoryReadStream, readStream) {
 	EXPECT_THROW(stream.readStream(ARRAYSIZE(data) + 1), Common::Exception);
 }
 
+GTEST_TEST(MemoryReadStream, readAt) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	stream.seek(1);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(stream.readAt(2, readData, 4), 3);
+
+	EXPECT_EQ(readData[0], data[2]);
+	EXPECT_EQ(readData[1], data[3]);
+	EXPECT_EQ(readData[2], data[4]);
+
+	EXPECT_EQ(stream.readAt(5, readData, 1), 0);
+
+	EXPECT_EQ(stream.pos(), 1);
+	EXPECT_FALSE(stream.eos());
+}
+
+GTEST_TEST(MemoryReadStream, readStreamAt) {
+	static const byte data[3] = { 0x12, 0x34, 0x56 };
+	Common::MemoryReadStream stream(data);
+
+	Common::MemoryReadStream *streamRead = stream.readStreamAt(1, 2);
+
+	EXPECT_EQ(streamRead->size(), 2);
+	EXPECT_EQ(streamRead->readByte(), data[1]);
+	EXPECT_EQ(streamRead->readByte(), data[2]);
+
+	delete streamRead;
+
+	EXPECT_EQ(stream.pos(), 0);
+
+	EXPECT_THROW(stream.readStreamAt(1, 3), Common::Exception);
+}
+
+GTEST_TEST(MemoryReadStream, subStreamAt) {
+	static const byte data[3] = { 0x12, 0x34, 0x56 };
+	Common::MemoryReadStream stream(data);
+
+	Common::SeekableReadStream *subStream = stream.subStreamAt(1, 2);
+
+	EXPECT_EQ(subStream->size(), 2);
+	EXPECT_EQ(subStream->readByte(), data[1]);
+	EXPECT_EQ(subStream->readByte(), data[2]);
+
+	delete subStream;
+
+	EXPECT_EQ(stream.pos(), 0);
+
+	EXPECT_THROW(stream.subStreamAt(1, 3), Common::Exception);
+}
+
 GTEST_TEST(MemoryReadStream, readChar) {
 	static const byte data[3] = { 0x12, 0x34, 0x56 };
 	Common::MemoryReadStream stream(data);
@@ -259,6 +312,58 @@ GTEST_TEST(MemoryReadStream, readIEEEDoubleBE) {
 	EXPECT_THROW(stream.readIEEEDoubleBE(), Common::Exception);
 }
 
+GTEST_TEST(MemoryReadStream, readArrayLE) {
+	static const byte data[7] = { 0x34, 0x12, 0x78, 0x56, 0xBC, 0x9A, 0xFF };
+	Common::MemoryReadStream stream(data);
+
+	uint16 array[3] = { 0 };
+	stream.readArrayLE(array, 3);
+
+	EXPECT_EQ(array[0], 0x1234);
+	EXPECT_EQ(array[1], 0x5678);
+	EXPECT_EQ(array[2], 0x9ABC);
+
+	EXPECT_EQ(stream.pos(), 6);
+
+	EXPECT_THROW(stream.readArrayLE(array, 1), Common::Exception);
+}
+
+GTEST_TEST(MemoryReadStream, readArrayBE) {
+	static const byte data[8] = { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0 };
+	Common::MemoryReadStream stream(data);
+
+	uint32 array[2] = { 0 };
+	stream.readArrayBE(array, 2);
+
+	EXPECT_EQ(array[0], 0x12345678);
+	EXPECT_EQ(array[1], 0x9ABCDEF0);
+
+	EXPECT_THROW(stream.readArrayBE(array, 1), Common::Exception);
+}
+
+GTEST_TEST(MemoryReadStream, readMixed) {
+	static const byte data[8] = { 0x12, 0x34, 0x12, 0x78, 0x56, 0x34, 0x12, 0x99 };
+	Common::MemoryReadStream stream(data);
+
+	EXPECT_EQ(stream.readByte(), 0x12);
+	EXPECT_EQ(stream.readUint16BE(), 0x3412);
+	EXPECT_EQ(stream.pos(), 3);
+
+	stream.seek(-1, Common::MemoryReadStream::kOriginCurrent);
+	EXPECT_EQ(stream.readUint16LE(), 0x7812);
+
+	EXPECT_EQ(stream.readUint32LE(), 0x99123456);
+	EXPECT_EQ(stream.pos(), 8);
+	EXPECT_FALSE(stream.eos());
+
+	EXPECT_THROW(stream.readByte(), Common::Exception);
+	EXPECT_TRUE(stream.eos());
+
+	stream.seek(7);
+	EXPECT_FALSE(stream.eos());
+	EXPECT_EQ(stream.readByte(), 0x99);
+}
+
 GTEST_TEST(MemoryReadStreamEndian, streamEndianLE) {
 	static const byte data[4] = { 0x78, 0x56, 0x34, 0x12 };
 	Common::MemoryReadStreamEndian stream(data, sizeof(data), false);
@@ -315,6 +420,48 @@ GTEST_TEST(SeekableSubReadStream, fromMem) {
 	EXPECT_FALSE(subStream.eos());
 }
 
+GTEST_TEST(SeekableSubReadStream, readAt) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	Common::SeekableSubReadStream subStream(&stream, 1, 4);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(subStream.readAt(1, readData, 4), 2);
+
+	EXPECT_EQ(readData[0], data[2]);
+	EXPECT_EQ(readData[1], data[3]);
+
+	EXPECT_EQ(subStream.pos(), 0);
+}
+
+GTEST_TEST(ReadAtSubReadStream, fromMem) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	stream.seek(4);
+
+	Common::ReadAtSubReadStream subStream(&stream, 1, 4);
+
+	byte readData[4] = { 0 };
+	const size_t readCount = subStream.read(readData, 4);
+
+	EXPECT_EQ(readCount, 3);
+	EXPECT_TRUE(subStream.eos());
+
+	EXPECT_EQ(readData[0], data[1]);
+	EXPECT_EQ(readData[1], data[2]);
+	EXPECT_EQ(readData[2], data[3]);
+
+	EXPECT_EQ(stream.pos(), 4);
+
+	subStream.seek(1);
+
+	EXPECT_EQ(subStream.pos(), 1);
+	EXPECT_FALSE(subStream.eos());
+	EXPECT_EQ(subStream.readByte(), data[2]);
+}
+
 GTEST_TEST(SeekableSubReadStreamEndian, streamEndianLE) {
 	static const byte data[4] = { 0x78, 0x56, 0x34, 0x12 };
 	Common::MemoryReadStream stream(data);
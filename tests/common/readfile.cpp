@@ -87,3 +87,94 @@ GTEST_TEST_F(ReadFile, write) {
 	for (size_t i = 0; i < ARRAYSIZE(data); i++)
 		EXPECT_EQ(readData[i], data[i]) << "At index " << i;
 }
+
+GTEST_TEST_F(ReadFile, readAt) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+
+	// Create the input file
+
+	boost::filesystem::ofstream testFile(kFilePath, std::ofstream::binary);
+
+	testFile.write(reinterpret_cast<const char *>(data), ARRAYSIZE(data));
+	testFile.flush();
+	ASSERT_FALSE(testFile.fail());
+
+	testFile.close();
+
+	// Read at positions, without disturbing the stream position
+
+	Common::ReadFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	file.seek(1);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(file.readAt(2, readData, 4), 3);
+
+	EXPECT_EQ(readData[0], data[2]);
+	EXPECT_EQ(readData[1], data[3]);
+	EXPECT_EQ(readData[2], data[4]);
+
+	EXPECT_EQ(file.readAt(5, readData, 1), 0);
+
+	EXPECT_EQ(file.pos(), 1);
+	EXPECT_EQ(file.readByte(), data[1]);
+}
+
+GTEST_TEST_F(ReadFile, readBuffered) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	// Bigger than the read-ahead buffer
+	static const size_t kDataSize = 10000;
+
+	byte data[kDataSize];
+	for (size_t i = 0; i < kDataSize; i++)
+		data[i] = (byte)(i * 7);
+
+	// Create the input file
+
+	boost::filesystem::ofstream testFile(kFilePath, std::ofstream::binary);
+
+	testFile.write(reinterpret_cast<const char *>(data), kDataSize);
+	testFile.flush();
+	ASSERT_FALSE(testFile.fail());
+
+	testFile.close();
+
+	// Mix small reads, big reads and seeks
+
+	Common::ReadFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	EXPECT_EQ(file.readByte(), data[0]);
+	EXPECT_EQ(file.readUint16LE(), READ_LE_UINT16(data + 1));
+	EXPECT_EQ(file.pos(), 3);
+
+	file.skip(4);
+	EXPECT_EQ(file.pos(), 7);
+	EXPECT_EQ(file.readUint32BE(), READ_BE_UINT32(data + 7));
+
+	byte readData[kDataSize];
+	EXPECT_EQ(file.read(readData, 5000), 5000);
+	EXPECT_EQ(file.pos(), 5011);
+
+	for (size_t i = 0; i < 5000; i++)
+		EXPECT_EQ(readData[i], data[11 + i]) << "At index " << i;
+
+	file.seek(-8, Common::ReadFile::kOriginEnd);
+	EXPECT_EQ(file.readUint64LE(), READ_LE_UINT64(data + kDataSize - 8));
+	EXPECT_FALSE(file.eos());
+
+	EXPECT_THROW(file.readByte(), Common::Exception);
+	EXPECT_TRUE(file.eos());
+
+	file.seek(4096);
+	EXPECT_FALSE(file.eos());
+	EXPECT_EQ(file.readByte(), data[4096]);
+
+	file.seek(-2, Common::ReadFile::kOriginCurrent);
+	EXPECT_EQ(file.pos(), 4095);
+	EXPECT_EQ(file.readUint16LE(), READ_LE_UINT16(data + 4095));
+}
@@ -85,6 +85,11 @@ tests_common_test_readfile_SOURCES  = tests/common/readfile.cpp
 tests_common_test_readfile_LDADD    = $(common_LIBS)
 tests_common_test_readfile_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                           += tests/common/test_mappedreadfile
+tests_common_test_mappedreadfile_SOURCES  = tests/common/mappedreadfile.cpp
+tests_common_test_mappedreadfile_LDADD    = $(common_LIBS)
+tests_common_test_mappedreadfile_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                      += tests/common/test_writefile
 tests_common_test_writefile_SOURCES  = tests/common/writefile.cpp
 tests_common_test_writefile_LDADD    = $(common_LIBS)
@@ -157,6 +162,11 @@ tests_common_test_encoding_cp950_SOURCES  = tests/common/encoding_cp950.cpp
 tests_common_test_encoding_cp950_LDADD    = $(common_LIBS)
 tests_common_test_encoding_cp950_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                             += tests/common/test_encoding_threads
+tests_common_test_encoding_threads_SOURCES  = tests/common/encoding_threads.cpp
+tests_common_test_encoding_threads_LDADD    = $(common_LIBS)
+tests_common_test_encoding_threads_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                     += tests/common/test_filepath
 tests_common_test_filepath_SOURCES  = tests/common/filepath.cpp
 tests_common_test_filepath_LDADD    = $(common_LIBS)
@@ -196,3 +206,8 @@ check_PROGRAMS                  += tests/common/test_maths
 tests_common_test_maths_SOURCES  = tests/common/maths.cpp
 tests_common_test_maths_LDADD    = $(common_LIBS)
 tests_common_test_maths_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                       += tests/common/test_threadpool
+tests_common_test_threadpool_SOURCES  = tests/common/threadpool.cpp
+tests_common_test_threadpool_LDADD    = $(common_LIBS)
+tests_common_test_threadpool_CXXFLAGS = $(test_CXXFLAGS)
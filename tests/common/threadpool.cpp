@@ -0,0 +1,92 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our thread pool.
+ */
+
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/threadpool.h"
+#include "src/common/error.h"
+
+static void setValue(std::vector<size_t> &values, size_t index) {
+	values[index] = index * 2;
+}
+
+static void throwException() {
+	throw Common::Exception("Foobar");
+}
+
+static void testJobs(size_t threadCount) {
+	std::vector<size_t> values(1000, 0);
+
+	Common::ThreadPool pool(threadCount);
+	for (size_t i = 0; i < values.size(); i++)
+		pool.addJob(boost::bind(&setValue, boost::ref(values), i));
+
+	pool.wait();
+
+	for (size_t i = 0; i < values.size(); i++)
+		EXPECT_EQ(values[i], i * 2) << "At index " << i;
+}
+
+GTEST_TEST(ThreadPool, threadCount) {
+	EXPECT_GE(Common::ThreadPool::getHardwareThreadCount(), 1U);
+
+	EXPECT_EQ(Common::ThreadPool::getThreadCount(0), Common::ThreadPool::getHardwareThreadCount());
+	EXPECT_EQ(Common::ThreadPool::getThreadCount(3), 3U);
+
+	Common::ThreadPool pool(4);
+	EXPECT_EQ(pool.getThreadCount(), 4U);
+}
+
+GTEST_TEST(ThreadPool, singleThread) {
+	testJobs(1);
+}
+
+GTEST_TEST(ThreadPool, multipleThreads) {
+	testJobs(4);
+}
+
+GTEST_TEST(ThreadPool, waitWithoutJobs) {
+	Common::ThreadPool pool(4);
+
+	pool.wait();
+}
+
+GTEST_TEST(ThreadPool, exception) {
+	Common::ThreadPool pool1(1);
+	pool1.addJob(&throwException);
+
+	EXPECT_THROW(pool1.wait(), Common::Exception);
+	EXPECT_NO_THROW(pool1.wait());
+
+	Common::ThreadPool pool4(4);
+	pool4.addJob(&throwException);
+
+	EXPECT_THROW(pool4.wait(), Common::Exception);
+	EXPECT_NO_THROW(pool4.wait());
+}
@@ -0,0 +1,93 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our DDS image decoder.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+
+#include "src/images/dds.h"
+
+/** Create a standard DXT1 DDS with two mip maps, filled with pseudo-random data. */
+static void createDXT1(Common::MemoryWriteStreamDynamic &dds, uint32 width, uint32 height) {
+	dds.writeUint32BE(MKTAG('D', 'D', 'S', ' '));
+
+	dds.writeUint32LE(124);                // Header size
+	dds.writeUint32LE(0x000A1007);         // Flags
+	dds.writeUint32LE(height);
+	dds.writeUint32LE(width);
+	dds.writeUint32LE((width / 4) * 8);    // Pitch
+	dds.writeUint32LE(0);                  // Depth
+	dds.writeUint32LE(2);                  // Mip map count
+	dds.writeZeros(44);
+
+	dds.writeUint32LE(32);                 // Pixel format size
+	dds.writeUint32LE(0x00000004);         // Pixel format flags: FourCC
+	dds.writeUint32BE(MKTAG('D', 'X', 'T', '1'));
+	dds.writeZeros(20);
+
+	dds.writeUint32LE(0x00401008);         // Capabilities
+	dds.writeZeros(16);
+
+	uint32 seed = 0x12345678;
+
+	const size_t size = (width / 4) * (height / 4) * 8 + (width / 8) * (height / 8) * 8;
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		dds.writeByte(seed >> 24);
+	}
+}
+
+GTEST_TEST(DDS, decompressThreaded) {
+	// High enough to be split into several strips
+	Common::MemoryWriteStreamDynamic data(true);
+	createDXT1(data, 16, 1032);
+
+	Common::MemoryReadStream stream1(data.getData(), data.size());
+	Common::MemoryReadStream stream3(data.getData(), data.size());
+
+	Images::DDS dds1(stream1, 1);
+	Images::DDS dds3(stream3, 3);
+
+	ASSERT_EQ(dds1.getFormat(), Images::kPixelFormatR8G8B8A8);
+	ASSERT_EQ(dds3.getFormat(), Images::kPixelFormatR8G8B8A8);
+
+	ASSERT_EQ(dds1.getMipMapCount(), 2);
+	ASSERT_EQ(dds3.getMipMapCount(), 2);
+
+	for (size_t i = 0; i < dds1.getMipMapCount(); i++) {
+		const Images::Decoder::MipMap &mipMap1 = dds1.getMipMap(i);
+		const Images::Decoder::MipMap &mipMap3 = dds3.getMipMap(i);
+
+		ASSERT_EQ(mipMap1.width , mipMap3.width);
+		ASSERT_EQ(mipMap1.height, mipMap3.height);
+		ASSERT_EQ(mipMap1.size  , mipMap3.size);
+
+		for (size_t j = 0; j < mipMap1.size; j++)
+			ASSERT_EQ(mipMap1.data[j], mipMap3.data[j]) << "At mip map " << i << ", index " << j;
+	}
+}
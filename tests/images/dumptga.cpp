@@ -0,0 +1,180 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our TGA image dumper.
+ */
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/scopedptr.h"
+#include "src/common/platform.h"
+#include "src/common/readfile.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+
+#include "src/images/tga.h"
+#include "src/images/dumptga.h"
+
+static const uint32 kWidth  = 300;
+static const uint32 kHeight = 7;
+
+boost::filesystem::path kFilePath;
+
+class DumpTGA : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		boost::filesystem::path tmpPath    = boost::filesystem::temp_directory_path();
+		boost::filesystem::path uniquePath = boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		kFilePath = tmpPath / uniquePath;
+	}
+
+	static void TearDownTestCase() {
+		if (!kFilePath.empty())
+			boost::filesystem::remove(kFilePath);
+	}
+};
+
+/** Create an uncompressed TGA, with a mix of long runs and pseudo-random pixels. */
+static void createTGA(Common::MemoryWriteStreamDynamic &tga, byte pixelDepth) {
+	tga.writeByte(0);               // ID Length
+	tga.writeByte(0);               // Palette size
+	tga.writeByte(2);               // Unmapped RGB
+	tga.writeZeros(9);              // Color map, X, Y
+	tga.writeUint16LE(kWidth);
+	tga.writeUint16LE(kHeight);
+	tga.writeByte(pixelDepth);
+	tga.writeByte(0);
+
+	uint32 seed = 0x12345678;
+
+	for (uint32 y = 0; y < kHeight; y++) {
+		for (uint32 x = 0; x < kWidth; x++) {
+			seed = seed * 1103515245 + 12345;
+
+			// Row 0 is one long run, the others alternate between runs and noise
+			const bool run = (y == 0) || (((x / (y * 8)) & 1) == 0);
+
+			const uint32 color = run ? (0x10203040 * (y + 1)) : seed;
+
+			for (byte i = 0; i < pixelDepth / 8; i++)
+				tga.writeByte(color >> (i * 8));
+		}
+	}
+}
+
+/** Dump the image, then read the dumped TGA back in. */
+static Images::TGA *dumpAndRead(const Images::Decoder &image, bool rle, size_t &fileSize) {
+	Images::dumpTGA(kFilePath.generic_string(), image, rle);
+
+	Common::ReadFile file(kFilePath.generic_string());
+	fileSize = file.size();
+
+	return new Images::TGA(file);
+}
+
+static void compareImages(const Images::Decoder &image, const Images::Decoder &dumped) {
+	ASSERT_EQ(dumped.getFormat(), Images::kPixelFormatB8G8R8A8);
+	ASSERT_EQ(dumped.getMipMap(0).width , image.getMipMap(0).width);
+	ASSERT_EQ(dumped.getMipMap(0).height, image.getMipMap(0).height);
+
+	const bool hasAlpha = image.getFormat() == Images::kPixelFormatB8G8R8A8;
+	const uint32 bpp    = hasAlpha ? 4 : 3;
+
+	const byte *data       = image.getMipMap(0).data.get();
+	const byte *dumpedData = dumped.getMipMap(0).data.get();
+
+	for (uint32 i = 0; i < kWidth * kHeight; i++, data += bpp, dumpedData += 4) {
+		EXPECT_EQ(dumpedData[0], data[0]) << "At pixel " << i;
+		EXPECT_EQ(dumpedData[1], data[1]) << "At pixel " << i;
+		EXPECT_EQ(dumpedData[2], data[2]) << "At pixel " << i;
+		EXPECT_EQ(dumpedData[3], hasAlpha ? data[3] : 0xFF) << "At pixel " << i;
+	}
+}
+
+GTEST_TEST_F(DumpTGA, raw) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MemoryWriteStreamDynamic data(true);
+	createTGA(data, 32);
+
+	Common::MemoryReadStream stream(data.getData(), data.size());
+	Images::TGA image(stream);
+
+	size_t fileSize = 0;
+	Common::ScopedPtr<Images::TGA> dumped(dumpAndRead(image, false, fileSize));
+
+	EXPECT_EQ(fileSize, data.size());
+	compareImages(image, *dumped);
+}
+
+GTEST_TEST_F(DumpTGA, rawNoAlpha) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MemoryWriteStreamDynamic data(true);
+	createTGA(data, 24);
+
+	Common::MemoryReadStream stream(data.getData(), data.size());
+	Images::TGA image(stream);
+
+	size_t fileSize = 0;
+	Common::ScopedPtr<Images::TGA> dumped(dumpAndRead(image, false, fileSize));
+
+	EXPECT_EQ(fileSize, 18 + kWidth * kHeight * 4);
+	compareImages(image, *dumped);
+}
+
+GTEST_TEST_F(DumpTGA, rle) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MemoryWriteStreamDynamic data(true);
+	createTGA(data, 32);
+
+	Common::MemoryReadStream stream(data.getData(), data.size());
+	Images::TGA image(stream);
+
+	size_t fileSize = 0;
+	Common::ScopedPtr<Images::TGA> dumped(dumpAndRead(image, true, fileSize));
+
+	EXPECT_LT(fileSize, data.size());
+	compareImages(image, *dumped);
+}
+
+GTEST_TEST_F(DumpTGA, rleNoAlpha) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MemoryWriteStreamDynamic data(true);
+	createTGA(data, 24);
+
+	Common::MemoryReadStream stream(data.getData(), data.size());
+	Images::TGA image(stream);
+
+	size_t fileSize = 0;
+	Common::ScopedPtr<Images::TGA> dumped(dumpAndRead(image, true, fileSize));
+
+	EXPECT_LT(fileSize, 18 + kWidth * kHeight * 4);
+	compareImages(image, *dumped);
+}
@@ -36,3 +36,18 @@ check_PROGRAMS                       += tests/images/test_xoreositex
 tests_images_test_xoreositex_SOURCES  = tests/images/xoreositex.cpp
 tests_images_test_xoreositex_LDADD    = $(images_LIBS)
 tests_images_test_xoreositex_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                 += tests/images/test_s3tc
+tests_images_test_s3tc_SOURCES  = tests/images/s3tc.cpp
+tests_images_test_s3tc_LDADD    = $(images_LIBS)
+tests_images_test_s3tc_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                += tests/images/test_dds
+tests_images_test_dds_SOURCES  = tests/images/dds.cpp
+tests_images_test_dds_LDADD    = $(images_LIBS)
+tests_images_test_dds_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                    += tests/images/test_dumptga
+tests_images_test_dumptga_SOURCES  = tests/images/dumptga.cpp
+tests_images_test_dumptga_LDADD    = $(images_LIBS)
+tests_images_test_dumptga_CXXFLAGS = $(test_CXXFLAGS)
@@ -0,0 +1,137 @@
+/* xoreos-tools - Tools to help with xoreos development
+ *
+ * xoreos-tools is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos-tools is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos-tools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos-tools. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our S3TC DXTn decompression.
+ */
+
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+
+#include "src/images/s3tc.h"
+
+// Two DXT1 blocks: one with four colors, one with three colors and transparency
+static const byte kDXT1Compressed[] = {
+	0x1F,0xF8, 0xE0,0x07, 0x1B,0x6C,0xB1,0xE4,
+	0x00,0x18, 0x1F,0xF8, 0xE4,0x1B,0xA5,0x3C
+};
+
+// One DXT3 block
+static const byte kDXT3Compressed[] = {
+	0x10,0x32, 0x54,0x76, 0x98,0xBA, 0xDC,0xFE,
+	0x3F,0x4A, 0xC8,0x91, 0x27,0x8D,0x1E,0x63
+};
+
+// Two DXT5 blocks: one with eight alpha values, one with six and 0/255
+static const byte kDXT5Compressed[] = {
+	0xF0,0x10, 0x88,0xC6,0xFA,0x05,0x39,0x77, 0x3F,0x4A, 0xC8,0x91, 0x27,0x8D,0x1E,0x63,
+	0x20,0xC0, 0x11,0x92,0x24,0x49,0xB6,0x6D, 0xC8,0x91, 0x3F,0x4A, 0x72,0xD8,0xE1,0x36
+};
+
+static const byte kDXT1Decompressed8x4[] = {
+	0x52,0xA7,0x52,0xFF,0xA5,0x53,0xA5,0xFF,0x00,0xFC,0x00,0xFF,0xF8,0x00,0xF8,0xFF,
+	0x18,0x00,0x00,0xFF,0xF8,0x00,0xF8,0xFF,0x88,0x00,0x7C,0xFF,0x00,0x00,0x00,0x00,
+	0xF8,0x00,0xF8,0xFF,0x52,0xA7,0x52,0xFF,0xA5,0x53,0xA5,0xFF,0x00,0xFC,0x00,0xFF,
+	0x00,0x00,0x00,0x00,0x88,0x00,0x7C,0xFF,0xF8,0x00,0xF8,0xFF,0x18,0x00,0x00,0xFF,
+	0x00,0xFC,0x00,0xFF,0xF8,0x00,0xF8,0xFF,0x52,0xA7,0x52,0xFF,0xA5,0x53,0xA5,0xFF,
+	0xF8,0x00,0xF8,0xFF,0xF8,0x00,0xF8,0xFF,0x88,0x00,0x7C,0xFF,0x88,0x00,0x7C,0xFF,
+	0xF8,0x00,0xF8,0xFF,0x00,0xFC,0x00,0xFF,0xA5,0x53,0xA5,0xFF,0x52,0xA7,0x52,0xFF,
+	0x18,0x00,0x00,0xFF,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x18,0x00,0x00,0xFF
+};
+
+static const byte kDXT1Decompressed2x2[] = {
+	0xA5,0x53,0xA5,0xFF,0x52,0xA7,0x52,0xFF,0xF8,0x00,0xF8,0xFF,0x00,0xFC,0x00,0xFF
+};
+
+static const byte kDXT3Decompressed4x4[] = {
+	0x77,0x3C,0x7D,0xC0,0x90,0x38,0x40,0xD0,0x5F,0x40,0xBA,0xE0,0x48,0x44,0xF8,0xF0,
+	0x90,0x38,0x40,0x80,0x77,0x3C,0x7D,0x90,0x48,0x44,0xF8,0xA0,0x5F,0x40,0xBA,0xB0,
+	0x5F,0x40,0xBA,0x40,0x77,0x3C,0x7D,0x50,0x90,0x38,0x40,0x60,0x48,0x44,0xF8,0x70,
+	0x77,0x3C,0x7D,0x00,0x48,0x44,0xF8,0x10,0x5F,0x40,0xBA,0x20,0x90,0x38,0x40,0x30
+};
+
+static const byte kDXT5Decompressed4x8[] = {
+	0x77,0x3C,0x7D,0xF0,0x90,0x38,0x40,0x10,0x5F,0x40,0xBA,0xD0,0x48,0x44,0xF8,0xB0,
+	0x90,0x38,0x40,0x90,0x77,0x3C,0x7D,0x70,0x48,0x44,0xF8,0x50,0x5F,0x40,0xBA,0x30,
+	0x5F,0x40,0xBA,0x70,0x77,0x3C,0x7D,0xF0,0x90,0x38,0x40,0x90,0x48,0x44,0xF8,0x90,
+	0x77,0x3C,0x7D,0xB0,0x48,0x44,0xF8,0x50,0x5F,0x40,0xBA,0x70,0x90,0x38,0x40,0xB0,
+	0x78,0x3B,0x7D,0xC0,0x90,0x38,0x40,0x40,0x60,0x3F,0xBA,0x20,0x48,0x44,0xF8,0xC0,
+	0x90,0x38,0x40,0xC0,0x78,0x3B,0x7D,0xC0,0x48,0x44,0xF8,0xC0,0x60,0x3F,0xBA,0xC0,
+	0x48,0x44,0xF8,0xC0,0x90,0x38,0x40,0xC0,0x78,0x3B,0x7D,0xC0,0x60,0x3F,0xBA,0x60,
+	0x78,0x3B,0x7D,0x60,0x48,0x44,0xF8,0x60,0x60,0x3F,0xBA,0x60,0x90,0x38,0x40,0x60
+};
+
+static void compareData(const byte *data1, const byte *data2, size_t n) {
+	for (size_t i = 0; i < n; i++)
+		EXPECT_EQ(data1[i], data2[i]) << "At index " << i;
+}
+
+GTEST_TEST(S3TC, decompressDXT1) {
+	byte data[sizeof(kDXT1Decompressed8x4)];
+
+	Images::decompressDXT1(data, kDXT1Compressed, sizeof(kDXT1Compressed), 8, 4, 8 * 4);
+	compareData(data, kDXT1Decompressed8x4, sizeof(data));
+}
+
+GTEST_TEST(S3TC, decompressDXT1Small) {
+	byte data[sizeof(kDXT1Decompressed2x2)];
+
+	Images::decompressDXT1(data, kDXT1Compressed, 8, 2, 2, 2 * 4);
+	compareData(data, kDXT1Decompressed2x2, sizeof(data));
+}
+
+GTEST_TEST(S3TC, decompressDXT3) {
+	byte data[sizeof(kDXT3Decompressed4x4)];
+
+	Images::decompressDXT3(data, kDXT3Compressed, sizeof(kDXT3Compressed), 4, 4, 4 * 4);
+	compareData(data, kDXT3Decompressed4x4, sizeof(data));
+}
+
+GTEST_TEST(S3TC, decompressDXT5) {
+	byte data[sizeof(kDXT5Decompressed4x8)];
+
+	Images::decompressDXT5(data, kDXT5Compressed, sizeof(kDXT5Compressed), 4, 8, 4 * 4);
+	compareData(data, kDXT5Decompressed4x8, sizeof(data));
+}
+
+GTEST_TEST(S3TC, decompressPitch) {
+	// Decompress into a wider buffer, leaving the rest of each line alone
+	byte data[4 * 24];
+	std::memset(data, 0xCD, sizeof(data));
+
+	Images::decompressDXT3(data, kDXT3Compressed, sizeof(kDXT3Compressed), 4, 4, 24);
+
+	for (size_t y = 0; y < 4; y++) {
+		compareData(data + y * 24, kDXT3Decompressed4x4 + y * 16, 16);
+
+		for (size_t x = 16; x < 24; x++)
+			EXPECT_EQ(data[y * 24 + x], 0xCD) << "At " << x << "x" << y;
+	}
+}
+
+GTEST_TEST(S3TC, decompressTooShort) {
+	byte data[sizeof(kDXT5Decompressed4x8)];
+
+	EXPECT_THROW(Images::decompressDXT1(data, kDXT1Compressed, 15, 8, 4, 8 * 4), Common::Exception);
+	EXPECT_THROW(Images::decompressDXT5(data, kDXT5Compressed, 16, 4, 8, 4 * 4), Common::Exception);
+}